@@ -35,6 +35,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <dlfcn.h>
 
 
@@ -44,8 +45,9 @@ int usage_c_known_signature(){
   printf("Usage from C with known signature.\n");
   printf("\n");
 
-  /* Signature of the entry point */
-  typedef void (*evaluatePtr)(const double* x0, const double* x1, double* r0, double* r1);
+  /* Signature of the entry point, the work vectors are passed last */
+  typedef void (*evaluatePtr)(const double* x0, const double* x1, double* r0, double* r1, int* iw, double* w);
+  typedef int (*workSizePtr)(int *sz_iw, int *sz_w);
   
   /* Handle to the dll */
   void* handle;
@@ -67,12 +69,29 @@ int usage_c_known_signature(){
     return 1;
   }
   
+  /* Get a pointer to the function returning the length of the work vectors */
+  workSizePtr work_size = (workSizePtr)dlsym(handle, "work_size");
+  if(dlerror()){
+    printf("Failed to retrieve \"work_size\" function.\n");
+    return 1;
+  }
+
+  /* Allocate work vectors, each thread calling the function needs its own */
+  int sz_iw, sz_w;
+  work_size(&sz_iw, &sz_w);
+  int* iw = (int*)malloc(sz_iw*sizeof(int));
+  double* w = (double*)malloc(sz_w*sizeof(double));
+
   /* Evaluate the function */
   const double x_val[] = {1,2,3,4};
   const double y_val = 5;
   double res0;
   double res1[4];
-  evaluate(x_val, &y_val, &res0, res1);
+  evaluate(x_val, &y_val, &res0, res1, iw, w);
+
+  /* Free the work vectors */
+  free(iw);
+  free(w);
   
   printf("result (0): %g\n",res0);
   printf("result (1): [%g,%g;%g,%g]\n",res1[0],res1[1],res1[2],res1[3]);
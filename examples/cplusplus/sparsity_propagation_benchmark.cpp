@@ -0,0 +1,138 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** \brief Benchmark of the Jacobian sparsity detection (FX::jacSparsity)
+ * Detects the sparsity of the Jacobian of a large random expression graph and of the continuity
+ * constraints of a multiple shooting discretization of the Van der Pol oscillator, using the default
+ * sparsity propagation and wide bitsets ("sparsity_bitset_width" option), optionally spread over
+ * several threads ("sparsity_num_threads" option), and compares the timings.
+ */
+
+#include "symbolic/casadi.hpp"
+#include <cstdlib>
+#ifndef _WIN32
+#include <sys/time.h>
+#else // _WIN32
+#include <ctime>
+#endif // _WIN32
+
+using namespace CasADi;
+using namespace std;
+
+// Wall clock time in seconds
+double wall_time(){
+#ifndef _WIN32
+  timeval t;
+  gettimeofday(&t,0);
+  return t.tv_sec + 1e-6*t.tv_usec;
+#else // _WIN32
+  return double(clock())/CLOCKS_PER_SEC;
+#endif // _WIN32
+}
+
+// Right hand side of the Van der Pol oscillator
+SXMatrix vdp(const SXMatrix& x, const SX& u){
+  SXMatrix xdot = SXMatrix::zeros(2,1);
+  xdot[0] = (1 - x[1]*x[1])*x[0] - x[1] + u;
+  xdot[1] = x[0];
+  return xdot;
+}
+
+// Random expression graph: each output combines a few random inputs and earlier intermediate expressions
+SXFunction random_graph(int n){
+  SXMatrix x = ssym("x",n);
+  vector<SX> v(x.data().begin(),x.data().end());
+  SXMatrix f = SXMatrix::zeros(n,1);
+  srand(1);
+  for(int i=0; i<n; ++i){
+    SX e = v[rand()%v.size()];
+    for(int j=0; j<3; ++j){
+      e = sin(e)*v[rand()%v.size()];
+    }
+    v.push_back(e);
+    f[i] = e;
+  }
+  return SXFunction(x,f);
+}
+
+// Continuity constraints of a multiple shooting discretization, RK4 steps
+SXFunction ocp_graph(int nk){
+  int nj = 4;
+  double h = 10.0/(nk*nj);
+  SXMatrix V = ssym("V",3*nk+2);
+  SXMatrix g = SXMatrix::zeros(2*nk,1);
+  for(int k=0; k<nk; ++k){
+    SXMatrix xk = V(range(3*k,3*k+2));
+    SX uk = V.at(3*k+2);
+    for(int j=0; j<nj; ++j){
+      SXMatrix k1 = vdp(xk,uk);
+      SXMatrix k2 = vdp(xk + h/2*k1,uk);
+      SXMatrix k3 = vdp(xk + h/2*k2,uk);
+      SXMatrix k4 = vdp(xk + h*k3,uk);
+      xk += h/6*(k1 + 2*k2 + 2*k3 + k4);
+    }
+    SXMatrix gk = xk - V(range(3*k+3,3*k+5));
+    g[2*k] = gk[0];
+    g[2*k+1] = gk[1];
+  }
+  return SXFunction(V,g);
+}
+
+// Detect the Jacobian sparsity with given settings, print the timing and compare with a reference
+void benchmark(SXFunction f, const string& name, int width, int num_threads, CRSSparsity& sp_ref){
+  SXFunction fcn(f.inputExpr(),f.outputExpr());
+  if(width>0) fcn.setOption("sparsity_bitset_width",width);
+  fcn.setOption("sparsity_num_threads",num_threads);
+  fcn.init();
+  double t0 = wall_time();
+  CRSSparsity sp = fcn.jacSparsity();
+  double t1 = wall_time();
+  cout << name << ": " << (t1-t0)*1000 << " ms" << endl;
+  if(sp_ref.isNull()){
+    sp_ref = sp;
+  } else {
+    casadi_assert(sp==sp_ref);
+  }
+}
+
+int main(int argc, char* argv[]){
+  // Problem size and number of threads
+  int n = argc>1 ? atoi(argv[1]) : 20000;
+  int num_threads = argc>2 ? atoi(argv[2]) : 0;
+  
+  for(int p=0; p<2; ++p){
+    SXFunction f = p==0 ? random_graph(n) : ocp_graph(n/3);
+    f.init();
+    cout << (p==0 ? "Random graph: " : "Multiple shooting: ") << f.input().size() << " inputs, " << f.output().size() << " outputs, ";
+    cout << f.getAlgorithmSize() << " elementary operations" << endl;
+    
+    CRSSparsity sp_ref;
+    benchmark(f,"default",0,1,sp_ref);
+    benchmark(f,"64 bits",bvec_size,0,sp_ref);
+    benchmark(f,"256 bits",256,1,sp_ref);
+    benchmark(f,"512 bits",512,1,sp_ref);
+    benchmark(f,"512 bits, threads",512,num_threads,sp_ref);
+    cout << "Jacobian: " << sp_ref.size() << " nonzeros" << endl;
+  }
+  
+  return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** \brief Micro-benchmark of the SXFunction interpreters
+ * Evaluates the Hessian of the Lagrangian of a multiple shooting discretization of
+ * the Van der Pol oscillator (RK4 integrator steps) with the switch-based interpreter
+ * and with the threaded interpreter ("evaluation_engine" option), just-in-time compiled ("just_in_time"
+ * option) as well as batched over multiple
+ * points (SXFunction::evaluateBatch) and compares the timings.
+ */
+
+#include "symbolic/casadi.hpp"
+#include <ctime>
+#include <cstdlib>
+
+using namespace CasADi;
+using namespace std;
+
+// Right hand side of the Van der Pol oscillator
+SXMatrix vdp(const SXMatrix& x, const SX& u){
+  SXMatrix xdot = SXMatrix::zeros(2,1);
+  xdot[0] = (1 - x[1]*x[1])*x[0] - x[1] + u;
+  xdot[1] = x[0];
+  return xdot;
+}
+
+int main(int argc, char* argv[]){
+  // Number of shooting intervals, integrator steps per interval and evaluations
+  int nk = argc>1 ? atoi(argv[1]) : 100;
+  int nj = 4;
+  int n_eval = argc>2 ? atoi(argv[2]) : 100;
+  double h = 10.0/(nk*nj);
+
+  // Decision variables and multipliers for the continuity constraints
+  SXMatrix V = ssym("V",3*nk+2);
+  SXMatrix lam = ssym("lam",2*nk);
+
+  // Lagrangian
+  SX L = 0;
+  for(int k=0; k<nk; ++k){
+    SXMatrix xk = V(range(3*k,3*k+2));
+    SX uk = V.at(3*k+2);
+    L += uk*uk;
+
+    // Integrate over the interval
+    for(int j=0; j<nj; ++j){
+      SXMatrix k1 = vdp(xk,uk);
+      SXMatrix k2 = vdp(xk + h/2*k1,uk);
+      SXMatrix k3 = vdp(xk + h/2*k2,uk);
+      SXMatrix k4 = vdp(xk + h*k3,uk);
+      xk += h/6*(k1 + 2*k2 + 2*k3 + k4);
+    }
+    
+    // Continuity constraint
+    SXMatrix gk = xk - V(range(3*k+3,3*k+5));
+    SXMatrix lamk = lam(range(2*k,2*k+2));
+    L += inner_prod(lamk,gk).at(0);
+  }
+
+  // Hessian of the Lagrangian
+  vector<SXMatrix> lfcn_in(2);
+  lfcn_in[0] = V;
+  lfcn_in[1] = lam;
+  SXFunction lfcn(lfcn_in,L);
+  lfcn.init();
+  SXMatrix H = lfcn.hess(0,0);
+
+  // Evaluate with both interpreters and just-in-time compiled
+  const char* engines[] = {"switch","threaded","just-in-time"};
+  vector<double> H_ref;
+  for(int e=0; e<3; ++e){
+    SXFunction hfcn(lfcn_in,H);
+    if(e==2){
+      hfcn.setOption("just_in_time",true);
+    } else {
+      hfcn.setOption("evaluation_engine",engines[e]);
+    }
+    hfcn.init();
+    if(e==0) cout << "Hessian of the Lagrangian: " << hfcn.getAlgorithmSize() << " elementary operations" << endl;
+
+    // Pass some inputs
+    for(int i=0; i<hfcn.input(0).size(); ++i) hfcn.input(0).at(i) = 0.1*(i%7);
+    for(int i=0; i<hfcn.input(1).size(); ++i) hfcn.input(1).at(i) = 1.0 - 0.05*(i%5);
+
+    // Evaluate repeatedly
+    clock_t time1 = clock();
+    for(int i=0; i<n_eval; ++i) hfcn.evaluate();
+    clock_t time2 = clock();
+    double t = double(time2 - time1)/CLOCKS_PER_SEC*1000/n_eval;
+    cout << engines[e] << ": " << t << " ms per evaluation" << endl;
+
+    // Make sure that the results agree
+    if(e==0){
+      H_ref = hfcn.output().data();
+    } else {
+      double max_diff = 0;
+      for(int i=0; i<H_ref.size(); ++i) max_diff = std::max(max_diff,fabs(H_ref[i]-hfcn.output().at(i)));
+      cout << "maximum difference: " << max_diff << endl;
+      casadi_assert(max_diff<1e-10);
+    }
+  }
+
+  // Batched evaluation, the same inputs at all points
+  int npoints = 256;
+  SXFunction hfcn(lfcn_in,H);
+  hfcn.init();
+  vector<vector<double> > arg_batch(2), res_batch(1);
+  for(int ind=0; ind<2; ++ind){
+    int nnz = hfcn.input(ind).size();
+    arg_batch[ind].resize(nnz*npoints);
+    for(int i=0; i<nnz; ++i){
+      double v = ind==0 ? 0.1*(i%7) : 1.0 - 0.05*(i%5);
+      fill_n(arg_batch[ind].begin()+i*npoints,npoints,v);
+    }
+  }
+  res_batch[0].resize(hfcn.output().size()*npoints);
+  vector<const double*> arg(2);
+  arg[0] = getPtr(arg_batch[0]);
+  arg[1] = getPtr(arg_batch[1]);
+  vector<double*> res(1,getPtr(res_batch[0]));
+  
+  clock_t time1 = clock();
+  for(int i=0; i<n_eval; i+=npoints) hfcn.evaluateBatch(npoints,arg,res);
+  clock_t time2 = clock();
+  int n_batch = (n_eval+npoints-1)/npoints;
+  double t = double(time2 - time1)/CLOCKS_PER_SEC*1000/(n_batch*npoints);
+  cout << "batched (" << npoints << " points): " << t << " ms per evaluation" << endl;
+
+  // Make sure that the results agree
+  double max_diff = 0;
+  for(int i=0; i<H_ref.size(); ++i){
+    for(int j=0; j<npoints; ++j){
+      max_diff = std::max(max_diff,fabs(H_ref[i]-res_batch[0][i*npoints+j]));
+    }
+  }
+  cout << "maximum difference: " << max_diff << endl;
+  casadi_assert(max_diff<1e-10);
+  
+  return 0;
+}
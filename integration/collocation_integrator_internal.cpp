@@ -44,6 +44,7 @@ namespace CasADi{
     addOption("quadrature_solver_options",     OT_DICTIONARY, GenericType(), "Options to be passed to the quadrature solver");
     addOption("startup_integrator",            OT_INTEGRATOR,  GenericType(), "An ODE/DAE integrator that can be used to generate a startup trajectory");
     addOption("startup_integrator_options",    OT_DICTIONARY, GenericType(), "Options to be passed to the startup integrator");
+    addOption("element_wise",                  OT_BOOLEAN,  false, "Solve the collocation equations finite element by finite element instead of as one large system");
     setOption("name","unnamed_collocation_integrator");
   }
 
@@ -52,6 +53,9 @@ namespace CasADi{
     startup_integrator_ = deepcopy(startup_integrator_,already_copied);
     implicit_solver_ = deepcopy(implicit_solver_,already_copied);
     explicit_fcn_ = deepcopy(explicit_fcn_,already_copied);
+    implicit_solverB_ = deepcopy(implicit_solverB_,already_copied);
+    elem_fcn_ = deepcopy(elem_fcn_,already_copied);
+    elem_fcnB_ = deepcopy(elem_fcnB_,already_copied);
   }
 
   CollocationIntegratorInternal::~CollocationIntegratorInternal(){
@@ -68,8 +72,12 @@ namespace CasADi{
     // Hotstart?
     hotstart_ = getOption("hotstart");
   
+    // Solve element by element?
+    element_wise_ = getOption("element_wise");
+  
     // Number of finite elements
     int nk = getOption("number_of_finite_elements");
+    nk_ = nk;
   
     // Interpolation order
     int deg = getOption("interpolation_order");
@@ -137,239 +145,244 @@ namespace CasADi{
     casadi_assert_message(fabs(sumAll(Q)-1)<1e-9,"Check on quadrature coefficients");
     casadi_assert_message(fabs(sumAll(D_num)-1)<1e-9,"Check on collocation coefficients");
   
-    // Initial state
-    MX X0("X0",nx_);
-  
-    // Parameters
-    MX P("P",np_);
-  
-    // Backward state
-    MX RX0("RX0",nrx_);
-  
-    // Backward parameters
-    MX RP("RP",nrp_);
-  
-    // Collocated differential states and algebraic variables
-    int nX = (nk*(deg+1)+1)*(nx_+nrx_);
-    int nZ = nk*deg*(nz_+nrz_);
-  
-    // Unknowns
-    MX V("V",nX+nZ);
-    int offset = 0;
-  
-    // Get collocated states, algebraic variables and times
-    vector<vector<MX> > X(nk+1);
-    vector<vector<MX> > RX(nk+1);
-    vector<vector<MX> > Z(nk);
-    vector<vector<MX> > RZ(nk);
-    coll_time_.resize(nk+1);
-    for(int k=0; k<nk+1; ++k){
-      // Number of time points
-      int nj = k==nk ? 1 : deg+1;
-    
-      // Allocate differential states expressions at the time points
-      X[k].resize(nj);
-      RX[k].resize(nj);
-      coll_time_[k].resize(nj);
+    if(element_wise_){
+      // Functions of a single finite element
+      initElements(tau_root,C,D,Q,h);
+    } else {
+      // Initial state
+      MX X0("X0",nx_);
+  
+      // Parameters
+      MX P("P",np_);
+  
+      // Backward state
+      MX RX0("RX0",nrx_);
+  
+      // Backward parameters
+      MX RP("RP",nrp_);
+  
+      // Collocated differential states and algebraic variables
+      int nX = (nk*(deg+1)+1)*(nx_+nrx_);
+      int nZ = nk*deg*(nz_+nrz_);
+  
+      // Unknowns
+      MX V("V",nX+nZ);
+      int offset = 0;
+  
+      // Get collocated states, algebraic variables and times
+      vector<vector<MX> > X(nk+1);
+      vector<vector<MX> > RX(nk+1);
+      vector<vector<MX> > Z(nk);
+      vector<vector<MX> > RZ(nk);
+      coll_time_.resize(nk+1);
+      for(int k=0; k<nk+1; ++k){
+        // Number of time points
+        int nj = k==nk ? 1 : deg+1;
+    
+        // Allocate differential states expressions at the time points
+        X[k].resize(nj);
+        RX[k].resize(nj);
+        coll_time_[k].resize(nj);
 
-      // Allocate algebraic variable expressions at the collocation points
-      if(k!=nk){
-        Z[k].resize(nj-1);
-        RZ[k].resize(nj-1);
-      }
+        // Allocate algebraic variable expressions at the collocation points
+        if(k!=nk){
+          Z[k].resize(nj-1);
+          RZ[k].resize(nj-1);
+        }
 
-      // For all time points
-      for(int j=0; j<nj; ++j){
-        // Get expressions for the differential state
-        X[k][j] = V[range(offset,offset+nx_)];
-        offset += nx_;
-        RX[k][j] = V[range(offset,offset+nrx_)];
-        offset += nrx_;
+        // For all time points
+        for(int j=0; j<nj; ++j){
+          // Get expressions for the differential state
+          X[k][j] = V[range(offset,offset+nx_)];
+          offset += nx_;
+          RX[k][j] = V[range(offset,offset+nrx_)];
+          offset += nrx_;
       
-        // Get the local time
-        coll_time_[k][j] = t0_ + h*(k + tau_root[j]);
+          // Get the local time
+          coll_time_[k][j] = t0_ + h*(k + tau_root[j]);
       
-        // Get expressions for the algebraic variables
-        if(j>0){
-          Z[k][j-1] = V[range(offset,offset+nz_)];
-          offset += nz_;
-          RZ[k][j-1] = V[range(offset,offset+nrz_)];
-          offset += nrz_;
+          // Get expressions for the algebraic variables
+          if(j>0){
+            Z[k][j-1] = V[range(offset,offset+nz_)];
+            offset += nz_;
+            RZ[k][j-1] = V[range(offset,offset+nrz_)];
+            offset += nrz_;
+          }
         }
       }
-    }
   
-    // Check offset for consistency
-    casadi_assert(offset==V.size());
+      // Check offset for consistency
+      casadi_assert(offset==V.size());
 
-    // Constraints
-    vector<MX> g;
-    g.reserve(2*(nk+1));
+      // Constraints
+      vector<MX> g;
+      g.reserve(2*(nk+1));
   
-    // Quadrature expressions
-    MX QF = MX::zeros(nq_);
-    MX RQF = MX::zeros(nrq_);
+      // Quadrature expressions
+      MX QF = MX::zeros(nq_);
+      MX RQF = MX::zeros(nrq_);
   
-    // Counter
-    int jk = 0;
+      // Counter
+      int jk = 0;
   
-    // Add initial condition
-    g.push_back(X[0][0]-X0);
+      // Add initial condition
+      g.push_back(X[0][0]-X0);
   
-    // For all finite elements
-    for(int k=0; k<nk; ++k, ++jk){
+      // For all finite elements
+      for(int k=0; k<nk; ++k, ++jk){
   
-      // For all collocation points
-      for(int j=1; j<deg+1; ++j, ++jk){
-        // Get the time
-        MX tkj = coll_time_[k][j];
+        // For all collocation points
+        for(int j=1; j<deg+1; ++j, ++jk){
+          // Get the time
+          MX tkj = coll_time_[k][j];
       
-        // Get an expression for the state derivative at the collocation point
-        MX xp_jk = 0;
-        for(int j2=0; j2<deg+1; ++j2){
-          xp_jk += C[j2][j]*X[k][j2];
-        }
+          // Get an expression for the state derivative at the collocation point
+          MX xp_jk = 0;
+          for(int j2=0; j2<deg+1; ++j2){
+            xp_jk += C[j2][j]*X[k][j2];
+          }
       
-        // Add collocation equations to the NLP
-        vector<MX> f_in(DAE_NUM_IN);
-        f_in[DAE_T] = tkj;
-        f_in[DAE_P] = P;
-        f_in[DAE_X] = X[k][j];
-        f_in[DAE_Z] = Z[k][j-1];
+          // Add collocation equations to the NLP
+          vector<MX> f_in(DAE_NUM_IN);
+          f_in[DAE_T] = tkj;
+          f_in[DAE_P] = P;
+          f_in[DAE_X] = X[k][j];
+          f_in[DAE_Z] = Z[k][j-1];
       
-        vector<MX> f_out;
-        f_out = f_.call(f_in);
-        g.push_back(h_mx*f_out[DAE_ODE] - xp_jk);
+          vector<MX> f_out;
+          f_out = f_.call(f_in);
+          g.push_back(h_mx*f_out[DAE_ODE] - xp_jk);
       
-        // Add the algebraic conditions
-        if(nz_>0){
-          g.push_back(f_out[DAE_ALG]);
-        }
+          // Add the algebraic conditions
+          if(nz_>0){
+            g.push_back(f_out[DAE_ALG]);
+          }
       
-        // Add the quadrature
-        if(nq_>0){
-          QF += Q[j]*h_mx*f_out[DAE_QUAD];
-        }
+          // Add the quadrature
+          if(nq_>0){
+            QF += Q[j]*h_mx*f_out[DAE_QUAD];
+          }
       
-        // Now for the backward problem
-        if(nrx_>0){
+          // Now for the backward problem
+          if(nrx_>0){
         
-          // Get an expression for the state derivative at the collocation point
-          MX rxp_jk = 0;
-          for(int j2=0; j2<deg+1; ++j2){
-            rxp_jk += C[j2][j]*RX[k][j2];
-          }
+            // Get an expression for the state derivative at the collocation point
+            MX rxp_jk = 0;
+            for(int j2=0; j2<deg+1; ++j2){
+              rxp_jk += C[j2][j]*RX[k][j2];
+            }
         
-          // Add collocation equations to the NLP
-          vector<MX> g_in(RDAE_NUM_IN);
-          g_in[RDAE_T] = tkj;
-          g_in[RDAE_X] = X[k][j];
-          g_in[RDAE_Z] = Z[k][j-1];
-          g_in[RDAE_P] = P;
-          g_in[RDAE_RP] = RP;
-          g_in[RDAE_RX] = RX[k][j];
-          g_in[RDAE_RZ] = RZ[k][j-1];
+            // Add collocation equations to the NLP
+            vector<MX> g_in(RDAE_NUM_IN);
+            g_in[RDAE_T] = tkj;
+            g_in[RDAE_X] = X[k][j];
+            g_in[RDAE_Z] = Z[k][j-1];
+            g_in[RDAE_P] = P;
+            g_in[RDAE_RP] = RP;
+            g_in[RDAE_RX] = RX[k][j];
+            g_in[RDAE_RZ] = RZ[k][j-1];
         
-          vector<MX> g_out;
-          g_out = g_.call(g_in);
-          g.push_back(h_mx*g_out[RDAE_ODE] + rxp_jk);
+            vector<MX> g_out;
+            g_out = g_.call(g_in);
+            g.push_back(h_mx*g_out[RDAE_ODE] + rxp_jk);
         
-          // Add the algebraic conditions
-          if(nrz_>0){
-            g.push_back(g_out[RDAE_ALG]);
-          }
+            // Add the algebraic conditions
+            if(nrz_>0){
+              g.push_back(g_out[RDAE_ALG]);
+            }
         
-          // Add the backward quadrature
-          if(nrq_>0){
-            RQF += Q[j]*h_mx*g_out[RDAE_QUAD];
+            // Add the backward quadrature
+            if(nrq_>0){
+              RQF += Q[j]*h_mx*g_out[RDAE_QUAD];
+            }
           }
         }
-      }
-    
-      // Get an expression for the state at the end of the finite element
-      MX xf_k = 0;
-      for(int j=0; j<deg+1; ++j){
-        xf_k += D[j]*X[k][j];
-      }
-
-      // Add continuity equation to NLP
-      g.push_back(X[k+1][0] - xf_k);
     
-      if(nrx_>0){
         // Get an expression for the state at the end of the finite element
-        MX rxf_k = 0;
+        MX xf_k = 0;
         for(int j=0; j<deg+1; ++j){
-          rxf_k += D[j]*RX[k][j];
+          xf_k += D[j]*X[k][j];
         }
 
         // Add continuity equation to NLP
-        g.push_back(RX[k+1][0] - rxf_k);
+        g.push_back(X[k+1][0] - xf_k);
+    
+        if(nrx_>0){
+          // Get an expression for the state at the end of the finite element
+          MX rxf_k = 0;
+          for(int j=0; j<deg+1; ++j){
+            rxf_k += D[j]*RX[k][j];
+          }
+
+          // Add continuity equation to NLP
+          g.push_back(RX[k+1][0] - rxf_k);
+        }
       }
-    }
   
-    // Add initial condition for the backward integration
-    if(nrx_>0){
-      g.push_back(RX[nk][0]-RX0);
-    }
+      // Add initial condition for the backward integration
+      if(nrx_>0){
+        g.push_back(RX[nk][0]-RX0);
+      }
   
-    // Constraint expression
-    MX gv = vertcat(g);
-    
-    // Make sure that the dimension is consistent with the number of unknowns
-    casadi_assert_message(gv.size()==V.size(),"Implicit function unknowns and equations do not match");
-
-    // Implicit function
-    vector<MX> ifcn_in(1+INTEGRATOR_NUM_IN);
-    ifcn_in[0] = V;
-    ifcn_in[1+INTEGRATOR_X0] = X0;
-    ifcn_in[1+INTEGRATOR_P] = P;
-    ifcn_in[1+INTEGRATOR_RX0] = RX0;
-    ifcn_in[1+INTEGRATOR_RP] = RP;
-    FX ifcn = MXFunction(ifcn_in,gv);
-    ifcn.init(); 
-    if(expand_f){
-      ifcn = SXFunction(shared_cast<MXFunction>(ifcn));
-      ifcn.init();
-    }
+      // Constraint expression
+      MX gv = vertcat(g);
+    
+      // Make sure that the dimension is consistent with the number of unknowns
+      casadi_assert_message(gv.size()==V.size(),"Implicit function unknowns and equations do not match");
+
+      // Implicit function
+      vector<MX> ifcn_in(1+INTEGRATOR_NUM_IN);
+      ifcn_in[0] = V;
+      ifcn_in[1+INTEGRATOR_X0] = X0;
+      ifcn_in[1+INTEGRATOR_P] = P;
+      ifcn_in[1+INTEGRATOR_RX0] = RX0;
+      ifcn_in[1+INTEGRATOR_RP] = RP;
+      FX ifcn = MXFunction(ifcn_in,gv);
+      ifcn.init(); 
+      if(expand_f){
+        ifcn = SXFunction(shared_cast<MXFunction>(ifcn));
+        ifcn.init();
+      }
   
-    // Auxiliary output function
-    vector<MX> afcn_out(1+INTEGRATOR_NUM_OUT);
-    afcn_out[0] = V;
-    afcn_out[1+INTEGRATOR_XF] = X[nk][0];
-    afcn_out[1+INTEGRATOR_QF] = QF;
-    afcn_out[1+INTEGRATOR_RXF] = RX[0][0];
-    afcn_out[1+INTEGRATOR_RQF] = RQF;
-    FX afcn = MXFunction(ifcn_in,afcn_out);
-    afcn.init();
-    if(expand_f){
-      afcn = SXFunction(shared_cast<MXFunction>(afcn));
+      // Auxiliary output function
+      vector<MX> afcn_out(1+INTEGRATOR_NUM_OUT);
+      afcn_out[0] = V;
+      afcn_out[1+INTEGRATOR_XF] = X[nk][0];
+      afcn_out[1+INTEGRATOR_QF] = QF;
+      afcn_out[1+INTEGRATOR_RXF] = RX[0][0];
+      afcn_out[1+INTEGRATOR_RQF] = RQF;
+      FX afcn = MXFunction(ifcn_in,afcn_out);
       afcn.init();
-    }
-  
-    // Get the NLP creator function
-    implicitFunctionCreator implicit_function_creator = getOption("implicit_solver");
+      if(expand_f){
+        afcn = SXFunction(shared_cast<MXFunction>(afcn));
+        afcn.init();
+      }
   
-    // Allocate an NLP solver
-    implicit_solver_ = implicit_function_creator(ifcn,FX(),LinearSolver());
+      // Get the NLP creator function
+      implicitFunctionCreator implicit_function_creator = getOption("implicit_solver");
   
-    // Pass options
-    if(hasSetOption("implicit_solver_options")){
-      const Dictionary& implicit_solver_options = getOption("implicit_solver_options");
-      implicit_solver_.setOption(implicit_solver_options);
-    }
+      // Allocate an NLP solver
+      implicit_solver_ = implicit_function_creator(ifcn,FX(),LinearSolver());
   
-    // Initialize the solver
-    implicit_solver_.init();
+      // Pass options
+      if(hasSetOption("implicit_solver_options")){
+        const Dictionary& implicit_solver_options = getOption("implicit_solver_options");
+        implicit_solver_.setOption(implicit_solver_options);
+      }
   
-    // Nonlinear constraint function input
-    vector<MX> gfcn_in(INTEGRATOR_NUM_IN);
-    gfcn_in[INTEGRATOR_X0] = X0;
-    gfcn_in[INTEGRATOR_P] = P;
-    gfcn_in[INTEGRATOR_RX0] = RX0;
-    gfcn_in[INTEGRATOR_RP] = RP;
-    ifcn_in[0] = implicit_solver_.call(gfcn_in).front();
-    explicit_fcn_ = MXFunction(gfcn_in,afcn.call(ifcn_in));
-    explicit_fcn_.init();
+      // Initialize the solver
+      implicit_solver_.init();
+  
+      // Nonlinear constraint function input
+      vector<MX> gfcn_in(INTEGRATOR_NUM_IN);
+      gfcn_in[INTEGRATOR_X0] = X0;
+      gfcn_in[INTEGRATOR_P] = P;
+      gfcn_in[INTEGRATOR_RX0] = RX0;
+      gfcn_in[INTEGRATOR_RP] = RP;
+      ifcn_in[0] = implicit_solver_.call(gfcn_in).front();
+      explicit_fcn_ = MXFunction(gfcn_in,afcn.call(ifcn_in));
+      explicit_fcn_.init();
+    }
   
     if(hasSetOption("startup_integrator")){
     
@@ -404,6 +417,17 @@ namespace CasADi{
     // Call the base class method
     IntegratorInternal::reset(nsens,nsensB,nsensB_store);
   
+    // Solve element by element, forward and then backward in time
+    if(element_wise_){
+      if(hotstart_==false || integrated_once_==false){
+        guessElements();
+      }
+      sweepForward(nsens);
+      sweepBackward(nsens);
+      integrated_once_ = true;
+      return;
+    }
+    
     // Pass the inputs
     for(int iind=0; iind<INTEGRATOR_NUM_IN; ++iind){
       explicit_fcn_.input(iind).set(input(iind));
@@ -492,6 +516,9 @@ namespace CasADi{
   }
 
   void CollocationIntegratorInternal::integrate(double t_out){
+    // Outputs already set when solving element by element
+    if(element_wise_) return;
+    
     for(int oind=0; oind<INTEGRATOR_NUM_OUT; ++oind){
       output(oind).set(explicit_fcn_.output(1+oind));
       for(int dir=0; dir<nsens_; ++dir){
@@ -503,4 +530,341 @@ namespace CasADi{
   void CollocationIntegratorInternal::integrateB(double t_out){
   }
 
+  void CollocationIntegratorInternal::initElements(const vector<double>& tau_root, const vector<vector<MX> >& C, const vector<MX>& D, const DMatrix& Q, double h){
+    // Interpolation order
+    int deg = tau_root.size()-1;
+  
+    // Collocated times
+    coll_time_.resize(nk_+1);
+    for(int k=0; k<nk_+1; ++k){
+      int nj = k==nk_ ? 1 : deg+1;
+      coll_time_[k].resize(nj);
+      for(int j=0; j<nj; ++j){
+        coll_time_[k][j] = t0_ + h*(k + tau_root[j]);
+      }
+    }
+  
+    // Unknowns of a finite element: the states at the collocation points and the algebraic variables
+    nv_ = deg*(nx_+nz_);
+    MX V("V",nv_);
+    vector<MX> X(deg+1), Z(deg);
+    int offset = 0;
+    for(int j=1; j<deg+1; ++j){
+      X[j] = V[range(offset,offset+nx_)];
+      offset += nx_;
+      Z[j-1] = V[range(offset,offset+nz_)];
+      offset += nz_;
+    }
+    
+    // Backward problem: the backward states at all time points of the finite element and the backward algebraic variables
+    nrv_ = (deg+1)*nrx_ + deg*nrz_;
+    MX RV("RV",nrv_);
+    vector<MX> RX(deg+1), RZ(deg);
+    offset = 0;
+    for(int j=0; j<deg+1; ++j){
+      RX[j] = RV[range(offset,offset+nrx_)];
+      offset += nrx_;
+      if(j>0){
+        RZ[j-1] = RV[range(offset,offset+nrz_)];
+        offset += nrz_;
+      }
+    }
+  
+    // State at the beginning, backward state at the end and start time of the finite element
+    MX X0("X0",nx_);
+    MX RX0("RX0",nrx_);
+    MX T("T");
+    X[0] = X0;
+    
+    // Parameters
+    MX P("P",np_);
+    MX RP("RP",nrp_);
+    
+    // Collocation equations and quadratures
+    MX h_mx = h;
+    vector<MX> g, rg;
+    MX QF = MX::zeros(nq_);
+    MX RQF = MX::zeros(nrq_);
+    for(int j=1; j<deg+1; ++j){
+      MX tkj = T + h*tau_root[j];
+    
+      // Forward problem
+      MX xp_j = 0;
+      for(int j2=0; j2<deg+1; ++j2){
+        xp_j += C[j2][j]*X[j2];
+      }
+      vector<MX> f_in(DAE_NUM_IN);
+      f_in[DAE_T] = tkj;
+      f_in[DAE_P] = P;
+      f_in[DAE_X] = X[j];
+      f_in[DAE_Z] = Z[j-1];
+      vector<MX> f_out = f_.call(f_in);
+      g.push_back(h_mx*f_out[DAE_ODE] - xp_j);
+      if(nz_>0){
+        g.push_back(f_out[DAE_ALG]);
+      }
+      if(nq_>0){
+        QF += Q.at(j)*h_mx*f_out[DAE_QUAD];
+      }
+    
+      // Backward problem
+      if(nrx_>0){
+        MX rxp_j = 0;
+        for(int j2=0; j2<deg+1; ++j2){
+          rxp_j += C[j2][j]*RX[j2];
+        }
+        vector<MX> g_in(RDAE_NUM_IN);
+        g_in[RDAE_T] = tkj;
+        g_in[RDAE_X] = X[j];
+        g_in[RDAE_Z] = Z[j-1];
+        g_in[RDAE_P] = P;
+        g_in[RDAE_RP] = RP;
+        g_in[RDAE_RX] = RX[j];
+        g_in[RDAE_RZ] = RZ[j-1];
+        vector<MX> g_out = g_.call(g_in);
+        rg.push_back(h_mx*g_out[RDAE_ODE] + rxp_j);
+        if(nrz_>0){
+          rg.push_back(g_out[RDAE_ALG]);
+        }
+        if(nrq_>0){
+          RQF += Q.at(j)*h_mx*g_out[RDAE_QUAD];
+        }
+      }
+    }
+  
+    // State at the end of the finite element
+    MX XF = 0;
+    for(int j=0; j<deg+1; ++j){
+      XF += D[j]*X[j];
+    }
+    
+    // Continuity of the backward state
+    if(nrx_>0){
+      MX rxf = 0;
+      for(int j=0; j<deg+1; ++j){
+        rxf += D[j]*RX[j];
+      }
+      rg.push_back(RX0 - rxf);
+    }
+    
+    // Residual and output functions of the forward problem
+    vector<MX> elem_in(ELEM_NUM_IN);
+    elem_in[ELEM_V] = V;
+    elem_in[ELEM_X0] = X0;
+    elem_in[ELEM_P] = P;
+    elem_in[ELEM_T] = T;
+    vector<MX> elem_out(ELEM_NUM_OUT);
+    elem_out[ELEM_XF] = XF;
+    elem_out[ELEM_QF] = QF;
+    FX ifcn = MXFunction(elem_in,vertcat(g));
+    elem_fcn_ = MXFunction(elem_in,elem_out);
+    
+    // Residual and output functions of the backward problem
+    vector<MX> elemB_in(ELEMB_NUM_IN);
+    elemB_in[ELEMB_RV] = RV;
+    elemB_in[ELEMB_V] = V;
+    elemB_in[ELEMB_RX0] = RX0;
+    elemB_in[ELEMB_P] = P;
+    elemB_in[ELEMB_RP] = RP;
+    elemB_in[ELEMB_T] = T;
+    vector<MX> elemB_out(ELEMB_NUM_OUT);
+    elemB_out[ELEMB_RXF] = RX[0];
+    elemB_out[ELEMB_RQF] = RQF;
+    FX rifcn = MXFunction(elemB_in,rg.empty() ? MX::zeros(0) : vertcat(rg));
+    elem_fcnB_ = MXFunction(elemB_in,elemB_out);
+    
+    // Expand to SX graphs
+    FX* fcns[] = {&ifcn, &elem_fcn_, &rifcn, &elem_fcnB_};
+    for(int i=0; i<4; ++i){
+      fcns[i]->init();
+      if(getOption("expand_f")){
+        *fcns[i] = SXFunction(shared_cast<MXFunction>(*fcns[i]));
+        fcns[i]->init();
+      }
+    }
+    
+    // Allocate the implicit function solvers, the same for the forward and the backward problem
+    implicitFunctionCreator implicit_function_creator = getOption("implicit_solver");
+    ImplicitFunction* solvers[] = {&implicit_solver_, &implicit_solverB_};
+    FX* residuals[] = {&ifcn, &rifcn};
+    for(int i=0; i<2; ++i){
+      if(i==1 && nrx_==0){
+        implicit_solverB_ = ImplicitFunction();
+        continue;
+      }
+      *solvers[i] = implicit_function_creator(*residuals[i],FX(),LinearSolver());
+      if(hasSetOption("implicit_solver_options")){
+        const Dictionary& implicit_solver_options = getOption("implicit_solver_options");
+        solvers[i]->setOption(implicit_solver_options);
+      }
+      solvers[i]->init();
+    }
+    
+    // Unknowns of all finite elements
+    elem_v_.resize(nk_*nv_);
+    elem_rv_.resize(nk_*nrv_);
+  }
+
+  void CollocationIntegratorInternal::guessElements(){
+    // Check if an integrator for the startup trajectory has been supplied
+    bool has_startup_integrator = !startup_integrator_.isNull();
+    
+    // Use supplied integrator, if any
+    if(has_startup_integrator){
+      for(int iind=0; iind<INTEGRATOR_NUM_IN; ++iind){
+        startup_integrator_.input(iind).set(input(iind));
+      }
+      startup_integrator_.reset();
+    }
+    
+    // Algebraic variables
+    vector<double> init_z(nz_,0);
+    if(has_startup_integrator && startup_integrator_.hasSetOption("init_z")){
+      init_z = startup_integrator_.getOption("init_z").toDoubleVector();
+    }
+    
+    // Integrate, stopping at all collocation points
+    vector<double>::iterator v = elem_v_.begin();
+    for(int k=0; k<nk_; ++k){
+      for(int j=1; j<coll_time_[k].size(); ++j){
+        if(has_startup_integrator){
+          startup_integrator_.integrate(coll_time_[k][j]);
+        }
+        const DMatrix& x = has_startup_integrator ? startup_integrator_.output(INTEGRATOR_XF) : input(INTEGRATOR_X0);
+        v = copy(x.begin(),x.end(),v);
+        v = copy(init_z.begin(),init_z.end(),v);
+      }
+    }
+    
+    // Backward states constant, backward algebraic variables zero
+    const DMatrix& rx = input(INTEGRATOR_RX0);
+    v = elem_rv_.begin();
+    for(int k=0; k<nk_; ++k){
+      for(int j=0; j<coll_time_[k].size(); ++j){
+        v = copy(rx.begin(),rx.end(),v);
+        if(j>0){
+          fill(v,v+nrz_,0.0);
+          v += nrz_;
+        }
+      }
+    }
+    
+    // Print
+    if(has_startup_integrator && verbose()){
+      cout << "startup trajectory generated, statistics:" << endl;
+      startup_integrator_.printStats();
+    }
+  }
+
+  void CollocationIntegratorInternal::sweepForward(int nsens){
+    // Make sure that enough directions are available
+    implicit_solver_.requestNumSens(nsens,0);
+    elem_fcn_.requestNumSens(nsens,0);
+    elem_fv_.resize(nk_*nsens*nv_);
+    
+    // State at the beginning of the interval
+    DMatrix& xf = output(INTEGRATOR_XF);
+    xf.set(input(INTEGRATOR_X0));
+    DMatrix& qf = output(INTEGRATOR_QF);
+    qf.setZero();
+    for(int dir=0; dir<nsens; ++dir){
+      fwdSens(INTEGRATOR_XF,dir).set(fwdSeed(INTEGRATOR_X0,dir));
+      fwdSens(INTEGRATOR_QF,dir).setZero();
+    }
+    
+    for(int k=0; k<nk_; ++k){
+      // Solve the collocation equations of the finite element, starting from the guess
+      double* v = getPtr(elem_v_)+k*nv_;
+      implicit_solver_.output().set(v);
+      implicit_solver_.input(ELEM_X0-1).set(xf);
+      implicit_solver_.input(ELEM_P-1).set(input(INTEGRATOR_P));
+      implicit_solver_.input(ELEM_T-1).set(coll_time_[k][0]);
+      for(int dir=0; dir<nsens; ++dir){
+        implicit_solver_.fwdSeed(ELEM_X0-1,dir).set(fwdSens(INTEGRATOR_XF,dir));
+        implicit_solver_.fwdSeed(ELEM_P-1,dir).set(fwdSeed(INTEGRATOR_P,dir));
+        implicit_solver_.fwdSeed(ELEM_T-1,dir).setZero();
+      }
+      implicit_solver_.evaluate(nsens,0);
+      implicit_solver_.output().get(v);
+      for(int dir=0; dir<nsens; ++dir){
+        implicit_solver_.fwdSens(0,dir).get(getPtr(elem_fv_)+(k*nsens+dir)*nv_);
+      }
+      
+      // State at the end of the finite element and quadratures
+      elem_fcn_.input(ELEM_V).set(v);
+      for(int iind=ELEM_X0; iind<ELEM_NUM_IN; ++iind){
+        elem_fcn_.input(iind).set(implicit_solver_.input(iind-1));
+      }
+      for(int dir=0; dir<nsens; ++dir){
+        elem_fcn_.fwdSeed(ELEM_V,dir).set(implicit_solver_.fwdSens(0,dir));
+        for(int iind=ELEM_X0; iind<ELEM_NUM_IN; ++iind){
+          elem_fcn_.fwdSeed(iind,dir).set(implicit_solver_.fwdSeed(iind-1,dir));
+        }
+      }
+      elem_fcn_.evaluate(nsens,0);
+      xf.set(elem_fcn_.output(ELEM_XF));
+      qf += elem_fcn_.output(ELEM_QF);
+      for(int dir=0; dir<nsens; ++dir){
+        fwdSens(INTEGRATOR_XF,dir).set(elem_fcn_.fwdSens(ELEM_XF,dir));
+        fwdSens(INTEGRATOR_QF,dir) += elem_fcn_.fwdSens(ELEM_QF,dir);
+      }
+    }
+  }
+
+  void CollocationIntegratorInternal::sweepBackward(int nsens){
+    // Backward state at the end of the interval
+    DMatrix& rxf = output(INTEGRATOR_RXF);
+    rxf.set(input(INTEGRATOR_RX0));
+    DMatrix& rqf = output(INTEGRATOR_RQF);
+    rqf.setZero();
+    for(int dir=0; dir<nsens; ++dir){
+      fwdSens(INTEGRATOR_RXF,dir).set(fwdSeed(INTEGRATOR_RX0,dir));
+      fwdSens(INTEGRATOR_RQF,dir).setZero();
+    }
+    if(nrx_==0) return;
+    
+    // Make sure that enough directions are available
+    implicit_solverB_.requestNumSens(nsens,0);
+    elem_fcnB_.requestNumSens(nsens,0);
+    
+    for(int k=nk_-1; k>=0; --k){
+      // Solve the collocation equations of the finite element, starting from the guess
+      double* rv = getPtr(elem_rv_)+k*nrv_;
+      implicit_solverB_.output().set(rv);
+      implicit_solverB_.input(ELEMB_V-1).set(getPtr(elem_v_)+k*nv_);
+      implicit_solverB_.input(ELEMB_RX0-1).set(rxf);
+      implicit_solverB_.input(ELEMB_P-1).set(input(INTEGRATOR_P));
+      implicit_solverB_.input(ELEMB_RP-1).set(input(INTEGRATOR_RP));
+      implicit_solverB_.input(ELEMB_T-1).set(coll_time_[k][0]);
+      for(int dir=0; dir<nsens; ++dir){
+        implicit_solverB_.fwdSeed(ELEMB_V-1,dir).set(getPtr(elem_fv_)+(k*nsens+dir)*nv_);
+        implicit_solverB_.fwdSeed(ELEMB_RX0-1,dir).set(fwdSens(INTEGRATOR_RXF,dir));
+        implicit_solverB_.fwdSeed(ELEMB_P-1,dir).set(fwdSeed(INTEGRATOR_P,dir));
+        implicit_solverB_.fwdSeed(ELEMB_RP-1,dir).set(fwdSeed(INTEGRATOR_RP,dir));
+        implicit_solverB_.fwdSeed(ELEMB_T-1,dir).setZero();
+      }
+      implicit_solverB_.evaluate(nsens,0);
+      implicit_solverB_.output().get(rv);
+      
+      // Backward state at the beginning of the finite element and quadratures
+      elem_fcnB_.input(ELEMB_RV).set(rv);
+      for(int iind=ELEMB_V; iind<ELEMB_NUM_IN; ++iind){
+        elem_fcnB_.input(iind).set(implicit_solverB_.input(iind-1));
+      }
+      for(int dir=0; dir<nsens; ++dir){
+        elem_fcnB_.fwdSeed(ELEMB_RV,dir).set(implicit_solverB_.fwdSens(0,dir));
+        for(int iind=ELEMB_V; iind<ELEMB_NUM_IN; ++iind){
+          elem_fcnB_.fwdSeed(iind,dir).set(implicit_solverB_.fwdSeed(iind-1,dir));
+        }
+      }
+      elem_fcnB_.evaluate(nsens,0);
+      rxf.set(elem_fcnB_.output(ELEMB_RXF));
+      rqf += elem_fcnB_.output(ELEMB_RQF);
+      for(int dir=0; dir<nsens; ++dir){
+        fwdSens(INTEGRATOR_RXF,dir).set(elem_fcnB_.fwdSens(ELEMB_RXF,dir));
+        fwdSens(INTEGRATOR_RQF,dir) += elem_fcnB_.fwdSens(ELEMB_RQF,dir);
+      }
+    }
+  }
+
 } // namespace CasADi
@@ -68,6 +68,26 @@ public:
   /// Integrate backwards in time until a specified time point
   virtual void integrateB(double t_out);
 
+  /// Create the functions of a single finite element, for solving element by element
+  void initElements(const std::vector<double>& tau_root, const std::vector<std::vector<MX> >& C, const std::vector<MX>& D, const DMatrix& Q, double h);
+
+  /// Initial guess for the unknowns of all finite elements
+  void guessElements();
+
+  /// Solve the forward problem element by element, with nsens forward sensitivities
+  void sweepForward(int nsens);
+
+  /// Solve the backward problem element by element, backwards in time, with nsens forward sensitivities
+  void sweepBackward(int nsens);
+
+  /// Inputs and outputs of the functions of a finite element, forward problem
+  enum ElemIn{ELEM_V, ELEM_X0, ELEM_P, ELEM_T, ELEM_NUM_IN};
+  enum ElemOut{ELEM_XF, ELEM_QF, ELEM_NUM_OUT};
+
+  /// Inputs and outputs of the functions of a finite element, backward problem
+  enum ElemBIn{ELEMB_RV, ELEMB_V, ELEMB_RX0, ELEMB_P, ELEMB_RP, ELEMB_T, ELEMB_NUM_IN};
+  enum ElemBOut{ELEMB_RXF, ELEMB_RQF, ELEMB_NUM_OUT};
+
   // Startup integrator (generates an initial trajectory guess)
   Integrator startup_integrator_;
   
@@ -77,6 +97,21 @@ public:
   // Explicit function
   FX explicit_fcn_;
 
+  // Solve the collocation equations finite element by finite element
+  bool element_wise_;
+  
+  // Number of finite elements and number of unknowns per finite element, forward and backward problem
+  int nk_, nv_, nrv_;
+  
+  // Implicit function solver for the backward problem of a finite element
+  ImplicitFunction implicit_solverB_;
+  
+  // State at the end and quadratures of a finite element, forward and backward problem
+  FX elem_fcn_, elem_fcnB_;
+  
+  // Unknowns of all finite elements, forward sensitivities of the forward problem unknowns
+  std::vector<double> elem_v_, elem_fv_, elem_rv_;
+
   // With hotstart
   bool hotstart_;
   
@@ -0,0 +1,81 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef EXPLICIT_RK_INTEGRATOR_HPP
+#define EXPLICIT_RK_INTEGRATOR_HPP
+
+#include "symbolic/fx/integrator.hpp"
+
+namespace CasADi{
+  
+class ExplicitRKIntegratorInternal;
+  
+/**
+  \brief Explicit Runge-Kutta integrator
+  ODE integrator stepping with explicit Runge-Kutta methods directly on the ODE right hand side,
+  without unrolling the steps into an expression graph:
+  the classical fixed step RK4 method or the adaptive Dormand-Prince 5(4) method with dense output.
+  
+  Forward sensitivities are propagated along with the states, all directions at once.
+  Adjoint sensitivities are those of the discretized ODE, calculated backwards step by step
+  from a bounded number of checkpoints (binomial checkpointing).
+  
+  Algebraic states and a backward problem are not supported. Derivatives of the integrator
+  (also in adjoint mode) are calculated from the native sensitivities instead.
+*/
+class ExplicitRKIntegrator : public Integrator {
+  public:
+    /** \brief  Default constructor */
+    ExplicitRKIntegrator();
+    
+    /** \brief  Create an integrator for explicit ODEs
+    *   \param f dynamical system
+    * \copydoc scheme_DAEInput
+    * \copydoc scheme_DAEOutput
+    *
+    */
+    explicit ExplicitRKIntegrator(const FX& f, const FX& g=FX());
+
+    /// Access functions of the node
+    ExplicitRKIntegratorInternal* operator->();
+    const ExplicitRKIntegratorInternal* operator->() const;
+
+    /// Check if the node is pointing to the right type of object
+    virtual bool checkNode() const;
+
+    /// Static creator function
+    #ifdef SWIG
+    %callback("%s_cb");
+    #endif
+    static Integrator creator(const FX& f, const FX& g){ return ExplicitRKIntegrator(f,g);}
+    #ifdef SWIG
+    %nocallback;
+    #endif
+
+    /// Get the static creator function
+    static integratorCreator getCreator(){return creator;}
+    
+};
+
+} // namespace CasADi
+
+#endif //EXPLICIT_RK_INTEGRATOR_HPP
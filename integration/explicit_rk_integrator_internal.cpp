@@ -0,0 +1,570 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "explicit_rk_integrator_internal.hpp"
+#include "symbolic/stl_vector_tools.hpp"
+#include "symbolic/fx/derivative.hpp"
+#include <cmath>
+
+using namespace std;
+namespace CasADi{
+
+ExplicitRKIntegratorInternal::ExplicitRKIntegratorInternal(const FX& f, const FX& g) : IntegratorInternal(f,g){
+  addOption("method",                        OT_STRING,   "dopri5", "Runge-Kutta method: classical RK4 with fixed steps or Dormand-Prince 5(4) with adaptive steps","rk4|dopri5");
+  addOption("number_of_finite_elements",     OT_INTEGER,  20,    "Number of steps of the fixed step method");
+  addOption("reltol",                        OT_REAL,     1e-6,  "Relative tolerence for the step size control");
+  addOption("abstol",                        OT_REAL,     1e-8,  "Absolute tolerence for the step size control");
+  addOption("quad_err_con",                  OT_BOOLEAN,  false, "Should the quadratures affect the step size control");
+  addOption("max_num_steps",                 OT_INTEGER,  10000, "Maximum number of integrator steps");
+  addOption("number_of_checkpoints",         OT_INTEGER,  20,    "Number of states stored for the adjoint sensitivities, the steps in between are recomputed");
+}
+
+ExplicitRKIntegratorInternal::~ExplicitRKIntegratorInternal(){
+}
+
+void ExplicitRKIntegratorInternal::init(){
+  // Call the base class init
+  IntegratorInternal::init();
+  casadi_assert_message(nz_==0, "Algebraic states not supported by an explicit integrator.");
+  casadi_assert_message(g_.isNull(), "Backward problem not supported, the adjoint sensitivities are calculated from the discretization.");
+  casadi_assert_message(tf_>t0_, "Integration horizon must be positive.");
+
+  // Butcher tableau
+  if(getOption("method")=="rk4"){
+    ns_ = 4;
+    double a[] = {1./2, 
+                  0, 1./2, 
+                  0, 0, 1};
+    double b[] = {1./6, 1./3, 1./3, 1./6};
+    double c[] = {0, 1./2, 1./2, 1};
+    a_ = vector<double>(a,a+ns_*(ns_-1)/2);
+    b_ = vector<double>(b,b+ns_);
+    c_ = vector<double>(c,c+ns_);
+    e_.clear();
+    d_.clear();
+    fsal_ = false;
+    adaptive_ = false;
+    int nk = getOption("number_of_finite_elements");
+    h_ = (tf_-t0_)/nk;
+  } else {
+    // Dormand-Prince 5(4), the last stage is evaluated at the new state
+    ns_ = 7;
+    double a[] = {1./5,
+                  3./40, 9./40,
+                  44./45, -56./15, 32./9,
+                  19372./6561, -25360./2187, 64448./6561, -212./729,
+                  9017./3168, -355./33, 46732./5247, 49./176, -5103./18656,
+                  35./384, 0, 500./1113, 125./192, -2187./6784, 11./84};
+    double b[] = {35./384, 0, 500./1113, 125./192, -2187./6784, 11./84, 0};
+    double c[] = {0, 1./5, 3./10, 4./5, 8./9, 1, 1};
+    double e[] = {71./57600, 0, -71./16695, 71./1920, -17253./339200, 22./525, -1./40};
+    
+    // Continuous extension (Hairer, Norsett & Wanner)
+    double d[] = {-12715105075./11282082432, 0, 87487479700./32700410799, -10690763975./1880347072, 
+                  701980252875./199316789632, -1453857185./822651844, 69997945./29380423};
+    a_ = vector<double>(a,a+ns_*(ns_-1)/2);
+    b_ = vector<double>(b,b+ns_);
+    c_ = vector<double>(c,c+ns_);
+    e_ = vector<double>(e,e+ns_);
+    d_ = vector<double>(d,d+ns_);
+    fsal_ = true;
+    adaptive_ = true;
+  }
+  
+  // Read options
+  abstol_ = getOption("abstol");
+  reltol_ = getOption("reltol");
+  quad_err_con_ = getOption("quad_err_con");
+  max_num_steps_ = getOption("max_num_steps");
+  nchk_ = getOption("number_of_checkpoints");
+  casadi_assert_message(nchk_>=0, "Number of checkpoints cannot be negative.");
+
+  // Allocate memory not depending on the number of sensitivities
+  x_.resize(nx_);
+  q_.resize(nq_);
+  x_old_.resize(nx_);
+  q_old_.resize(nq_);
+  k_.resize(ns_*nx_);
+  kq_.resize(ns_*nq_);
+  xs_.resize(ns_*nx_);
+  x_tmp_.resize(nx_);
+  chk_.resize((nchk_+1)*nx_);
+  
+  record_ = false;
+  t_ = t_old_ = t0_;
+  h_old_ = 0;
+}
+  
+void ExplicitRKIntegratorInternal::printStats(std::ostream &stream) const{
+  stream << "number of steps taken by ExplicitRKIntegrator: " << nsteps_ << std::endl; 
+  stream << "number of rejected steps: " << nrejected_ << std::endl; 
+  stream << "number of right hand side evaluations: " << nfevals_ << std::endl; 
+  stream << "number of steps recomputed for the adjoint sensitivities: " << nrecomputed_ << std::endl; 
+}
+
+void ExplicitRKIntegratorInternal::evaluate(int nfdir, int nadir){
+  // Integrate forward, recording the steps if adjoint sensitivities are requested
+  record_ = nadir>0;
+  reset(nfdir,0,0);
+  integrate(tf_);
+  record_ = false;
+  
+  if(nadir>0){
+    // All directions at once in the right hand side
+    f_.requestNumSens(0,nadir);
+
+    // Allocate memory
+    lam_x_.resize(nadir*nx_);
+    lam_q_.resize(nadir*nq_);
+    lam_p_.resize(nadir*np_);
+    lam_xs_.resize(ns_*nadir*nx_);
+    lam_k_.resize(nadir*nx_);
+    lam_kq_.resize(nadir*nq_);
+
+    // Adjoint seeds
+    for(int dir=0; dir<nadir; ++dir){
+      copy(adjSeed(INTEGRATOR_XF,dir).begin(),adjSeed(INTEGRATOR_XF,dir).end(),lam_x_.begin()+dir*nx_);
+      copy(adjSeed(INTEGRATOR_QF,dir).begin(),adjSeed(INTEGRATOR_QF,dir).end(),lam_q_.begin()+dir*nq_);
+    }
+    fill(lam_p_.begin(),lam_p_.end(),0.0);
+    
+    // Reverse the steps, recomputing from the checkpoints if not all steps have been stored
+    int nsteps = step_t_.size()-1;
+    if(nsteps-1 <= nchk_){
+      for(int k=nsteps-1; k>=0; --k){
+        adjointStep(k,getPtr(chk_)+k*nx_,nadir);
+      }
+    } else {
+      reverseSteps(0,nsteps,0,nchk_,nadir);
+    }
+    
+    // Get the adjoint sensitivities
+    for(int dir=0; dir<nadir; ++dir){
+      copy(lam_x_.begin()+dir*nx_,lam_x_.begin()+(dir+1)*nx_,adjSens(INTEGRATOR_X0,dir).begin());
+      copy(lam_p_.begin()+dir*np_,lam_p_.begin()+(dir+1)*np_,adjSens(INTEGRATOR_P,dir).begin());
+    }
+    stats_["nfevals"] = 1.0*nfevals_;
+    stats_["nrecomputed"] = 1.0*nrecomputed_;
+  }
+  
+  // Print statistics
+  if(getOption("print_stats")) printStats(std::cout);
+}
+
+void ExplicitRKIntegratorInternal::reset(int nsens, int nsensB, int nsensB_store){
+  // Call the base class method
+  IntegratorInternal::reset(nsens,nsensB,nsensB_store);
+  
+  // All directions at once in the right hand side
+  f_.requestNumSens(nsens,0);
+
+  // Allocate memory for the sensitivities, only grows
+  fx_.resize(nsens*nx_);
+  fq_.resize(nsens*nq_);
+  fx_old_.resize(nsens*nx_);
+  fq_old_.resize(nsens*nq_);
+  fk_.resize(ns_*nsens*nx_);
+  fkq_.resize(ns_*nsens*nq_);
+  fxs_.resize(ns_*nsens*nx_);
+
+  // Initial conditions
+  t_ = t_old_ = t0_;
+  copy(input(INTEGRATOR_X0).begin(),input(INTEGRATOR_X0).end(),x_.begin());
+  fill(q_.begin(),q_.end(),0.0);
+  for(int dir=0; dir<nsens; ++dir){
+    copy(fwdSeed(INTEGRATOR_X0,dir).begin(),fwdSeed(INTEGRATOR_X0,dir).end(),fx_.begin()+dir*nx_);
+  }
+  fill(fq_.begin(),fq_.end(),0.0);
+  fsal_valid_ = false;
+  
+  // Reset the statistics
+  nsteps_ = nrejected_ = nfevals_ = nrecomputed_ = 0;
+
+  // Initial step size of the adaptive method from the right hand side at the initial state
+  if(adaptive_){
+    copy(x_.begin(),x_.end(),xs_.begin()+(ns_-1)*nx_);
+    copy(fx_.begin(),fx_.begin()+nsens*nx_,fxs_.begin()+(ns_-1)*nsens*nx_);
+    evalRhs(ns_-1,t_,nsens);
+    fsal_valid_ = fsal_;
+    double d0=0, d1=0;
+    for(int i=0; i<nx_; ++i){
+      double sc = abstol_ + reltol_*fabs(x_[i]);
+      d0 += (x_[i]/sc)*(x_[i]/sc);
+      d1 += (k_[(ns_-1)*nx_+i]/sc)*(k_[(ns_-1)*nx_+i]/sc);
+    }
+    d0 = sqrt(d0/nx_);
+    d1 = sqrt(d1/nx_);
+    h_ = d0<1e-5 || d1<1e-5 ? 1e-6*(tf_-t0_) : 0.01*d0/d1;
+    h_ = std::min(h_,tf_-t0_);
+  }
+  
+  // Start recording the steps
+  step_t_.clear();
+  if(record_){
+    step_t_.push_back(t_);
+    copy(x_.begin(),x_.end(),chk_.begin());
+  }
+}
+
+void ExplicitRKIntegratorInternal::resetB(){
+}
+
+void ExplicitRKIntegratorInternal::evalRhs(int i, double t, int nsens){
+  // Pass the inputs
+  copy(xs_.begin()+i*nx_,xs_.begin()+(i+1)*nx_,f_.input(DAE_X).begin());
+  copy(input(INTEGRATOR_P).begin(),input(INTEGRATOR_P).end(),f_.input(DAE_P).begin());
+  vector<double>& t_in = f_.input(DAE_T).data();
+  fill(t_in.begin(),t_in.end(),t);
+
+  // Pass the forward seeds
+  for(int dir=0; dir<nsens; ++dir){
+    vector<double>::const_iterator fxs = fxs_.begin()+(i*nsens+dir)*nx_;
+    copy(fxs,fxs+nx_,f_.fwdSeed(DAE_X,dir).begin());
+    copy(fwdSeed(INTEGRATOR_P,dir).begin(),fwdSeed(INTEGRATOR_P,dir).end(),f_.fwdSeed(DAE_P,dir).begin());
+    f_.fwdSeed(DAE_T,dir).setZero();
+  }
+  
+  // Evaluate
+  f_.evaluate(nsens,0);
+  nfevals_++;
+  
+  // Get the right hand side and the quadratures
+  copy(f_.output(DAE_ODE).begin(),f_.output(DAE_ODE).end(),k_.begin()+i*nx_);
+  copy(f_.output(DAE_QUAD).begin(),f_.output(DAE_QUAD).end(),kq_.begin()+i*nq_);
+  for(int dir=0; dir<nsens; ++dir){
+    copy(f_.fwdSens(DAE_ODE,dir).begin(),f_.fwdSens(DAE_ODE,dir).end(),fk_.begin()+(i*nsens+dir)*nx_);
+    copy(f_.fwdSens(DAE_QUAD,dir).begin(),f_.fwdSens(DAE_QUAD,dir).end(),fkq_.begin()+(i*nsens+dir)*nq_);
+  }
+}
+
+void ExplicitRKIntegratorInternal::evalStages(double t, double h, const double* x, const double* fx, int nsens, bool first_stage_given){
+  for(int i=first_stage_given ? 1 : 0; i<ns_; ++i){
+    const double* a = getPtr(a_) + i*(i-1)/2;
+    
+    // State at the stage
+    double* xs = getPtr(xs_) + i*nx_;
+    copy(x,x+nx_,xs);
+    for(int j=0; j<i; ++j){
+      if(a[j]==0) continue;
+      double ha = h*a[j];
+      const double* k = getPtr(k_) + j*nx_;
+      for(int l=0; l<nx_; ++l) xs[l] += ha*k[l];
+    }
+    
+    // Forward sensitivities of the state at the stage
+    for(int dir=0; dir<nsens; ++dir){
+      double* fxs = getPtr(fxs_) + (i*nsens+dir)*nx_;
+      copy(fx+dir*nx_,fx+(dir+1)*nx_,fxs);
+      for(int j=0; j<i; ++j){
+        if(a[j]==0) continue;
+        double ha = h*a[j];
+        const double* fk = getPtr(fk_) + (j*nsens+dir)*nx_;
+        for(int l=0; l<nx_; ++l) fxs[l] += ha*fk[l];
+      }
+    }
+    
+    // Evaluate the right hand side
+    evalRhs(i,t+c_[i]*h,nsens);
+  }
+}
+
+void ExplicitRKIntegratorInternal::updateState(double h, double* x, double* q, double* fx, double* fq, int nsens) const{
+  for(int i=0; i<ns_; ++i){
+    if(b_[i]==0) continue;
+    double hb = h*b_[i];
+    const double* k = getPtr(k_) + i*nx_;
+    for(int l=0; l<nx_; ++l) x[l] += hb*k[l];
+    if(q!=0){
+      const double* kq = getPtr(kq_) + i*nq_;
+      for(int l=0; l<nq_; ++l) q[l] += hb*kq[l];
+    }
+    for(int dir=0; dir<nsens; ++dir){
+      const double* fk = getPtr(fk_) + (i*nsens+dir)*nx_;
+      for(int l=0; l<nx_; ++l) fx[dir*nx_+l] += hb*fk[l];
+      const double* fkq = getPtr(fkq_) + (i*nsens+dir)*nq_;
+      for(int l=0; l<nq_; ++l) fq[dir*nq_+l] += hb*fkq[l];
+    }
+  }
+}
+
+double ExplicitRKIntegratorInternal::errorNorm(double h, const double* x_old, const double* x_new, const double* q_old, const double* q_new) const{
+  double sum = 0;
+  for(int l=0; l<nx_; ++l){
+    double err = 0;
+    for(int i=0; i<ns_; ++i) err += e_[i]*k_[i*nx_+l];
+    double sc = abstol_ + reltol_*std::max(fabs(x_old[l]),fabs(x_new[l]));
+    sum += (h*err/sc)*(h*err/sc);
+  }
+  int n = nx_;
+  if(quad_err_con_){
+    for(int l=0; l<nq_; ++l){
+      double err = 0;
+      for(int i=0; i<ns_; ++i) err += e_[i]*kq_[i*nq_+l];
+      double sc = abstol_ + reltol_*std::max(fabs(q_old[l]),fabs(q_new[l]));
+      sum += (h*err/sc)*(h*err/sc);
+    }
+    n += nq_;
+  }
+  return n==0 ? 0 : sqrt(sum/n);
+}
+
+/// Evaluate the continuous extension of the Dormand-Prince method at theta in [0,1] for a vector of length n
+static void dopriDense(double theta, double h, int n, const double* y_old, const double* y_new, const double* k, int k_stride, const vector<double>& d, double* y){
+  int ns = d.size();
+  double theta1 = 1-theta;
+  for(int l=0; l<n; ++l){
+    double ydiff = y_new[l]-y_old[l];
+    double bspl = h*k[l] - ydiff;
+    double rc4 = ydiff - h*k[(ns-1)*k_stride+l] - bspl;
+    double rc5 = 0;
+    for(int i=0; i<ns; ++i) rc5 += d[i]*k[i*k_stride+l];
+    y[l] = y_old[l] + theta*(ydiff + theta1*(bspl + theta*(rc4 + theta1*h*rc5)));
+  }
+}
+
+void ExplicitRKIntegratorInternal::denseOutput(double theta, int nsens){
+  dopriDense(theta,h_old_,nx_,getPtr(x_old_),getPtr(x_),getPtr(k_),nx_,d_,output(INTEGRATOR_XF).ptr());
+  dopriDense(theta,h_old_,nq_,getPtr(q_old_),getPtr(q_),getPtr(kq_),nq_,d_,output(INTEGRATOR_QF).ptr());
+  for(int dir=0; dir<nsens; ++dir){
+    dopriDense(theta,h_old_,nx_,getPtr(fx_old_)+dir*nx_,getPtr(fx_)+dir*nx_,getPtr(fk_)+dir*nx_,nsens*nx_,d_,fwdSens(INTEGRATOR_XF,dir).ptr());
+    dopriDense(theta,h_old_,nq_,getPtr(fq_old_)+dir*nq_,getPtr(fq_)+dir*nq_,getPtr(fkq_)+dir*nq_,nsens*nq_,d_,fwdSens(INTEGRATOR_QF,dir).ptr());
+  }
+}
+
+void ExplicitRKIntegratorInternal::integrate(double t_out){
+  // Tolerance for reaching a time point
+  double eps = 1e-12*std::max(1.0,fabs(tf_));
+  casadi_assert_message(!adaptive_ || t_out<=tf_+eps, "Cannot integrate beyond the end of the time horizon with the adaptive method.");
+  casadi_assert_message(t_out>=(adaptive_ ? t_old_ : t_)-eps, "Cannot integrate backwards in time.");
+  
+  // Take steps until t_out has been reached, the adaptive method does not step beyond tf but may step beyond t_out
+  int nsteps_call = 0;
+  while(t_ < t_out-eps){
+    double t_stop = adaptive_ ? tf_ : t_out;
+    double h = std::min(h_,t_stop-t_);
+    if(t_stop-t_-h < 1e-8*h) h = t_stop-t_; // Avoid a tiny last step
+    bool last = h==t_stop-t_;
+    
+    if(!adaptive_){
+      // Fixed step, in place
+      evalStages(t_,h,getPtr(x_),getPtr(fx_),nsens_,false);
+      updateState(h,getPtr(x_),getPtr(q_),getPtr(fx_),getPtr(fq_),nsens_);
+      t_ = last ? t_stop : t_+h;
+    } else {
+      // Reuse the last stage of the previous step as first stage
+      bool first_stage_given = false;
+      if(fsal_valid_){
+        copy(k_.begin()+(ns_-1)*nx_,k_.begin()+ns_*nx_,k_.begin());
+        copy(kq_.begin()+(ns_-1)*nq_,kq_.begin()+ns_*nq_,kq_.begin());
+        copy(fk_.begin()+(ns_-1)*nsens_*nx_,fk_.begin()+ns_*nsens_*nx_,fk_.begin());
+        copy(fkq_.begin()+(ns_-1)*nsens_*nq_,fkq_.begin()+ns_*nsens_*nq_,fkq_.begin());
+        fsal_valid_ = false;
+        first_stage_given = true;
+      }
+      
+      // Beginning of the step, needed for rejected steps and the dense output
+      copy(x_.begin(),x_.end(),x_old_.begin());
+      copy(q_.begin(),q_.end(),q_old_.begin());
+      copy(fx_.begin(),fx_.begin()+nsens_*nx_,fx_old_.begin());
+      copy(fq_.begin(),fq_.begin()+nsens_*nq_,fq_old_.begin());
+      
+      // Try steps until the error is small enough
+      while(true){
+        casadi_assert_message(nsteps_call++ < max_num_steps_, "ExplicitRKIntegrator: Maximum number of steps (" << max_num_steps_ << ") reached at t = " << t_);
+        evalStages(t_,h,getPtr(x_),getPtr(fx_),nsens_,first_stage_given);
+        first_stage_given = true; // The first stage only depends on the beginning of the step
+        updateState(h,getPtr(x_),getPtr(q_),getPtr(fx_),getPtr(fq_),nsens_);
+        
+        // Step size factor from the error estimate
+        double err = errorNorm(h,getPtr(x_old_),getPtr(x_),getPtr(q_old_),getPtr(q_));
+        double fac = err==0 ? 5.0 : std::min(5.0,std::max(0.2,0.9*pow(err,-0.2)));
+        if(err<=1){
+          // Accept
+          t_old_ = t_;
+          h_old_ = h;
+          t_ = last ? t_stop : t_+h;
+          h_ = h*fac;
+          fsal_valid_ = fsal_;
+          break;
+        }
+        
+        // Reject, restore the beginning of the step
+        nrejected_++;
+        copy(x_old_.begin(),x_old_.end(),x_.begin());
+        copy(q_old_.begin(),q_old_.end(),q_.begin());
+        copy(fx_old_.begin(),fx_old_.begin()+nsens_*nx_,fx_.begin());
+        copy(fq_old_.begin(),fq_old_.begin()+nsens_*nq_,fq_.begin());
+        h *= fac;
+        last = false;
+        casadi_assert_message(h>eps, "ExplicitRKIntegrator: Step size too small at t = " << t_);
+      }
+    }
+    nsteps_++;
+    
+    // Record the step for the adjoint sensitivities
+    if(record_){
+      step_t_.push_back(t_);
+      int k = step_t_.size()-1;
+      if(k<=nchk_) copy(x_.begin(),x_.end(),chk_.begin()+k*nx_);
+    }
+  }
+  
+  // Get the solution at t_out
+  if(t_ > t_out+eps){
+    denseOutput((t_out-t_old_)/h_old_,nsens_);
+  } else {
+    copy(x_.begin(),x_.end(),output(INTEGRATOR_XF).begin());
+    copy(q_.begin(),q_.end(),output(INTEGRATOR_QF).begin());
+    for(int dir=0; dir<nsens_; ++dir){
+      copy(fx_.begin()+dir*nx_,fx_.begin()+(dir+1)*nx_,fwdSens(INTEGRATOR_XF,dir).begin());
+      copy(fq_.begin()+dir*nq_,fq_.begin()+(dir+1)*nq_,fwdSens(INTEGRATOR_QF,dir).begin());
+    }
+  }
+  
+  // Save statistics
+  stats_["nsteps"] = 1.0*nsteps_;
+  stats_["nrejected"] = 1.0*nrejected_;
+  stats_["nfevals"] = 1.0*nfevals_;
+}
+
+void ExplicitRKIntegratorInternal::integrateB(double t_out){
+}
+
+FX ExplicitRKIntegratorInternal::getDerivative(int nfwd, int nadj){
+  // The augmented DAE of the base class has a backward problem, differentiate a copy numerically instead
+  Integrator integrator;
+  integrator.assignNode(create(f_,g_));
+  integrator.setOption(dictionary());
+  integrator.init();
+  return Derivative(integrator,nfwd,nadj);
+}
+
+void ExplicitRKIntegratorInternal::advance(int a, int b, double* x){
+  for(int k=a; k<b; ++k){
+    double h = step_t_[k+1]-step_t_[k];
+    evalStages(step_t_[k],h,x,0,0,false);
+    updateState(h,x,0,0,0,0);
+    nrecomputed_++;
+  }
+}
+
+void ExplicitRKIntegratorInternal::adjointStep(int k, const double* x, int nadir){
+  double t = step_t_[k], h = step_t_[k+1]-step_t_[k];
+  
+  // Recompute the states at the stages
+  evalStages(t,h,x,0,0,false);
+  
+  // Propagate backwards through the stages
+  for(int i=ns_-1; i>=0; --i){
+    double* lam_xs = getPtr(lam_xs_) + i*nadir*nx_;
+    
+    // Skip stages that do not contribute to the step, such as the last stage of Dormand-Prince
+    bool contributes = b_[i]!=0;
+    for(int j=i+1; j<ns_ && !contributes; ++j) contributes = a_[j*(j-1)/2+i]!=0;
+    if(!contributes){
+      fill(lam_xs,lam_xs+nadir*nx_,0.0);
+      continue;
+    }
+    
+    // Adjoint seeds: sensitivities with respect to the right hand side and quadratures at the stage
+    for(int dir=0; dir<nadir; ++dir){
+      double* lam_k = getPtr(lam_k_) + dir*nx_;
+      const double* lam_x = getPtr(lam_x_) + dir*nx_;
+      for(int l=0; l<nx_; ++l) lam_k[l] = h*b_[i]*lam_x[l];
+      for(int j=i+1; j<ns_; ++j){
+        double ha = h*a_[j*(j-1)/2+i];
+        if(ha==0) continue;
+        const double* lam_xs_j = getPtr(lam_xs_) + (j*nadir+dir)*nx_;
+        for(int l=0; l<nx_; ++l) lam_k[l] += ha*lam_xs_j[l];
+      }
+      copy(lam_k,lam_k+nx_,f_.adjSeed(DAE_ODE,dir).begin());
+      const double* lam_q = getPtr(lam_q_) + dir*nq_;
+      double* lam_kq = getPtr(lam_kq_) + dir*nq_;
+      for(int l=0; l<nq_; ++l) lam_kq[l] = h*b_[i]*lam_q[l];
+      copy(lam_kq,lam_kq+nq_,f_.adjSeed(DAE_QUAD,dir).begin());
+      f_.adjSeed(DAE_ALG,dir).setZero();
+    }
+    
+    // Pass the inputs
+    copy(xs_.begin()+i*nx_,xs_.begin()+(i+1)*nx_,f_.input(DAE_X).begin());
+    copy(input(INTEGRATOR_P).begin(),input(INTEGRATOR_P).end(),f_.input(DAE_P).begin());
+    vector<double>& t_in = f_.input(DAE_T).data();
+    fill(t_in.begin(),t_in.end(),t+c_[i]*h);
+
+    // Evaluate
+    f_.evaluate(0,nadir);
+    nfevals_++;
+
+    // Get the adjoint sensitivities
+    for(int dir=0; dir<nadir; ++dir){
+      const DMatrix& asens_x = f_.adjSens(DAE_X,dir);
+      copy(asens_x.begin(),asens_x.end(),lam_xs+dir*nx_);
+      const DMatrix& asens_p = f_.adjSens(DAE_P,dir);
+      double* lam_p = getPtr(lam_p_) + dir*np_;
+      for(int l=0; l<np_; ++l) lam_p[l] += asens_p.at(l);
+    }
+  }
+  
+  // Adjoint sensitivities with respect to the state at the beginning of the step
+  for(int i=0; i<ns_; ++i){
+    for(int dir=0; dir<nadir; ++dir){
+      double* lam_x = getPtr(lam_x_) + dir*nx_;
+      const double* lam_xs = getPtr(lam_xs_) + (i*nadir+dir)*nx_;
+      for(int l=0; l<nx_; ++l) lam_x[l] += lam_xs[l];
+    }
+  }
+}
+
+void ExplicitRKIntegratorInternal::reverseSteps(int a, int b, int s, int nchk, int nadir){
+  if(b-a==1){
+    // Only one step left
+    adjointStep(a,getPtr(chk_)+s*nx_,nadir);
+  } else if(nchk==0){
+    // No checkpoints left, recompute each step from the beginning
+    for(int k=b-1; k>=a; --k){
+      copy(chk_.begin()+s*nx_,chk_.begin()+(s+1)*nx_,x_tmp_.begin());
+      advance(a,k,getPtr(x_tmp_));
+      adjointStep(k,getPtr(x_tmp_),nadir);
+    }
+  } else {
+    // Smallest number of repetitions r such that the nchk checkpoints suffice: binomial(nchk+r,nchk) >= b-a
+    int r = 0;
+    double beta = 1;
+    while(beta < b-a){
+      r++;
+      beta *= double(nchk+r)/r;
+    }
+    
+    // Place a checkpoint such that the remaining steps can be reversed with r repetitions and one checkpoint less
+    double beta_right = beta*nchk/(nchk+r);
+    int m = a + std::max(1, b-a-int(beta_right));
+    m = std::min(m,b-1);
+    copy(chk_.begin()+s*nx_,chk_.begin()+(s+1)*nx_,chk_.begin()+(s+1)*nx_);
+    advance(a,m,getPtr(chk_)+(s+1)*nx_);
+    
+    // Reverse the steps after the checkpoint, then the steps before
+    reverseSteps(m,b,s+1,nchk-1,nadir);
+    reverseSteps(a,m,s,nchk,nadir);
+  }
+}
+
+} // namespace CasADi
@@ -0,0 +1,161 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef EXPLICIT_RK_INTEGRATOR_INTERNAL_HPP
+#define EXPLICIT_RK_INTEGRATOR_INTERNAL_HPP
+
+#include "explicit_rk_integrator.hpp"
+#include "symbolic/fx/integrator_internal.hpp"
+
+namespace CasADi{
+    
+class ExplicitRKIntegratorInternal : public IntegratorInternal{
+
+public:
+  
+  /// Constructor
+  explicit ExplicitRKIntegratorInternal(const FX& f, const FX& g);
+
+  /// Clone
+  virtual ExplicitRKIntegratorInternal* clone() const{ return new ExplicitRKIntegratorInternal(*this);}
+
+  /// Create a new integrator
+  virtual ExplicitRKIntegratorInternal* create(const FX& f, const FX& g) const{ return new ExplicitRKIntegratorInternal(f,g);}
+  
+  /// Destructor
+  virtual ~ExplicitRKIntegratorInternal();
+
+  /// Initialize stage
+  virtual void init();
+  
+  /// Print solver statistics
+  virtual void printStats(std::ostream &stream) const;
+
+  /// Reset the forward problem and bring the time back to t0
+  virtual void reset(int nsens, int nsensB, int nsensB_store);
+
+  /// Reset the backward problem and take time to tf
+  virtual void resetB();
+
+  /// Forward sensitivities along with the states, adjoint sensitivities of the discretized ODE by checkpointing
+  virtual void evaluate(int nfdir, int nadir);
+
+  ///  Integrate until a specified time point
+  virtual void integrate(double t_out);
+
+  /// Integrate backward in time until a specified time point
+  virtual void integrateB(double t_out);
+
+  /// Derivative evaluated with the native forward and discrete adjoint sensitivities, no backward problem needed
+  virtual FX getDerivative(int nfwd, int nadj);
+
+  /// Evaluate the right hand side at the state of stage i, with nsens forward sensitivities
+  void evalRhs(int i, double t, int nsens);
+  
+  /// Evaluate the stages of a step of length h from the state x, with nsens forward sensitivities fx
+  void evalStages(double t, double h, const double* x, const double* fx, int nsens, bool first_stage_given);
+  
+  /// Take the step evaluated in the stages: x += h*sum(b_i*k_i), same for the quadratures and the sensitivities
+  void updateState(double h, double* x, double* q, double* fx, double* fq, int nsens) const;
+  
+  /// Estimate the error of the step evaluated in the stages, scaled with the tolerances
+  double errorNorm(double h, const double* x_old, const double* x_new, const double* q_old, const double* q_new) const;
+  
+  /// Get the solution at a time point inside the last step from the dense output
+  void denseOutput(double theta, int nsens);
+  
+  /// Take a step of the adjoint of the discretized ODE, the state at the beginning of the step given
+  void adjointStep(int k, const double* x, int nadir);
+  
+  /// Reverse the steps [a,b) given the state at the beginning of step a in checkpoint s, with nchk checkpoints free after s
+  void reverseSteps(int a, int b, int s, int nchk, int nadir);
+  
+  /// Recompute the state at the beginning of step b, given the state at the beginning of step a
+  void advance(int a, int b, double* x);
+  
+  /// Butcher tableau: a_ is the strictly lower triangular part, row by row
+  std::vector<double> a_, b_, c_;
+  
+  /// Weights of the error estimate (b-bhat) and of the dense output, empty if not applicable
+  std::vector<double> e_, d_;
+  
+  /// Number of stages
+  int ns_;
+  
+  /// Is the last stage evaluated at the end of the step, with the new state (first same as last)?
+  bool fsal_;
+  
+  /// Adaptive step size control?
+  bool adaptive_;
+  
+  /// Tolerances for the step size control
+  double abstol_, reltol_;
+  
+  /// Include the quadratures in the error control?
+  bool quad_err_con_;
+  
+  /// Maximum number of steps in an integration
+  int max_num_steps_;
+  
+  /// Step size of the fixed step method or the next step size of the adaptive method
+  double h_;
+  
+  /// Number of checkpoints for the adjoint sensitivities
+  int nchk_;
+  
+  /// Current time, state, quadratures and forward sensitivities
+  double t_;
+  std::vector<double> x_, q_, fx_, fq_;
+  
+  /// Time, state, quadratures and forward sensitivities at the beginning of the last step, for dense output
+  double t_old_, h_old_;
+  std::vector<double> x_old_, q_old_, fx_old_, fq_old_;
+  
+  /// Stages: right hand sides, quadratures, their forward sensitivities and the states at which they were evaluated
+  std::vector<double> k_, kq_, fk_, fkq_, xs_, fxs_;
+  
+  /// Has the last stage of the previous step been evaluated at the current state?
+  bool fsal_valid_;
+  
+  /// Record the steps for the adjoint sensitivities
+  bool record_;
+  
+  /// Beginning of each step taken since the last reset, and the end time last
+  std::vector<double> step_t_;
+  
+  /// Checkpoints: states at the beginning of a step, the first one at the beginning of the first step
+  std::vector<double> chk_;
+  
+  /// Adjoint sensitivities: of the state, the quadratures and the parameters
+  std::vector<double> lam_x_, lam_q_, lam_p_;
+  
+  /// Adjoint sensitivities with respect to the state at the stages, and work vectors
+  std::vector<double> lam_xs_, lam_k_, lam_kq_, x_tmp_;
+  
+  /// Statistics
+  int nsteps_, nrejected_, nfevals_, nrecomputed_;
+};
+
+} // namespace CasADi
+
+#endif //EXPLICIT_RK_INTEGRATOR_INTERNAL_HPP
@@ -161,8 +161,10 @@ namespace CasADi{
 #endif // WITH_SIPOPT
 
     // Get/generate required functions
-    gradF();
-    jacG();
+    if(!fused_){
+      gradF();
+      jacG();
+    }
     if(exact_hessian_){
       hessLag();
     }
@@ -244,6 +246,9 @@ namespace CasADi{
 
     checkInitialBounds();
 
+    // The parameters may have changed since the last solve
+    resetFusedOracle();
+
     // Reset the counters
     t_eval_f_ = t_eval_grad_f_ = t_eval_g_ = t_eval_jac_g_ = t_eval_h_ = t_callback_fun_ = t_callback_prepare_ = t_mainloop_ = 0;
   
@@ -335,6 +340,10 @@ namespace CasADi{
     stats_["t_mainloop"] = t_mainloop_;
     stats_["t_callback_fun"] = t_callback_fun_;
     stats_["t_callback_prepare"] = t_callback_prepare_;
+    if(fused_){
+      stats_["fused_oracle_evaluations"] = fused_num_eval_;
+      stats_["fused_oracle_reuses"] = fused_num_reuse_;
+    }
   
   }
 
@@ -430,6 +439,9 @@ namespace CasADi{
             }
           }
       } else {
+        // Drop the results of the fused oracle when Ipopt announces a new x
+        if(new_x) resetFusedOracle();
+
         // Pass the argument to the function
         hessLag_.setInput(x,NL_X);
         hessLag_.setInput(input(NLP_SOLVER_P),NL_P);
@@ -465,21 +477,34 @@ namespace CasADi{
         return true;
       }
       
-      // Get function
-      FX& jacG = this->jacG();
-    
       double time1 = clock();
       if (values == NULL) {
         int nz=0;
         vector<int> rowind,col;
-        jacG.output().sparsity().getSparsityCRS(rowind,col);
+        if(fused_){
+          fusedJacGSparsity().getSparsityCRS(rowind,col);
+        } else {
+          jacG().output().sparsity().getSparsityCRS(rowind,col);
+        }
         for(int r=0; r<rowind.size()-1; ++r)
           for(int el=rowind[r]; el<rowind[r+1]; ++el){
             iRow[nz] = r;
             jCol[nz] = col[el];
             nz++;
           }
+      } else if(fused_){
+        // Fused evaluation
+        evalFusedOracle(x,FUSED_JAC_G);
+        getFusedJacG(values);
+        if(monitored("eval_jac_g")){
+          cout << "x = " << vector<double>(x,x+n) << endl;
+          cout << "J = " << DMatrix(fusedJacGSparsity(),vector<double>(values,values+nele_jac)) << endl;
+        }
+        if (regularity_check_ && !isRegular(vector<double>(values,values+nele_jac))) casadi_error("IpoptInternal::jac_g: NaN or Inf detected.");
       } else {
+        // Get function
+        FX& jacG = this->jacG();
+
         // Pass the argument to the function
         jacG.setInput(x,NL_X);
         jacG.setInput(input(NLP_SOLVER_P),NL_P);
@@ -518,23 +543,29 @@ namespace CasADi{
       double time1 = clock();
       casadi_assert(n == nx_);
 
-      // Pass the argument to the function
-      nlp_.setInput(x,NL_X);
-      nlp_.setInput(input(NLP_SOLVER_P),NL_P);
+      if(fused_){
+        // Fused evaluation
+        evalFusedOracle(x,FUSED_FG);
+        obj_value = fusedF();
+      } else {
+        // Pass the argument to the function
+        nlp_.setInput(x,NL_X);
+        nlp_.setInput(input(NLP_SOLVER_P),NL_P);
       
-      // Evaluate the function
-      nlp_.evaluate();
+        // Evaluate the function
+        nlp_.evaluate();
 
-      // Get the result
-      nlp_.getOutput(obj_value,NL_F);
+        // Get the result
+        nlp_.getOutput(obj_value,NL_F);
+      }
 
       // Printing
       if(monitored("eval_f")){
-        cout << "x = " << nlp_.input(NL_X) << endl;
+        cout << "x = " << vector<double>(x,x+n) << endl;
         cout << "obj_value = " << obj_value << endl;
       }
 
-      if (regularity_check_ && !isRegular(nlp_.output(NL_F).data())) casadi_error("IpoptInternal::f: NaN or Inf detected.");
+      if (regularity_check_ && !isRegular(vector<double>(1,obj_value))) casadi_error("IpoptInternal::f: NaN or Inf detected.");
     
       double time2 = clock();
       t_eval_f_ += double(time2-time1)/CLOCKS_PER_SEC;
@@ -555,24 +586,30 @@ namespace CasADi{
       double time1 = clock();
 
       if(m>0){
-        // Pass the argument to the function
-        nlp_.setInput(x,NL_X);
-        nlp_.setInput(input(NLP_SOLVER_P),NL_P);
+        if(fused_){
+          // Fused evaluation
+          evalFusedOracle(x,FUSED_FG);
+          getFusedG(g);
+        } else {
+          // Pass the argument to the function
+          nlp_.setInput(x,NL_X);
+          nlp_.setInput(input(NLP_SOLVER_P),NL_P);
 
-        // Evaluate the function and tape
-        nlp_.evaluate();
+          // Evaluate the function and tape
+          nlp_.evaluate();
 
-        // Ge the result
-        nlp_.getOutput(g,NL_G);
+          // Ge the result
+          nlp_.getOutput(g,NL_G);
+        }
 
         // Printing
         if(monitored("eval_g")){
-          cout << "x = " << nlp_.input(NL_X) << endl;
-          cout << "g = " << nlp_.output(NL_G) << endl;
+          cout << "x = " << vector<double>(x,x+n) << endl;
+          cout << "g = " << vector<double>(g,g+m) << endl;
         }
       }
     
-      if (regularity_check_ && !isRegular(nlp_.output(NL_G).data())) casadi_error("IpoptInternal::g: NaN or Inf detected.");
+      if (regularity_check_ && !isRegular(vector<double>(g,g+m))) casadi_error("IpoptInternal::g: NaN or Inf detected.");
           
       double time2 = clock();
       t_eval_g_ += double(time2-time1)/CLOCKS_PER_SEC;
@@ -592,23 +629,29 @@ namespace CasADi{
       double time1 = clock();
       casadi_assert(n == nx_);
     
-      // Pass the argument to the function
-      gradF_.setInput(x,NL_X);
-      gradF_.setInput(input(NLP_SOLVER_P),NL_P);
+      if(fused_){
+        // Fused evaluation
+        evalFusedOracle(x,FUSED_GRAD_F);
+        getFusedGradF(grad_f);
+      } else {
+        // Pass the argument to the function
+        gradF_.setInput(x,NL_X);
+        gradF_.setInput(input(NLP_SOLVER_P),NL_P);
       
-      // Evaluate, adjoint mode
-      gradF_.evaluate();
+        // Evaluate, adjoint mode
+        gradF_.evaluate();
       
-      // Get the result
-      gradF_.output().getArray(grad_f,n,DENSE);
+        // Get the result
+        gradF_.output().getArray(grad_f,n,DENSE);
+      }
       
       // Printing
       if(monitored("eval_grad_f")){
-        cout << "x = " << gradF_.input(NL_X) << endl;
-        cout << "grad_f = " << gradF_.output() << endl;
+        cout << "x = " << vector<double>(x,x+n) << endl;
+        cout << "grad_f = " << vector<double>(grad_f,grad_f+n) << endl;
       }
 
-      if (regularity_check_ && !isRegular(gradF_.output().data())) casadi_error("IpoptInternal::grad_f: NaN or Inf detected.");
+      if (regularity_check_ && !isRegular(vector<double>(grad_f,grad_f+n))) casadi_error("IpoptInternal::grad_f: NaN or Inf detected.");
     
       double time2 = clock();
       t_eval_grad_f_ += double(time2-time1)/CLOCKS_PER_SEC;
@@ -684,6 +727,8 @@ namespace CasADi{
       // Get Jacobian sparsity pattern
       if(nlp_.output(NL_G).size()==0)
         nnz_jac_g = 0;
+      else if(fused_)
+        nnz_jac_g = fusedJacGSparsity().size();
       else
         nnz_jac_g = jacG().output().size();
 
@@ -42,6 +42,7 @@ QPOasesInternal* QPOasesInternal::clone() const{
 QPOasesInternal::QPOasesInternal(const std::vector<CRSSparsity>& st) : QPSolverInternal(st){
   addOption("nWSR",                   OT_INTEGER,     GenericType(), "The maximum number of working set recalculations to be performed during the initial homotopy. Default is 5(nx + nc)");
   addOption("CPUtime",                OT_REAL,        GenericType(), "The maximum allowed CPU time in seconds for the whole initialisation (and the actually required one on output). Disabled if unset.");
+  addOption("hotstart",               OT_BOOLEAN,     true,          "Start from the active set of the previous call. If H and A are unchanged, the factorization is reused as well and the matrices are not converted again.");
 
   // Temporary object
   qpOASES::Options ops;
@@ -104,6 +105,7 @@ void QPOasesInternal::init(){
   } else {
     max_cputime_ = -1;
   }
+  hotstart_ = getOption("hotstart");
   
   // Create data for H if not dense
   if(!input(QP_SOLVER_H).sparsity().dense()) h_data_.resize(n_*n_);
@@ -113,6 +115,13 @@ void QPOasesInternal::init(){
   
   // Dual solution vector
   dual_.resize(n_+nc_);
+
+  // Nonzeros of H and A in the last call
+  h_nz_.clear();
+  a_nz_.clear();
+
+  // Statistics
+  num_cold_starts_ = num_hot_starts_ = num_matrix_updates_ = nWSR_total_ = 0;
   
   // Create qpOASES instance
   if(qp_) delete qp_;
@@ -175,14 +184,22 @@ void QPOasesInternal::evaluate(int nfdir, int nadir) {
     cout << "UBA = " << input(QP_SOLVER_UBA) << endl;
   }
   
+  // Have the matrices changed since the last call?
+  const vector<double>& h_nz = input(QP_SOLVER_H).data();
+  const vector<double>& a_nz = input(QP_SOLVER_A).data();
+  bool h_changed = !called_once_ || h_nz!=h_nz_;
+  bool a_changed = !called_once_ || a_nz!=a_nz_;
+  if(h_changed) h_nz_ = h_nz;
+  if(a_changed) a_nz_ = a_nz;
+
   // Get pointer to H
   const double* h=0;
   if(h_data_.empty()){
     // No copying needed
     h = getPtr(input(QP_SOLVER_H));
   } else {
-    // First copy to dense array
-    input(QP_SOLVER_H).get(h_data_,DENSE);
+    // Copy to dense array, unless unchanged
+    if(h_changed) input(QP_SOLVER_H).get(h_data_,DENSE);
     h = getPtr(h_data_);
   }
   
@@ -192,8 +209,8 @@ void QPOasesInternal::evaluate(int nfdir, int nadir) {
     // No copying needed
     a = getPtr(input(QP_SOLVER_A));
   } else {
-    // First copy to dense array
-    input(QP_SOLVER_A).get(a_data_,DENSE);
+    // Copy to dense array, unless unchanged
+    if(a_changed) input(QP_SOLVER_A).get(a_data_,DENSE);
     a = getPtr(a_data_);
   }
   
@@ -209,23 +226,45 @@ void QPOasesInternal::evaluate(int nfdir, int nadir) {
   const double* lbA = getPtr(input(QP_SOLVER_LBA));
   const double* ubA = getPtr(input(QP_SOLVER_UBA));
 
+  // Without constraints, qpOASES can only hot-start if H is unchanged
+  bool simple = ALLOW_QPROBLEMB && nc_==0;
+  bool cold = !called_once_ || !hotstart_ || (simple && h_changed);
+
   int flag;
-  if(!called_once_){
-    if(ALLOW_QPROBLEMB && nc_==0){
+  if(cold){
+    if(simple){
+      if(called_once_) static_cast<qpOASES::QProblemB*>(qp_)->reset();
       flag = static_cast<qpOASES::QProblemB*>(qp_)->init(h,g,lb,ub,nWSR,cputime_ptr);
     } else {
+      if(called_once_) static_cast<qpOASES::SQProblem*>(qp_)->reset();
       flag = static_cast<qpOASES::SQProblem*>(qp_)->init(h,g,a,lb,ub,lbA,ubA,nWSR,cputime_ptr);
     }
     called_once_ = true;
+    num_cold_starts_++;
   } else {
-    if(ALLOW_QPROBLEMB && nc_==0){
-      static_cast<qpOASES::QProblemB*>(qp_)->reset();
-      flag = static_cast<qpOASES::QProblemB*>(qp_)->init(h,g,lb,ub,nWSR,cputime_ptr);
-      //flag = static_cast<qpOASES::QProblemB*>(qp_)->hotstart(g,lb,ub,nWSR,cputime_ptr);
+    if(simple){
+      // Same Hessian, reuse the factorization
+      flag = static_cast<qpOASES::QProblemB*>(qp_)->hotstart(g,lb,ub,nWSR,cputime_ptr);
+    } else if(h_changed || a_changed){
+      // New matrices, reuse the active set
+      flag = static_cast<qpOASES::SQProblem*>(qp_)->hotstart(h,g,a,lb,ub,lbA,ubA,nWSR,cputime_ptr);
+      num_matrix_updates_++;
     } else {
-      flag = static_cast<qpOASES::SQProblem*>(qp_)->hotstart(h,g,a,lb,ub,lbA,ubA,nWSR, cputime_ptr);
+      // Same matrices, reuse the active set and the factorization
+      flag = static_cast<qpOASES::SQProblem*>(qp_)->hotstart(g,lb,ub,lbA,ubA,nWSR,cputime_ptr);
     }
+    num_hot_starts_++;
   }
+  nWSR_total_ += nWSR;
+
+  // Save statistics
+  stats_["working_set_changes"] = nWSR;
+  stats_["working_set_changes_total"] = nWSR_total_;
+  stats_["hotstart"] = !cold;
+  stats_["num_cold_starts"] = num_cold_starts_;
+  stats_["num_hot_starts"] = num_hot_starts_;
+  stats_["num_matrix_updates"] = num_matrix_updates_;
+
   if(flag!=qpOASES::SUCCESSFUL_RETURN && flag!=qpOASES::RET_MAX_NWSR_REACHED){
     throw CasadiException("qpOASES failed: " + getErrorMessage(flag));
   }
@@ -81,6 +81,15 @@ public:
     
     /// Has qpOASES been called once?
     bool called_once_;
+
+    /// Hot-start from the previous call?
+    bool hotstart_;
+
+    /// Nonzeros of H and A in the previous call, to detect unchanged matrices
+    std::vector<double> h_nz_, a_nz_;
+
+    /// Statistics: number of cold starts, hot starts, hot starts with new matrices and working set changes
+    int num_cold_starts_, num_hot_starts_, num_matrix_updates_, nWSR_total_;
     
     /// Dense data for H and A
     std::vector<double> h_data_;
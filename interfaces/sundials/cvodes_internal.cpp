@@ -348,31 +348,34 @@ void CVodesInternal::rhs(double t, const double* x, double* xdot){
   log("CVodesInternal::rhs","begin");
 
   // Get time
-  time1 = clock();
+  if(time_res_) time1 = clock();
 
-  // Pass input
-  f_.setInput(&t,DAE_T);
-  f_.setInput(x,DAE_X);
-  f_.setInput(input(INTEGRATOR_P),DAE_P);
+  // Evaluate in place, reading and writing the N_Vector data directly
+  const double* arg[DAE_NUM_IN] = {0};
+  double* res[DAE_NUM_OUT] = {0};
+  arg[DAE_T] = &t;
+  arg[DAE_X] = x;
+  arg[DAE_P] = getPtr(input(INTEGRATOR_P));
+  res[DAE_ODE] = xdot;
 
   if(monitor_rhs_) {
     cout << "t       = " << t << endl;
-    cout << "x       = " << f_.input(DAE_X) << endl;
-    cout << "p       = " << f_.input(DAE_P) << endl;
+    cout << "x       = " << vector<double>(x,x+nx_) << endl;
+    cout << "p       = " << input(INTEGRATOR_P) << endl;
   }
-    // Evaluate
-  f_.evaluate();
+
+  // Evaluate
+  f_.evaluateRaw(arg,res);
 
   if(monitor_rhs_) {
-    cout << "xdot       = " << f_.output(DAE_ODE)<< endl;
+    cout << "xdot       = " << vector<double>(xdot,xdot+nx_) << endl;
   }
-    
-  // Get results
-  f_.getOutput(xdot);
 
   // Log time
-  time2 = clock();
-  t_res += double(time2-time1)/CLOCKS_PER_SEC;
+  if(time_res_){
+    time2 = clock();
+    t_res += double(time2-time1)/CLOCKS_PER_SEC;
+  }
 
   log("CVodesInternal::rhs","end");
 
@@ -778,16 +781,14 @@ try{
 }
 
 void CVodesInternal::rhsQ(double t, const double* x, double* qdot){
-  // Pass input
-  f_.setInput(&t,DAE_T);
-  f_.setInput(x,DAE_X);
-  f_.setInput(input(INTEGRATOR_P),DAE_P);
-
-  // Evaluate
-  f_.evaluate();
-    
-  // Get results
-  f_.getOutput(qdot,DAE_QUAD);
+  // Evaluate in place
+  const double* arg[DAE_NUM_IN] = {0};
+  double* res[DAE_NUM_OUT] = {0};
+  arg[DAE_T] = &t;
+  arg[DAE_X] = x;
+  arg[DAE_P] = getPtr(input(INTEGRATOR_P));
+  res[DAE_QUAD] = qdot;
+  f_.evaluateRaw(arg,res);
 }
 
 void CVodesInternal::rhsQS(int Ns, double t, N_Vector x, N_Vector *xF, N_Vector qdot, N_Vector *qdotF, N_Vector tmp1, N_Vector tmp2){
@@ -1093,7 +1094,7 @@ void CVodesInternal::djac(long N, double t, N_Vector x, N_Vector xdot, DlsMat Ja
   // Pass inputs to the jacobian function
   jac_.setInput(&t,DAE_T);
   jac_.setInput(NV_DATA_S(x),DAE_X);
-  jac_.setInput(f_.input(DAE_P),DAE_P);
+  jac_.setInput(input(INTEGRATOR_P),DAE_P);
   jac_.setInput(1.0,DAE_NUM_IN);
   jac_.setInput(0.0,DAE_NUM_IN+1);
 
@@ -1226,7 +1227,7 @@ void CVodesInternal::bjac(long N, long mupper, long mlower, double t, N_Vector x
   // Pass inputs to the jacobian function
   jac_.setInput(&t,DAE_T);
   jac_.setInput(NV_DATA_S(x),DAE_X);
-  jac_.setInput(f_.input(DAE_P),DAE_P);
+  jac_.setInput(input(INTEGRATOR_P),DAE_P);
   jac_.setInput(1.0,DAE_NUM_IN);
   jac_.setInput(0.0,DAE_NUM_IN+1);
 
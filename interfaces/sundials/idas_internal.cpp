@@ -475,36 +475,36 @@ void IdasInternal::res(double t, const double* xz, const double* xzdot, double*
   log("IdasInternal::res","begin");
   
   // Get time
-  time1 = clock();
-  
-  // Pass input
-  f_.setInput(&t,DAE_T);
-  f_.setInput(xz,DAE_X);
-  f_.setInput(xz+nx_,DAE_Z);
-  f_.setInput(input(INTEGRATOR_P),DAE_P);
+  if(time_res_) time1 = clock();
+  
+  // Evaluate in place, reading and writing the N_Vector data directly
+  const double* arg[DAE_NUM_IN] = {0};
+  double* res[DAE_NUM_OUT] = {0};
+  arg[DAE_T] = &t;
+  arg[DAE_X] = xz;
+  arg[DAE_Z] = xz+nx_;
+  arg[DAE_P] = getPtr(input(INTEGRATOR_P));
+  res[DAE_ODE] = r;
+  res[DAE_ALG] = r+nx_;
 
   if(monitored("res")){
     cout << "DAE_T    = " << t << endl;
-    cout << "DAE_X    = " << f_.input(DAE_X) << endl;
-    cout << "DAE_Z    = " << f_.input(DAE_Z) << endl;
-    cout << "DAE_P    = " << f_.input(DAE_P) << endl;
+    cout << "DAE_X    = " << vector<double>(xz,xz+nx_) << endl;
+    cout << "DAE_Z    = " << vector<double>(xz+nx_,xz+nx_+nz_) << endl;
+    cout << "DAE_P    = " << input(INTEGRATOR_P) << endl;
   }
   
   // Evaluate
-  f_.evaluate();
-  
-  // Get results
-  f_.getOutput(r,DAE_ODE);
-  f_.getOutput(r+nx_,DAE_ALG);
+  f_.evaluateRaw(arg,res);
   
   if(monitored("res")){
-    cout << "ODE rhs  = " << f_.output(DAE_ODE) << endl;
-    cout << "ALG rhs  = " << f_.output(DAE_ALG) << endl;
+    cout << "ODE rhs  = " << vector<double>(r,r+nx_) << endl;
+    cout << "ALG rhs  = " << vector<double>(r+nx_,r+nx_+nz_) << endl;
   }
   
   if (regularity_check_) {
-    casadi_assert_message(isRegular(f_.output(DAE_ODE).data()),"IdasInternal::res: f.output(DAE_ODE) is not regular.");
-    casadi_assert_message(isRegular(f_.output(DAE_ALG).data()),"IdasInternal::res: f.output(DAE_ALG) is not regular.");
+    casadi_assert_message(isRegular(vector<double>(r,r+nx_)),"IdasInternal::res: f.output(DAE_ODE) is not regular.");
+    casadi_assert_message(isRegular(vector<double>(r+nx_,r+nx_+nz_)),"IdasInternal::res: f.output(DAE_ALG) is not regular.");
   }
   
   // Subtract state derivative to get residual
@@ -512,8 +512,10 @@ void IdasInternal::res(double t, const double* xz, const double* xzdot, double*
     r[i] -= xzdot[i];
   }
   
-  time2 = clock();
-  t_res += double(time2-time1)/CLOCKS_PER_SEC;
+  if(time_res_){
+    time2 = clock();
+    t_res += double(time2-time1)/CLOCKS_PER_SEC;
+  }
   log("IdasInternal::res","end");
 }
 
@@ -1103,17 +1105,15 @@ int IdasInternal::rhsQ_wrapper(double t, N_Vector xz, N_Vector xzdot, N_Vector r
 
 void IdasInternal::rhsQ(double t, const double* xz, const double* xzdot, double* rhsQ){
    log("IdasInternal::rhsQ","begin");
-   // Pass input
-   f_.setInput(&t,DAE_T);
-   f_.setInput(xz,DAE_X);
-   f_.setInput(xz+nx_,DAE_Z);
-   f_.setInput(input(INTEGRATOR_P),DAE_P);
-
-    // Evaluate
-   f_.evaluate();
-    
-    // Get results
-   f_.getOutput(rhsQ,DAE_QUAD);
+   // Evaluate in place
+   const double* arg[DAE_NUM_IN] = {0};
+   double* res[DAE_NUM_OUT] = {0};
+   arg[DAE_T] = &t;
+   arg[DAE_X] = xz;
+   arg[DAE_Z] = xz+nx_;
+   arg[DAE_P] = getPtr(input(INTEGRATOR_P));
+   res[DAE_QUAD] = rhsQ;
+   f_.evaluateRaw(arg,res);
    log("IdasInternal::rhsQ","end");
 }
   
@@ -94,6 +94,7 @@ void SundialsInternal::init(){
   abstol_ = getOption("abstol");
   reltol_ = getOption("reltol");
   exact_jacobian_ = getOption("exact_jacobian");
+  time_res_ = getOption("print_stats");
   exact_jacobianB_ = hasSetOption("exact_jacobianB") ? getOption("exact_jacobianB") && !g_.isNull() : exact_jacobian_;
   max_num_steps_ = getOption("max_num_steps");
   finite_difference_fsens_ = getOption("finite_difference_fsens");
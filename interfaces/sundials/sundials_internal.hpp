@@ -66,6 +66,9 @@ public:
   bool finite_difference_fsens_;  
   bool stop_at_end_;
   //@}
+
+  /// Measure the time spent in the residual callbacks (only needed for print_stats)
+  bool time_res_;
   
   /// Current time (to be removed)
   double t_;
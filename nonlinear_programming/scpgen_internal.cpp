@@ -293,12 +293,7 @@ namespace CasADi{
       cout << "Generated residual function ( " << res_fcn.getAlgorithmSize() << " nodes)." << endl;
     }
 
-    // Generate c code and load as DLL
-    if(codegen_){
-      res_fcn_ = dynamicCompilation(res_fcn,"res_fcn","residual function",compiler);
-    } else {
-      res_fcn_ = res_fcn;
-    }
+    res_fcn_ = res_fcn;
 
     // Declare difference vector d and substitute out p and v
     stringstream ss;
@@ -408,12 +403,7 @@ namespace CasADi{
     MXFunction mat_fcn(mfcn_in,mat_out);
     mat_fcn.init();
   
-    // Generate c code and load as DLL
-    if(codegen_){
-      mat_fcn_ = dynamicCompilation(mat_fcn,"mat_fcn","Matrices function",compiler);
-    } else {
-      mat_fcn_ = mat_fcn;
-    }
+    mat_fcn_ = mat_fcn;
 
     // Definition of intermediate variables
     n = mfcn_out.size();
@@ -466,12 +456,7 @@ namespace CasADi{
       cout << "Generated linearization function ( " << vec_fcn.getAlgorithmSize() << " nodes)." << endl;
     }
   
-    // Generate c code and load as DLL
-    if(codegen_){
-      vec_fcn_ = dynamicCompilation(vec_fcn,"vec_fcn","linearization function",compiler);
-    } else {
-      vec_fcn_ = vec_fcn;
-    }
+    vec_fcn_ = vec_fcn;
 
     // Expression a + A*du in Lifted Newton (Section 2.1 in Alberspeyer2010)
     MX du = msym("du",nx_);   // Step in u
@@ -525,12 +510,22 @@ namespace CasADi{
       cout << "Generated step expansion function ( " << exp_fcn.getAlgorithmSize() << " nodes)." << endl;
     }
   
-    // Generate c code and load as DLL
+    exp_fcn_ = exp_fcn;
+  
+    // Generate c code for all functions, compile in parallel and load as DLLs
     if(codegen_){
-      exp_fcn_ = dynamicCompilation(exp_fcn,"exp_fcn","step expansion function",compiler);
-    } else {
-      exp_fcn_ = exp_fcn;
-    }  
+      vector<FX> fcn(4);
+      vector<string> fname(4), fdescr(4);
+      fcn[0] = res_fcn_; fname[0] = "res_fcn"; fdescr[0] = "residual function";
+      fcn[1] = mat_fcn_; fname[1] = "mat_fcn"; fdescr[1] = "Matrices function";
+      fcn[2] = vec_fcn_; fname[2] = "vec_fcn"; fdescr[2] = "linearization function";
+      fcn[3] = exp_fcn_; fname[3] = "exp_fcn"; fdescr[3] = "step expansion function";
+      fcn = dynamicCompilation(fcn,fname,fdescr,compiler);
+      res_fcn_ = fcn[0];
+      mat_fcn_ = fcn[1];
+      vec_fcn_ = fcn[2];
+      exp_fcn_ = fcn[3];
+    }
   
     // Allocate QP data
     CRSSparsity sp_tr_B_obj = mat_fcn_.output(mat_hes_).sparsity().transpose();
@@ -32,6 +32,7 @@
 #include <fstream>
 #include <cmath>
 #include <cfloat>
+#include <limits>
 
 using namespace std;
 namespace CasADi{
@@ -40,7 +41,7 @@ namespace CasADi{
     casadi_warning("The SQP method is under development");
     addOption("qp_solver",         OT_QPSOLVER,   GenericType(),    "The QP solver to be used by the SQP method");
     addOption("qp_solver_options", OT_DICTIONARY, GenericType(),    "Options to be passed to the QP solver");
-    addOption("hessian_approximation", OT_STRING, "exact",          "limited-memory|exact");
+    addOption("hessian_approximation", OT_STRING, "exact",          "limited-memory|exact|partitioned");
     addOption("max_iter",           OT_INTEGER,      50,            "Maximum number of SQP iterations");
     addOption("max_iter_ls",        OT_INTEGER,       3,            "Maximum number of linesearch iterations");
     addOption("tol_pr",            OT_REAL,       1e-6,             "Stopping criterion for primal infeasibility");
@@ -49,6 +50,8 @@ namespace CasADi{
     addOption("beta",              OT_REAL,       0.8,              "Line-search parameter, restoration factor of stepsize");
     addOption("merit_memory",      OT_INTEGER,      4,              "Size of memory to store history of merit function values");
     addOption("lbfgs_memory",      OT_INTEGER,     10,              "Size of L-BFGS memory.");
+    addOption("lbfgs_compact",     OT_BOOLEAN,  false,              "Store the last lbfgs_memory BFGS pairs instead of a dense Hessian approximation "
+                                                                    "and pass it to the QP solver through 2*lbfgs_memory auxiliary variables.");
     addOption("regularize",        OT_BOOLEAN,  false,              "Automatic regularization of Lagrange Hessian.");
     addOption("print_header",      OT_BOOLEAN,   true,              "Print the header with problem statistics");
   
@@ -75,21 +78,63 @@ namespace CasADi{
     tol_du_ = getOption("tol_du");
     regularize_ = getOption("regularize");
     exact_hessian_ = getOption("hessian_approximation")=="exact";
+    partitioned_ = getOption("hessian_approximation")=="partitioned";
+    lbfgs_compact_ = getOption("lbfgs_compact");
+    if(lbfgs_compact_ && (exact_hessian_ || partitioned_)){
+      casadi_warning("SQPInternal::init: Option \"lbfgs_compact\" ignored, it only applies to the \"limited-memory\" Hessian approximation.");
+      lbfgs_compact_ = false;
+    }
+    casadi_assert_message(lbfgs_memory_>0, "SQPInternal::init: Option \"lbfgs_memory\" must be positive.");
   
     // Get/generate required functions
-    gradF();
-    jacG();
+    if(!fused_){
+      gradF();
+      jacG();
+    }
     if(exact_hessian_){
       hessLag();
     }
 
     // Allocate a QP solver
-    CRSSparsity H_sparsity = exact_hessian_ ? hessLag().output().sparsity() : sp_dense(nx_,nx_);
-    H_sparsity = H_sparsity + DMatrix::eye(nx_).sparsity();
-    CRSSparsity A_sparsity = jacG().isNull() ? CRSSparsity(0,nx_,false) : jacG().output().sparsity();
+    CRSSparsity A_sparsity;
+    if(fused_){
+      A_sparsity = fusedJacGSparsity();
+    } else {
+      A_sparsity = jacG().isNull() ? CRSSparsity(0,nx_,false) : jacG().output().sparsity();
+    }
+    CRSSparsity H_sparsity, qp_H_sparsity, qp_A_sparsity;
+    if(lbfgs_compact_){
+      // The QP is formulated in the lifted variables
+      lbfgs_init(qp_H_sparsity,qp_A_sparsity,A_sparsity);
+    } else if(partitioned_){
+      // Diagonal blocks of the Lagrangian Hessian, which are the strongly connected components of its (symmetric) sparsity pattern
+      CRSSparsity sp = spHessLag() + DMatrix::eye(nx_).sparsity();
+      int nblocks = sp.stronglyConnectedComponents(bfgs_block_index_,bfgs_block_offset_);
+      vector<int> block(nx_);
+      for(int b=0; b<nblocks; ++b){
+        sort(bfgs_block_index_.begin()+bfgs_block_offset_[b],bfgs_block_index_.begin()+bfgs_block_offset_[b+1]);
+        for(int el=bfgs_block_offset_[b]; el<bfgs_block_offset_[b+1]; ++el) block[bfgs_block_index_[el]] = b;
+      }
+
+      // Dense diagonal blocks
+      vector<int> rowind(1,0), col;
+      for(int i=0; i<nx_; ++i){
+        int b = block[i];
+        col.insert(col.end(),bfgs_block_index_.begin()+bfgs_block_offset_[b],bfgs_block_index_.begin()+bfgs_block_offset_[b+1]);
+        rowind.push_back(col.size());
+      }
+      H_sparsity = CRSSparsity(nx_,nx_,col,rowind);
+      qp_H_sparsity = H_sparsity;
+      qp_A_sparsity = A_sparsity;
+    } else {
+      H_sparsity = exact_hessian_ ? hessLag().output().sparsity() : sp_dense(nx_,nx_);
+      H_sparsity = H_sparsity + DMatrix::eye(nx_).sparsity();
+      qp_H_sparsity = H_sparsity;
+      qp_A_sparsity = A_sparsity;
+    }
 
     QPSolverCreator qp_solver_creator = getOption("qp_solver");
-    qp_solver_ = qp_solver_creator(qpStruct("h",H_sparsity,"a",A_sparsity));
+    qp_solver_ = qp_solver_creator(qpStruct("h",qp_H_sparsity,"a",qp_A_sparsity));
 
     // Set options if provided
     if(hasSetOption("qp_solver_options")){
@@ -116,7 +161,9 @@ namespace CasADi{
     gk_cand_.resize(ng_);
   
     // Hessian approximation
-    Bk_ = DMatrix(H_sparsity);
+    if(!lbfgs_compact_){
+      Bk_ = DMatrix(H_sparsity);
+    }
   
     // Jacobian
     Jk_ = DMatrix(A_sparsity);
@@ -136,7 +183,7 @@ namespace CasADi{
     gf_.resize(nx_);
 
     // Create Hessian update function
-    if(!exact_hessian_){
+    if(!exact_hessian_ && !lbfgs_compact_ && !partitioned_){
       // Create expressions corresponding to Bk, x, x_old, gLag and gLag_old
       SXMatrix Bk = ssym("Bk",H_sparsity);
       SXMatrix x = ssym("x",input(NLP_SOLVER_X0).sparsity());
@@ -169,8 +216,10 @@ namespace CasADi{
       bfgs_.setOption("number_of_fwd_dir",0);
       bfgs_.setOption("number_of_adj_dir",0);
       bfgs_.init();
-    
-      // Initial Hessian approximation
+    }
+
+    // Initial Hessian approximation
+    if(!exact_hessian_ && !lbfgs_compact_){
       B_init_ = DMatrix::eye(nx_);
     }
   
@@ -180,6 +229,10 @@ namespace CasADi{
       cout << "This is CasADi::SQPMethod." << endl;
       if(exact_hessian_){
         cout << "Using exact Hessian" << endl;
+      } else if(partitioned_){
+        cout << "Using partitioned BFGS Hessian approximation (" << bfgs_block_offset_.size()-1 << " blocks)" << endl;
+      } else if(lbfgs_compact_){
+        cout << "Using compact limited memory BFGS Hessian approximation (" << lbfgs_memory_ << " pairs)" << endl;
       } else {
         cout << "Using limited memory BFGS Hessian approximation" << endl;
       }
@@ -187,7 +240,11 @@ namespace CasADi{
       cout << "Number of variables:                       " << setw(9) << nx_ << endl;
       cout << "Number of constraints:                     " << setw(9) << ng_ << endl;
       cout << "Number of nonzeros in constraint Jacobian: " << setw(9) << A_sparsity.size() << endl;
-      cout << "Number of nonzeros in Lagrangian Hessian:  " << setw(9) << H_sparsity.size() << endl;
+      if(lbfgs_compact_){
+        cout << "Number of nonzeros in lifted QP Hessian:   " << setw(9) << qp_H_sparsity.size() << endl;
+      } else {
+        cout << "Number of nonzeros in Lagrangian Hessian:  " << setw(9) << H_sparsity.size() << endl;
+      }
       cout << endl;
     }
   }
@@ -196,6 +253,9 @@ namespace CasADi{
     casadi_assert(nfdir==0 && nadir==0);
   
     checkInitialBounds();
+
+    // The parameters may have changed since the last solve
+    resetFusedOracle();
   
     // Get problem data
     const vector<double>& x_init = input(NLP_SOLVER_X0).data();
@@ -304,11 +364,15 @@ namespace CasADi{
       transform(ubg.begin(),ubg.end(),gk_.begin(),qp_UBA_.begin(),minus<double>());
 
       // Solve the QP
-      solve_QP(Bk_,gf_,qp_LBX_,qp_UBX_,Jk_,qp_LBA_,qp_UBA_,dx_,qp_DUAL_X_,qp_DUAL_A_);
+      if(lbfgs_compact_){
+        solve_QP_lbfgs(gf_,qp_LBX_,qp_UBX_,Jk_,qp_LBA_,qp_UBA_,dx_,qp_DUAL_X_,qp_DUAL_A_);
+      } else {
+        solve_QP(Bk_,gf_,qp_LBX_,qp_UBX_,Jk_,qp_LBA_,qp_UBA_,dx_,qp_DUAL_X_,qp_DUAL_A_);
+      }
       log("QP solved");
 
       // Detecting indefiniteness
-      double gain = quad_form(dx_,Bk_);
+      double gain = lbfgs_compact_ ? lbfgs_mul(dx_,lbfgs_w_) : quad_form(dx_,Bk_);
       if (gain < 0){
         casadi_warning("Indefinite Hessian detected...");
       }
@@ -408,7 +472,10 @@ namespace CasADi{
       transform(gLag_.begin(),gLag_.end(),mu_x_.begin(),gLag_.begin(),plus<double>());
 
       // Updating Lagrange Hessian
-      if( !exact_hessian_){
+      if(lbfgs_compact_){
+        log("Updating Hessian (compact L-BFGS)");
+        lbfgs_update(x_,x_old_,gLag_,gLag_old_);
+      } else if( !exact_hessian_){
         log("Updating Hessian (BFGS)");
         // BFGS with careful updates and restarts
         if (iter % lbfgs_memory_ == 0){
@@ -423,18 +490,23 @@ namespace CasADi{
           }
         }
       
-        // Pass to BFGS update function
-        bfgs_.setInput(Bk_,BFGS_BK);
-        bfgs_.setInput(x_,BFGS_X);
-        bfgs_.setInput(x_old_,BFGS_X_OLD);
-        bfgs_.setInput(gLag_,BFGS_GLAG);
-        bfgs_.setInput(gLag_old_,BFGS_GLAG_OLD);
+        if(partitioned_){
+          // Update each block separately
+          partitioned_update(x_,x_old_,gLag_,gLag_old_);
+        } else {
+          // Pass to BFGS update function
+          bfgs_.setInput(Bk_,BFGS_BK);
+          bfgs_.setInput(x_,BFGS_X);
+          bfgs_.setInput(x_old_,BFGS_X_OLD);
+          bfgs_.setInput(gLag_,BFGS_GLAG);
+          bfgs_.setInput(gLag_old_,BFGS_GLAG_OLD);
       
-        // Update the Hessian approximation
-        bfgs_.evaluate();
+          // Update the Hessian approximation
+          bfgs_.evaluate();
       
-        // Get the updated Hessian
-        bfgs_.getOutput(Bk_);
+          // Get the updated Hessian
+          bfgs_.getOutput(Bk_);
+        }
       } else {
         // Exact Hessian
         log("Evaluating hessian");
@@ -451,6 +523,10 @@ namespace CasADi{
   
     // Save statistics
     stats_["iter_count"] = iter;
+    if(fused_){
+      stats_["fused_oracle_evaluations"] = fused_num_eval_;
+      stats_["fused_oracle_reuses"] = fused_num_reuse_;
+    }
   }
   
   void SQPInternal::printIteration(std::ostream &stream){
@@ -513,7 +589,17 @@ namespace CasADi{
 
   void SQPInternal::reset_h(){
     // Initial Hessian approximation of BFGS
-    if ( !exact_hessian_){
+    if(lbfgs_compact_){
+      lbfgs_s_.clear();
+      lbfgs_y_.clear();
+      lbfgs_delta_ = 1;
+      lbfgs_factorize();
+      if(monitored("eval_h")){
+        cout << "x = " << x_ << endl;
+        cout << "H = " << lbfgs_delta_ << "*I" << endl;
+      }
+      return;
+    } else if( !exact_hessian_){
       Bk_.set(B_init_);
     }
 
@@ -524,6 +610,52 @@ namespace CasADi{
     }
   }
 
+  void SQPInternal::partitioned_update(const std::vector<double>& x, const std::vector<double>& x_old,
+                                       const std::vector<double>& gLag, const std::vector<double>& gLag_old){
+    const vector<int>& rowind = Bk_.rowind();
+    vector<double>& data = Bk_.data();
+    vector<double> s, y, q;
+    for(int b=0; b+1<bfgs_block_offset_.size(); ++b){
+      // Indices of the block, the nonzeros of row idx[i] are then B_b(i,j) = data[rowind[idx[i]]+j]
+      const int* idx = getPtr(bfgs_block_index_) + bfgs_block_offset_[b];
+      int nb = bfgs_block_offset_[b+1] - bfgs_block_offset_[b];
+      s.resize(nb);
+      y.resize(nb);
+      q.resize(nb);
+
+      // Step and Lagrangian gradient difference restricted to the block
+      for(int i=0; i<nb; ++i){
+        s[i] = x[idx[i]] - x_old[idx[i]];
+        y[i] = gLag[idx[i]] - gLag_old[idx[i]];
+      }
+
+      // q = B_b*s
+      for(int i=0; i<nb; ++i){
+        const double* B_row = getPtr(data) + rowind[idx[i]];
+        q[i] = 0;
+        for(int j=0; j<nb; ++j) q[i] += B_row[j]*s[j];
+      }
+      double skBksk = inner_prod(s,q);
+
+      // No update for a block that did not move
+      if(!(skBksk>0)) continue;
+
+      // Powell damping
+      double sy = inner_prod(s,y);
+      if(sy < 0.2*skBksk){
+        double omega = 0.8*skBksk/(skBksk - sy);
+        for(int i=0; i<nb; ++i) y[i] = omega*y[i] + (1-omega)*q[i];
+        sy = inner_prod(s,y);
+      }
+
+      // B_b += y*y'/(y'*s) - q*q'/(s'*B_b*s)
+      for(int i=0; i<nb; ++i){
+        double* B_row = getPtr(data) + rowind[idx[i]];
+        for(int j=0; j<nb; ++j) B_row[j] += y[i]*y[j]/sy - q[i]*q[j]/skBksk;
+      }
+    }
+  }
+
   double SQPInternal::getRegularization(const Matrix<double>& H){
     const vector<int>& rowind = H.rowind();
     const vector<int>& col = H.col();
@@ -602,6 +734,17 @@ namespace CasADi{
       
       // Quick return if no constraints
       if(ng_==0) return;
+
+      // Fused evaluation
+      if(fused_){
+        evalFusedOracle(getPtr(x),FUSED_FG);
+        getFusedG(getPtr(g));
+        if(monitored("eval_g")){
+          cout << "x = " << x << endl;
+          cout << "g = " << g << endl;
+        }
+        return;
+      }
       
       // Pass the argument to the function
       nlp_.setInput(x,NL_X);
@@ -628,20 +771,27 @@ namespace CasADi{
     try{
       // Quich finish if no constraints
       if(ng_==0) return;
-    
-      // Get function
-      FX& jacG = this->jacG();
 
-      // Pass the argument to the function
-      jacG.setInput(x,NL_X);
-      jacG.setInput(input(NLP_SOLVER_P),NL_P);
+      if(fused_){
+        // Fused evaluation
+        evalFusedOracle(getPtr(x),FUSED_JAC_G);
+        getFusedG(getPtr(g));
+        getFusedJacG(getPtr(J.data()));
+      } else {
+        // Get function
+        FX& jacG = this->jacG();
+
+        // Pass the argument to the function
+        jacG.setInput(x,NL_X);
+        jacG.setInput(input(NLP_SOLVER_P),NL_P);
       
-      // Evaluate the function
-      jacG.evaluate();
+        // Evaluate the function
+        jacG.evaluate();
       
-      // Get the output
-      jacG.output(1+NL_G).get(g,DENSE);
-      jacG.output().get(J);
+        // Get the output
+        jacG.output(1+NL_G).get(g,DENSE);
+        jacG.output().get(J);
+      }
 
       if (monitored("eval_jac_g")) {
         cout << "x = " << x << endl;
@@ -657,19 +807,26 @@ namespace CasADi{
 
   void SQPInternal::eval_grad_f(const std::vector<double>& x, double& f, std::vector<double>& grad_f){
     try {
-      // Get function
-      FX& gradF = this->gradF();
+      if(fused_){
+        // Fused evaluation
+        evalFusedOracle(getPtr(x),FUSED_GRAD_F);
+        getFusedGradF(getPtr(grad_f));
+        f = fusedF();
+      } else {
+        // Get function
+        FX& gradF = this->gradF();
 
-      // Pass the argument to the function
-      gradF.setInput(x,NL_X);
-      gradF.setInput(input(NLP_SOLVER_P),NL_P);
+        // Pass the argument to the function
+        gradF.setInput(x,NL_X);
+        gradF.setInput(input(NLP_SOLVER_P),NL_P);
       
-      // Evaluate, adjoint mode
-      gradF.evaluate();
+        // Evaluate, adjoint mode
+        gradF.evaluate();
       
-      // Get the result
-      gradF.output().get(grad_f,DENSE);
-      gradF.output(1+NL_X).get(f);
+        // Get the result
+        gradF.output().get(grad_f,DENSE);
+        gradF.output(1+NL_X).get(f);
+      }
       
       // Printing
       if (monitored("eval_f")){
@@ -689,6 +846,17 @@ namespace CasADi{
   
   void SQPInternal::eval_f(const std::vector<double>& x, double& f){
     try {
+      // Fused evaluation
+      if(fused_){
+        evalFusedOracle(getPtr(x),FUSED_FG);
+        f = fusedF();
+        if(monitored("eval_f")){
+          cout << "x = " << x << endl;
+          cout << "f = " << f << endl;
+        }
+        return;
+      }
+
       // Pass the argument to the function
       nlp_.setInput(x,NL_X);
       nlp_.setInput(input(NLP_SOLVER_P),NL_P);
@@ -780,4 +948,231 @@ namespace CasADi{
     return pr_inf;
   }  
 
+  void SQPInternal::lbfgs_init(CRSSparsity& H_sparsity, CRSSparsity& A_sparsity, const CRSSparsity& J_sparsity){
+    // The approximation B = B_p of the p stored pairs is defined by B_0 = delta*I and
+    //   B_{i+1} = P_i'*B_i*P_i + b_i*b_i',  P_i = I - s_i*c_i'
+    // Introducing t_i = c_i'*e_{i+1}, u_i = b_i'*e_{i+1} with e_i = dx - sum_{j>=i} s_j*t_j gives
+    //   dx'*B*dx = delta*|dx - S*t|^2 + |u|^2
+    // which is convex in the lifted variables z = [dx; t; u] and only needs O(nx*lbfgs_memory) nonzeros
+    int m = lbfgs_memory_;
+    int nz = nx_ + 2*m;
+
+    // Hessian of the lifted QP: [delta*I, -delta*S, 0; -delta*S', delta*S'*S, 0; 0, 0, I]
+    vector<int> rowind(1,0), col;
+    for(int i=0; i<nx_; ++i){
+      col.push_back(i);
+      for(int j=0; j<m; ++j) col.push_back(nx_+j);
+      rowind.push_back(col.size());
+    }
+    for(int i=0; i<m; ++i){
+      for(int j=0; j<nx_+m; ++j) col.push_back(j);
+      rowind.push_back(col.size());
+    }
+    for(int i=0; i<m; ++i){
+      col.push_back(nx_+m+i);
+      rowind.push_back(col.size());
+    }
+    H_sparsity = CRSSparsity(nz,nz,col,rowind);
+
+    // Constraints of the lifted QP: the linearized constraints followed by the definitions of t and u
+    rowind.resize(J_sparsity.size1()+1);
+    copy(J_sparsity.rowind().begin(),J_sparsity.rowind().end(),rowind.begin());
+    col = J_sparsity.col();
+    for(int i=0; i<m; ++i){
+      for(int j=0; j<nx_; ++j) col.push_back(j);
+      for(int j=i; j<m; ++j) col.push_back(nx_+j);
+      rowind.push_back(col.size());
+    }
+    for(int i=0; i<m; ++i){
+      for(int j=0; j<nx_; ++j) col.push_back(j);
+      for(int j=i+1; j<m; ++j) col.push_back(nx_+j);
+      col.push_back(nx_+m+i);
+      rowind.push_back(col.size());
+    }
+    A_sparsity = CRSSparsity(ng_+2*m,nz,col,rowind);
+
+    // Allocate the QP data, the auxiliary variables are free and the lifting rows are equalities.
+    // Assigned rather than resized, since init may be called again with different dimensions
+    lbfgs_H_ = DMatrix(H_sparsity,0);
+    lbfgs_A_ = DMatrix(A_sparsity,0);
+    lbfgs_g_.assign(nz,0);
+    lbfgs_lbz_.assign(nz,-numeric_limits<double>::infinity());
+    lbfgs_ubz_.assign(nz,numeric_limits<double>::infinity());
+    lbfgs_lba_.assign(ng_+2*m,0);
+    lbfgs_uba_.assign(ng_+2*m,0);
+    lbfgs_z_.assign(nz,0);
+    lbfgs_lam_z_.assign(nz,0);
+    lbfgs_lam_a_.assign(ng_+2*m,0);
+    lbfgs_v_.assign(nx_,0);
+    lbfgs_w_.assign(nx_,0);
+
+    // No stored pairs
+    lbfgs_s_.clear();
+    lbfgs_y_.clear();
+    lbfgs_c_.clear();
+    lbfgs_b_.clear();
+    lbfgs_delta_ = 1;
+  }
+
+  double SQPInternal::lbfgs_mul(const std::vector<double>& v, std::vector<double>& w, int npairs){
+    if(npairs<0) npairs = lbfgs_s_.size();
+
+    // Backward sweep: v_i = P_i*v_{i+1}, saving b_i'*v_{i+1}
+    vector<double> beta(npairs);
+    copy(v.begin(),v.end(),lbfgs_v_.begin());
+    for(int i=npairs-1; i>=0; --i){
+      const vector<double>& s = lbfgs_s_[i];
+      beta[i] = inner_prod(lbfgs_b_[i],lbfgs_v_);
+      double alpha = inner_prod(lbfgs_c_[i],lbfgs_v_);
+      for(int k=0; k<nx_; ++k) lbfgs_v_[k] -= alpha*s[k];
+    }
+
+    // Forward sweep: w_{i+1} = P_i'*w_i + b_i*(b_i'*v_{i+1})
+    w.resize(nx_);
+    for(int k=0; k<nx_; ++k) w[k] = lbfgs_delta_*lbfgs_v_[k];
+    for(int i=0; i<npairs; ++i){
+      const vector<double>& c = lbfgs_c_[i];
+      const vector<double>& b = lbfgs_b_[i];
+      double gamma = inner_prod(lbfgs_s_[i],w);
+      for(int k=0; k<nx_; ++k) w[k] += beta[i]*b[k] - gamma*c[k];
+    }
+    return inner_prod(v,w);
+  }
+
+  void SQPInternal::lbfgs_factorize(){
+    int p = lbfgs_s_.size();
+    lbfgs_c_.resize(p);
+    lbfgs_b_.resize(p);
+    for(int i=0; i<p; ++i){
+      // c_i = B_i*s_i/(s_i'*B_i*s_i), only depends on the pairs before i
+      double sBs = lbfgs_mul(lbfgs_s_[i],lbfgs_c_[i],i);
+      for(vector<double>::iterator it=lbfgs_c_[i].begin(); it!=lbfgs_c_[i].end(); ++it) *it /= sBs;
+
+      // b_i = y_i/sqrt(y_i'*s_i)
+      double ys = sqrt(inner_prod(lbfgs_y_[i],lbfgs_s_[i]));
+      lbfgs_b_[i] = lbfgs_y_[i];
+      for(vector<double>::iterator it=lbfgs_b_[i].begin(); it!=lbfgs_b_[i].end(); ++it) *it /= ys;
+    }
+  }
+
+  void SQPInternal::lbfgs_update(const std::vector<double>& x, const std::vector<double>& x_old,
+                                 const std::vector<double>& gLag, const std::vector<double>& gLag_old){
+    vector<double> s(nx_), y(nx_);
+    transform(x.begin(),x.end(),x_old.begin(),s.begin(),minus<double>());
+    transform(gLag.begin(),gLag.end(),gLag_old.begin(),y.begin(),minus<double>());
+
+    // Curvature of the current approximation along the step, skip the update for a vanishing step
+    double sBs = lbfgs_mul(s,lbfgs_w_);
+    if(!(sBs>0)) return;
+
+    // Powell damping, as in the dense update
+    double sy = inner_prod(s,y);
+    if(sy < 0.2*sBs){
+      double omega = 0.8*sBs/(sBs - sy);
+      for(int k=0; k<nx_; ++k) y[k] = omega*y[k] + (1-omega)*lbfgs_w_[k];
+      sy = inner_prod(s,y);
+    }
+
+    // Add to memory, dropping the oldest pair
+    lbfgs_s_.push_back(s);
+    lbfgs_y_.push_back(y);
+    if(lbfgs_s_.size()>lbfgs_memory_){
+      lbfgs_s_.pop_front();
+      lbfgs_y_.pop_front();
+    }
+
+    // Scale the initial approximation with the newest pair
+    lbfgs_delta_ = inner_prod(y,y)/sy;
+    lbfgs_factorize();
+  }
+
+  void SQPInternal::solve_QP_lbfgs(const std::vector<double>& g, const std::vector<double>& lbx, const std::vector<double>& ubx,
+                                   const Matrix<double>& A, const std::vector<double>& lbA, const std::vector<double>& ubA,
+                                   std::vector<double>& x_opt, std::vector<double>& lambda_x_opt, std::vector<double>& lambda_A_opt){
+    int m = lbfgs_memory_;
+    int p = lbfgs_s_.size();
+    const double delta = lbfgs_delta_;
+
+    // Inner products s_i'*s_j, c_i'*s_j and b_i'*s_j
+    vector<double> ss(p*p), cs(p*p), bs(p*p);
+    for(int i=0; i<p; ++i){
+      for(int j=0; j<p; ++j){
+        ss[i+j*p] = inner_prod(lbfgs_s_[i],lbfgs_s_[j]);
+        cs[i+j*p] = inner_prod(lbfgs_c_[i],lbfgs_s_[j]);
+        bs[i+j*p] = inner_prod(lbfgs_b_[i],lbfgs_s_[j]);
+      }
+    }
+
+    // Hessian of the lifted QP, same nonzero order as in lbfgs_init
+    vector<double>& H = lbfgs_H_.data();
+    int el = 0;
+    for(int k=0; k<nx_; ++k){
+      H[el++] = delta;
+      for(int j=0; j<m; ++j) H[el++] = j<p ? -delta*lbfgs_s_[j][k] : 0;
+    }
+    for(int i=0; i<m; ++i){
+      for(int k=0; k<nx_; ++k) H[el++] = i<p ? -delta*lbfgs_s_[i][k] : 0;
+      for(int j=0; j<m; ++j) H[el++] = i<p && j<p ? delta*ss[i+j*p] : 0;
+    }
+    for(int i=0; i<m; ++i) H[el++] = 1;
+
+    // Constraints of the lifted QP, unused slots give t_i = u_i = 0
+    vector<double>& AA = lbfgs_A_.data();
+    copy(A.begin(),A.end(),AA.begin());
+    el = A.size();
+    for(int i=0; i<m; ++i){
+      for(int k=0; k<nx_; ++k) AA[el++] = i<p ? -lbfgs_c_[i][k] : 0;
+      AA[el++] = 1;
+      for(int j=i+1; j<m; ++j) AA[el++] = j<p ? cs[i+j*p] : 0;
+    }
+    for(int i=0; i<m; ++i){
+      for(int k=0; k<nx_; ++k) AA[el++] = i<p ? -lbfgs_b_[i][k] : 0;
+      for(int j=i+1; j<m; ++j) AA[el++] = j<p ? bs[i+j*p] : 0;
+      AA[el++] = 1;
+    }
+
+    // Linear term, bounds and initial guess
+    copy(g.begin(),g.end(),lbfgs_g_.begin());
+    copy(lbx.begin(),lbx.end(),lbfgs_lbz_.begin());
+    copy(ubx.begin(),ubx.end(),lbfgs_ubz_.begin());
+    copy(lbA.begin(),lbA.end(),lbfgs_lba_.begin());
+    copy(ubA.begin(),ubA.end(),lbfgs_uba_.begin());
+    copy(x_opt.begin(),x_opt.end(),lbfgs_z_.begin());
+
+    // Pass data to QP solver
+    qp_solver_.setInput(lbfgs_H_,QP_SOLVER_H);
+    qp_solver_.setInput(lbfgs_g_,QP_SOLVER_G);
+    qp_solver_.setInput(lbfgs_z_,QP_SOLVER_X0);
+    qp_solver_.setInput(lbfgs_lbz_,QP_SOLVER_LBX);
+    qp_solver_.setInput(lbfgs_ubz_,QP_SOLVER_UBX);
+    qp_solver_.setInput(lbfgs_A_,QP_SOLVER_A);
+    qp_solver_.setInput(lbfgs_lba_,QP_SOLVER_LBA);
+    qp_solver_.setInput(lbfgs_uba_,QP_SOLVER_UBA);
+
+    if (monitored("qp")) {
+      cout << "delta = " << delta << ", number of pairs = " << p << endl;
+      cout << "A = " << endl;
+      A.printDense();
+      cout << "g = " << g << endl;
+      cout << "lbx = " << lbx << endl;
+      cout << "ubx = " << ubx << endl;
+      cout << "lbA = " << lbA << endl;
+      cout << "ubA = " << ubA << endl;
+    }
+
+    // Solve the QP
+    qp_solver_.evaluate();
+
+    // Get the optimal solution, dropping the auxiliary variables and constraints
+    qp_solver_.getOutput(lbfgs_z_,QP_SOLVER_X);
+    qp_solver_.getOutput(lbfgs_lam_z_,QP_SOLVER_LAM_X);
+    qp_solver_.getOutput(lbfgs_lam_a_,QP_SOLVER_LAM_A);
+    copy(lbfgs_z_.begin(),lbfgs_z_.begin()+nx_,x_opt.begin());
+    copy(lbfgs_lam_z_.begin(),lbfgs_lam_z_.begin()+nx_,lambda_x_opt.begin());
+    copy(lbfgs_lam_a_.begin(),lbfgs_lam_a_.begin()+ng_,lambda_A_opt.begin());
+    if (monitored("dx")){
+      cout << "dx = " << x_opt << endl;
+    }
+  }
+
 } // namespace CasADi
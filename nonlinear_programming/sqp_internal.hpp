@@ -46,11 +46,20 @@ public:
   /// Exact Hessian?
   bool exact_hessian_;
 
+  /// Partitioned BFGS, one dense update per diagonal block of the Lagrangian Hessian?
+  bool partitioned_;
+
+  /// Diagonal blocks for partitioned BFGS: block i has the (sorted) indices index[offset[i]], ..., index[offset[i+1]-1]
+  std::vector<int> bfgs_block_offset_, bfgs_block_index_;
+
   /// maximum number of sqp iterations
   int max_iter_; 
 
   /// Memory size of L-BFGS method
   int lbfgs_memory_;
+
+  /// Compact (stored pairs) L-BFGS representation?
+  bool lbfgs_compact_;
   /// Tolerance of primal infeasibility
   double tol_pr_;
   /// Tolerance of dual infeasibility
@@ -111,6 +120,23 @@ public:
   /// Regularization
   bool regularize_;
 
+  /// Compact L-BFGS: stored pairs, oldest first
+  std::deque<std::vector<double> > lbfgs_s_, lbfgs_y_;
+
+  /// Compact L-BFGS: scaling of the initial approximation delta*I
+  double lbfgs_delta_;
+
+  /// Compact L-BFGS: c_i = B_i*s_i/(s_i'*B_i*s_i) and b_i = y_i/sqrt(y_i'*s_i) of the product form
+  std::vector<std::vector<double> > lbfgs_c_, lbfgs_b_;
+
+  /// Compact L-BFGS: lifted QP data (variables [dx; t; u], constraints [J*dx; lifting rows])
+  DMatrix lbfgs_H_, lbfgs_A_;
+  std::vector<double> lbfgs_g_, lbfgs_lbz_, lbfgs_ubz_, lbfgs_lba_, lbfgs_uba_;
+  std::vector<double> lbfgs_z_, lbfgs_lam_z_, lbfgs_lam_a_;
+
+  /// Compact L-BFGS: work vectors
+  std::vector<double> lbfgs_v_, lbfgs_w_;
+
   // Storage for merit function
   std::deque<double> merit_mem_;
 
@@ -124,6 +150,10 @@ public:
   // Reset the Hessian or Hessian approximation
   void reset_h();
 
+  // Damped BFGS update of each diagonal block of the Hessian approximation
+  void partitioned_update(const std::vector<double>& x, const std::vector<double>& x_old,
+                          const std::vector<double>& gLag, const std::vector<double>& gLag_old);
+
   // Evaluate the gradient of the objective
   virtual void eval_f(const std::vector<double>& x, double& f);
   
@@ -157,6 +187,24 @@ public:
   
   /// Calculates inner_prod(x,mul(A,x))
   static double quad_form(const std::vector<double>& x, const DMatrix& A);
+
+  /// Allocate the lifted QP structure for the compact L-BFGS representation
+  void lbfgs_init(CRSSparsity& H_sparsity, CRSSparsity& A_sparsity, const CRSSparsity& J_sparsity);
+
+  /// Add a pair (s,y) to the compact L-BFGS memory, with Powell damping
+  void lbfgs_update(const std::vector<double>& x, const std::vector<double>& x_old,
+                    const std::vector<double>& gLag, const std::vector<double>& gLag_old);
+
+  /// Update c_i and b_i after the memory has changed
+  void lbfgs_factorize();
+
+  /// Calculates w = B*v for the compact L-BFGS approximation (first npairs pairs, all if negative), returns inner_prod(v,w)
+  double lbfgs_mul(const std::vector<double>& v, std::vector<double>& w, int npairs=-1);
+
+  /// Solve the QP subproblem with the compact L-BFGS approximation through the lifted formulation
+  void solve_QP_lbfgs(const std::vector<double>& g, const std::vector<double>& lbx, const std::vector<double>& ubx,
+                      const Matrix<double>& A, const std::vector<double>& lbA, const std::vector<double>& ubA,
+                      std::vector<double>& x_opt, std::vector<double>& lambda_x_opt, std::vector<double>& lambda_A_opt);
   
 };
 
@@ -22,8 +22,10 @@
 
 %{
 #include "integration/collocation_integrator.hpp"
+#include "integration/explicit_rk_integrator.hpp"
 #include "integration/integration_tools.hpp"
 %}
 
 %include "integration/collocation_integrator.hpp"
+%include "integration/explicit_rk_integrator.hpp"
 %include "integration/integration_tools.hpp"
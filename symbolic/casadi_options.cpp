@@ -26,5 +26,7 @@ namespace CasADi {
 
   bool CasadiOptions::catch_errors_python = true;
   bool CasadiOptions::simplification_on_the_fly = true;
+  std::string CasadiOptions::compilation_cache_dir = "";
+  std::string CasadiOptions::sparsity_cache_dir = "";
 
 }
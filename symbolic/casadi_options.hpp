@@ -23,6 +23,8 @@
 #ifndef CASADI_OPTIONS_HPP
 #define CASADI_OPTIONS_HPP
 
+#include <string>
+
 namespace CasADi {
   /**
   * \brief Collects global CasADi options
@@ -57,6 +59,21 @@ namespace CasADi {
       * Default: true
       */
       static bool simplification_on_the_fly;
+
+      /** \brief Directory used to cache dynamically compiled generated code
+      * Binaries are stored under a name containing a hash of the generated source and the compiler
+      * command and are reused instead of recompiled when found. An empty string disables the cache.
+      * Default: ""
+      */
+      static std::string compilation_cache_dir;
+
+      /** \brief Directory used to cache detected Jacobian sparsity patterns and graph colorings
+      * Stored under a name containing a hash of the structure of the function and reused, also by other processes,
+      * instead of repeating the sparsity detection and coloring. Only used by functions that provide
+      * such a hash (SXFunction). An empty string disables the cache.
+      * Default: ""
+      */
+      static std::string sparsity_cache_dir;
 #endif //SWIG
       // Setter and getter for catch_errors_python
       static void setCatchErrorsPython(bool flag) { catch_errors_python = flag; }
@@ -65,6 +82,14 @@ namespace CasADi {
       // Setter and getter for simplification_on_the_fly
       static void setSimplificationOnTheFly(bool flag) { simplification_on_the_fly = flag; }
       static bool getSimplificationOnTheFly() { return simplification_on_the_fly; }
+
+      // Setter and getter for compilation_cache_dir
+      static void setCompilationCacheDir(const std::string& dir) { compilation_cache_dir = dir; }
+      static std::string getCompilationCacheDir() { return compilation_cache_dir; }
+
+      // Setter and getter for sparsity_cache_dir
+      static void setSparsityCacheDir(const std::string& dir) { sparsity_cache_dir = dir; }
+      static std::string getSparsityCacheDir() { return sparsity_cache_dir; }
       
   };
 
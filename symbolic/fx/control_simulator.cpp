@@ -74,5 +74,15 @@ std::vector<int> ControlSimulator::getMajorIndex() const {
            return dynamic_cast<const ControlSimulatorInternal*>(get())->getCoarseIndex(); 
 }
 
+void ControlSimulator::evaluateBatch(const Matrix<double>& x0, const Matrix<double>& p, const Matrix<double>& u){
+  casadi_assert(checkNode());
+  (*this)->evaluateBatch(x0,p,u);
+}
+
+const std::vector<double>& ControlSimulator::getBatchOutput() const{
+  casadi_assert(checkNode());
+  return (*this)->batch_output_;
+}
+
 } // namespace CasADi
 
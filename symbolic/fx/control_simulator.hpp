@@ -132,6 +132,22 @@ public:
          /** \brief Get the index i such that gridminor[i] == gridmajor 
   */
          std::vector< int > getMajorIndex() const; 
+
+  /** \brief Simulate a batch of scenarios concurrently
+  * Row k of x0 (nscen-by-nx), p (nscen-by-np) and u (nscen-by-numel of input u, the control matrix flattened row-wise)
+  * holds the inputs of scenario k. A matrix with a single row is used for all scenarios.
+  * The scenarios are distributed over a pool of threads (option 'batch_num_threads'), each thread simulating with its own deep copy
+  * of this ControlSimulator. The inputs and outputs of the ControlSimulator itself are not touched.
+  * With statistics enabled, the time spent for each scenario is available as 'batch_scenario_time'.
+  */
+  void evaluateBatch(const Matrix<double>& x0, const Matrix<double>& p, const Matrix<double>& u);
+
+  /** \brief Get the results of the last batch
+  * Block of dimension nscen-by-ngrid-by-nout, element (k,j,i) is found at index (k*ngrid + j)*nout + i.
+  * ngrid is the length of the minor time grid and nout the number of elements of the outputs, concatenated.
+  * The block is preallocated and reused by subsequent batches.
+  */
+  const std::vector<double>& getBatchOutput() const;
          
 };
   
@@ -27,6 +27,7 @@
 #include "../sx/sx_tools.hpp"
 #include "../mx/mx_tools.hpp"
 #include "fx_tools.hpp"
+#include "../thread_pool.hpp"
 #include <utility>
 #include <string>
 
@@ -35,8 +36,29 @@ INPUTSCHEME(ControlSimulatorInput)
 using namespace std;
 namespace CasADi{
 
+namespace{
+  /// Simulate the scenarios of a batch in a thread pool
+  class BatchJob : public ThreadPool::Job{
+  public:
+    explicit BatchJob(ControlSimulatorInternal* s) : s_(s){}
+    virtual void execute(int task){ s_->evaluateScenario(task,0);}
+    virtual void execute(int task, int thread){ s_->evaluateScenario(task,thread);}
+  private:
+    ControlSimulatorInternal* s_;
+  };
+
+  /// Check the dimensions of an input of a batch and return it as a dense matrix
+  Matrix<double> batchInput(const Matrix<double>& v, int nscen, int n, const string& name){
+    if(n==0) return Matrix<double>(1,0,0);
+    casadi_assert_message(v.size2()==n, "ControlSimulator::evaluateBatch: " << name << " must have " << n << " columns, but got " << v.dimString());
+    casadi_assert_message(v.size1()==nscen || v.size1()==1, "ControlSimulator::evaluateBatch: " << name << " must have one row or one row per scenario (" << nscen << "), but got " << v.dimString());
+    Matrix<double> ret = v;
+    makeDense(ret);
+    return ret;
+  }
+} // namespace
   
-ControlSimulatorInternal::ControlSimulatorInternal(const FX& control_dae, const FX& output_fcn, const vector<double>& gridc) : control_dae_(control_dae), orig_output_fcn_(output_fcn), gridc_(gridc){
+ControlSimulatorInternal::ControlSimulatorInternal(const FX& control_dae, const FX& output_fcn, const vector<double>& gridc) : control_dae_(control_dae), orig_output_fcn_(output_fcn), gridc_(gridc), batch_pool_(0){
   setOption("name","unnamed controlsimulator");
   addOption("nf",OT_INTEGER,1,"Number of minor grained integration steps per major interval. nf>0 must hold. This option is not used when 'minor_grid' is provided.");
   addOption("minor_grid",OT_INTEGERVECTOR,GenericType(),"The local grid used on each major interval, with time normalized to 1. By default, option 'nf' is used to construct a linearly spaced grid.");
@@ -45,11 +67,13 @@ ControlSimulatorInternal::ControlSimulatorInternal(const FX& control_dae, const
   addOption("simulator_options",       OT_DICTIONARY, GenericType(), "Options to be passed to the simulator");
   addOption("control_interpolation",   OT_STRING,     "none", "none|nearest|linear");
   addOption("control_endpoint",        OT_BOOLEAN,       false, "Include a control value at the end of the simulation domain. Used for interpolation.");
+  addOption("batch_num_threads",       OT_INTEGER,       0, "Number of threads used by evaluateBatch, 0 means one per processor");
   
   inputScheme_ = SCHEME_ControlSimulatorInput;
 }
   
 ControlSimulatorInternal::~ControlSimulatorInternal(){
+  delete batch_pool_;
 }
 
 
@@ -57,6 +81,9 @@ void ControlSimulatorInternal::init(){
 
   bool control_endpoint = getOption("control_endpoint");
   
+  // The copies used for batches are created again on the next batch
+  batch_workers_.clear();
+
   if (!control_dae_.isInit()) control_dae_.init();
   
   casadi_assert_message(!gridc_.empty(),"The supplied time grid must not be empty.");
@@ -421,6 +448,79 @@ void ControlSimulatorInternal::evaluate(int nfdir, int nadir){
   
 }
 
+void ControlSimulatorInternal::evaluateBatch(const Matrix<double>& x0, const Matrix<double>& p, const Matrix<double>& u){
+  casadi_assert_message(isInit(),"ControlSimulator::evaluateBatch: not initialized");
+
+  // Number of scenarios
+  int nscen = std::max(x0.size1(),std::max(p.size1(),u.size1()));
+  batch_x0_ = batchInput(x0,nscen,input(CONTROLSIMULATOR_X0).numel(),"x0");
+  batch_p_ = batchInput(p,nscen,input(CONTROLSIMULATOR_P).numel(),"p");
+  batch_u_ = batchInput(u,nscen,input(CONTROLSIMULATOR_U).numel(),"u");
+
+  // Create a new thread pool if the number of threads has changed
+  int num_threads = getOption("batch_num_threads");
+  if(num_threads<=0) num_threads = ThreadPool::numProcessors();
+  if(batch_pool_!=0 && batch_pool_->size()!=num_threads){
+    delete batch_pool_;
+    batch_pool_ = 0;
+  }
+  if(batch_pool_==0) batch_pool_ = new ThreadPool(num_threads);
+
+  // Deep copies for the threads, initialized here since initialization is not thread safe
+  batch_workers_.resize(std::min<int>(batch_workers_.size(),batch_pool_->size()));
+  while(batch_workers_.size()<batch_pool_->size()){
+    FX w;
+    w.assignNode(clone());
+    w.setOption(dictionary());
+    w.init();
+    batch_workers_.push_back(w);
+  }
+
+  // Allocate the results, the memory is kept between batches of the same size
+  batch_nout_ = 0;
+  for(int i=0; i<output_.size(); ++i) batch_nout_ += output(i).size2();
+  batch_output_.resize(nscen*grid_.size()*batch_nout_);
+
+  // Simulate
+  BatchJob job(this);
+  batch_pool_->run(job,nscen);
+
+  if(gather_stats_){
+    stats_["batch_num_threads"] = batch_pool_->size();
+    stats_["batch_scenario_time"] = batch_pool_->taskTime();
+    stats_["batch_scenario_thread"] = batch_pool_->taskThread();
+  }
+}
+
+void ControlSimulatorInternal::evaluateScenario(int k, int thread){
+  FX& w = batch_workers_.at(thread);
+
+  // Pass the inputs of the scenario, a single row is shared by all scenarios
+  const Matrix<double>* arg[CONTROLSIMULATOR_NUM_IN] = {&batch_x0_, &batch_p_, &batch_u_};
+  for(int i=0; i<CONTROLSIMULATOR_NUM_IN; ++i){
+    int n = arg[i]->size2();
+    int row = arg[i]->size1()==1 ? 0 : k;
+    w.input(i).setArray(n==0 ? 0 : getPtr(arg[i]->data())+row*n,n,DENSE);
+  }
+
+  // Simulate
+  w.evaluate();
+
+  // Copy the outputs, row by row, to the block of the scenario
+  int ngrid = grid_.size();
+  double* r = getPtr(batch_output_) + k*ngrid*batch_nout_;
+  for(int j=0; j<ngrid; ++j){
+    for(int i=0; i<w.getNumOutputs(); ++i){
+      const Matrix<double>& out = w.output(i);
+      int n = out.size2();
+      if(n==0) continue;
+      casadi_assert(out.dense());
+      std::copy(out.begin()+j*n,out.begin()+(j+1)*n,r);
+      r += n;
+    }
+  }
+}
+
 Matrix<double> ControlSimulatorInternal::getVFine() const {
            Matrix<double> ret(grid_.size()-1,nu_,0);
            for (int i=0;i<ns_-1;++i) {
@@ -442,21 +542,25 @@ void ControlSimulatorInternal::updateNumSens(bool recursive){
   
   if (!output_fcn_.isNull()) {
     output_fcn_.setOption("number_of_fwd_dir",getOption("number_of_fwd_dir"));
+    output_fcn_.setOption("number_of_adj_dir",getOption("number_of_adj_dir"));
     output_fcn_.updateNumSens();
   }
   
   if (!integrator_.isNull()) {
     integrator_.setOption("number_of_fwd_dir",getOption("number_of_fwd_dir"));
+    integrator_.setOption("number_of_adj_dir",getOption("number_of_adj_dir"));
     integrator_.updateNumSens();
   }
   
   if (!simulator_.isNull()) {
     simulator_.setOption("number_of_fwd_dir",getOption("number_of_fwd_dir"));
+    simulator_.setOption("number_of_adj_dir",getOption("number_of_adj_dir"));
     simulator_.updateNumSens();
   }
   
   if (!all_output_.isNull()) {
     all_output_.setOption("number_of_fwd_dir",getOption("number_of_fwd_dir"));
+    all_output_.setOption("number_of_adj_dir",getOption("number_of_adj_dir"));
     all_output_.updateNumSens();
   }
   
@@ -29,6 +29,9 @@
 
 namespace CasADi{
 
+// Forward declaration
+class ThreadPool;
+
 /** \brief ControlSimulator data storage classs
   \author Joel Andersson 
   \date 2010
@@ -43,7 +46,7 @@ public:
   virtual ~ControlSimulatorInternal();
   
   /** \brief  Clone */
-  virtual ControlSimulatorInternal* clone() const{ return new ControlSimulatorInternal(deepcopy(dae_),deepcopy(output_fcn_),gridc_);}
+  virtual ControlSimulatorInternal* clone() const{ return new ControlSimulatorInternal(deepcopy(control_dae_),deepcopy(orig_output_fcn_),gridc_);}
 
   /** \brief  initialize */
   virtual void init();
@@ -53,6 +56,12 @@ public:
   
   /** \brief  Update the number of sensitivity directions during or after initialization */
   virtual void updateNumSens(bool recursive);
+
+  /** \brief  Simulate a batch of scenarios concurrently */
+  void evaluateBatch(const Matrix<double>& x0, const Matrix<double>& p, const Matrix<double>& u);
+
+  /** \brief  Simulate scenario k of the current batch with the copy belonging to a thread */
+  void evaluateScenario(int k, int thread);
   
   /// Get the parameters that change on a coarse time scale, sampled on the fine timescale
          Matrix<double> getVFine() const; 
@@ -102,6 +111,21 @@ public:
   
   /** \brief Number of fine-grained time steps */
   int nf_;
+
+  /** \brief Thread pool for batches, created on first use */
+  ThreadPool* batch_pool_;
+
+  /** \brief Deep copies simulating the scenarios of a batch, one per thread */
+  std::vector<FX> batch_workers_;
+
+  /** \brief Inputs of the current batch, dense */
+  Matrix<double> batch_x0_, batch_p_, batch_u_;
+
+  /** \brief Results of the last batch, nscen-by-ngrid-by-nout */
+  std::vector<double> batch_output_;
+
+  /** \brief Total number of output elements per grid point */
+  int batch_nout_;
   
 };
   
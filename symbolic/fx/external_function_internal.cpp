@@ -31,7 +31,7 @@ namespace CasADi{
 
 using namespace std;
 
-ExternalFunctionInternal::ExternalFunctionInternal(const std::string& bin_name) : bin_name_(bin_name){
+ExternalFunctionInternal::ExternalFunctionInternal(const std::string& bin_name) : bin_name_(bin_name), evaluate_(0), evaluate_work_(0), sz_iw_(0), sz_w_(0), handle_(0){
 #ifdef WITH_DL 
 
   // Load the dll
@@ -45,6 +45,8 @@ ExternalFunctionInternal::ExternalFunctionInternal(const std::string& bin_name)
   if(getSparsity==0) throw CasadiException("ExternalFunctionInternal: no \"getSparsity\" found");
   evaluate_ = (evaluatePtr) GetProcAddress(handle_, TEXT("evaluateWrap"));
   if(evaluate_==0) throw CasadiException("ExternalFunctionInternal: no \"evaluateWrap\" found");
+  evaluate_work_ = (evaluateWorkPtr) GetProcAddress(handle_, TEXT("evaluateWork"));
+  workSizePtr work_size = (workSizePtr) GetProcAddress(handle_, TEXT("work_size"));
 
 #else // _WIN32
   handle_ = dlopen(bin_name_.c_str(), RTLD_LAZY);  
@@ -60,8 +62,18 @@ ExternalFunctionInternal::ExternalFunctionInternal(const std::string& bin_name)
   if(dlerror()) throw CasadiException("ExternalFunctionInternal: no \"getSparsity\" found");
   evaluate_ = (evaluatePtr) dlsym(handle_, "evaluateWrap");
   if(dlerror()) throw CasadiException("ExternalFunctionInternal: no \"evaluateWrap\" found");
+
+  // Reentrant entry point, optional
+  evaluate_work_ = (evaluateWorkPtr) dlsym(handle_, "evaluateWork");
+  workSizePtr work_size = (workSizePtr) dlsym(handle_, "work_size");
+  dlerror();
 #endif // _WIN32
 
+  // Get the length of the work arrays for the reentrant entry point
+  if(evaluate_work_!=0 && (work_size==0 || work_size(&sz_iw_,&sz_w_)!=0)){
+    evaluate_work_ = 0;
+  }
+
   // Initialize and get the number of inputs and outputs
   int n_in=-1, n_out=-1;
   int flag = init(&n_in, &n_out);
@@ -121,11 +133,62 @@ ExternalFunctionInternal::~ExternalFunctionInternal(){
 
 void ExternalFunctionInternal::evaluate(int nfdir, int nadir){
 #ifdef WITH_DL 
-  int flag = evaluate_(getPtr(input_array_),getPtr(output_array_));
+  int flag;
+  if(evaluate_work_!=0){
+    // Work arrays allocated in init
+    flag = evaluate_work_(getPtr(input_array_),getPtr(output_array_),getPtr(iw_),getPtr(w_));
+  } else {
+    flag = evaluate_(getPtr(input_array_),getPtr(output_array_));
+  }
   if(flag) throw CasadiException("ExternalFunctionInternal: \"evaluate\" failed");
 #endif // WITH_DL 
 }
   
+void ExternalFunctionInternal::workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const{
+  FXInternal::workSize(sz_arg,sz_res,sz_iw,sz_w);
+  if(evaluate_work_==0) return;
+
+  // Work needed by the library, followed by space for outputs that are not needed
+  sz_iw = sz_iw_;
+  sz_w = sz_w_;
+  for(int i=0; i<output_.size(); ++i){
+    sz_w += output(i).size();
+  }
+  
+  // Space for a modified copy of the pointer arrays
+  sz_arg *= 2;
+  sz_res *= 2;
+}
+
+void ExternalFunctionInternal::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+#ifdef WITH_DL 
+  if(evaluate_work_==0) return FXInternal::evaluateRaw(arg,res);
+  
+  // Inputs that are not given are zero, outputs that are not needed are written to the end of w
+  const int n_in = input_.size(), n_out = output_.size();
+  bool has_null = false;
+  for(int i=0; i<n_in && !has_null; ++i) has_null = arg[i]==0;
+  for(int i=0; i<n_out && !has_null; ++i) has_null = res[i]==0;
+  if(has_null){
+    const double** x = arg + n_in;
+    for(int i=0; i<n_in; ++i){
+      x[i] = arg[i]==0 ? getPtr(zeros_) : arg[i];
+    }
+    double** r = res + n_out;
+    double* scratch = w + sz_w_;
+    for(int i=0; i<n_out; ++i){
+      r[i] = res[i]==0 ? scratch : res[i];
+      scratch += output(i).size();
+    }
+    arg = x;
+    res = r;
+  }
+
+  int flag = evaluate_work_(arg,res,iw,w);
+  if(flag) throw CasadiException("ExternalFunctionInternal: \"evaluateWork\" failed");
+#endif // WITH_DL 
+}
+  
 void ExternalFunctionInternal::init(){
   // Call the init function of the base class
   FXInternal::init();
@@ -135,6 +198,15 @@ void ExternalFunctionInternal::init(){
   for(int i=0; i<input_array_.size(); ++i)
     input_array_[i] = input(i).ptr();
 
+  // All-zero input
+  int max_nnz_in = 0;
+  for(int i=0; i<input_.size(); ++i) max_nnz_in = std::max(max_nnz_in,input(i).size());
+  zeros_.assign(max_nnz_in,0);
+
+  // Work arrays for evaluate
+  iw_.resize(sz_iw_);
+  w_.resize(sz_w_);
+
   // Get pointers to the outputs
   output_array_.resize(output_.size());
   for(int i=0; i<output_array_.size(); ++i)
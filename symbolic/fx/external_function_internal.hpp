@@ -52,6 +52,18 @@ class ExternalFunctionInternal : public FXInternal{
     /** \brief  Evaluate */
     virtual void evaluate(int nfdir, int nadir);
   
+    /** \brief  Evaluate with caller-owned work arrays, if the library provides "evaluateWork" */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Evaluate with raw pointers */
+    virtual void evaluateRaw(const double* const* arg, double* const* res){ FXInternal::evaluateRaw(arg,res);}
+
+    /** \brief  Get the length of the work arrays needed by evaluateRaw */
+    virtual void workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const;
+
+    /** \brief  Reentrant if the library provides "evaluateWork" and "work_size" */
+    virtual bool isReentrant() const{ return evaluate_work_!=0;}
+  
     /** \brief  Initialize */
     virtual void init();
 
@@ -62,6 +74,8 @@ class ExternalFunctionInternal : public FXInternal{
   typedef int (*evaluatePtr)(const double** x, double** r);
   typedef int (*initPtr)(int *n_in_, int *n_out_);
   typedef int (*getSparsityPtr)(int n_in, int *n_row, int *n_col, int **rowind, int **col);
+  typedef int (*evaluateWorkPtr)(const double** x, double** r, int* iw, double* w);
+  typedef int (*workSizePtr)(int *sz_iw, int *sz_w);
 //@}
 
   /** \brief  Name of binary */
@@ -69,6 +83,12 @@ class ExternalFunctionInternal : public FXInternal{
 
   /** \brief  Function pointers */
   evaluatePtr evaluate_;
+
+  /** \brief  Reentrant entry point, null if not available */
+  evaluateWorkPtr evaluate_work_;
+
+  /** \brief  Length of the work arrays needed by the library */
+  int sz_iw_, sz_w_;
     
 #if defined(WITH_DL) && defined(_WIN32) // also for 64-bit
   typedef HINSTANCE handle_t;
@@ -84,6 +104,13 @@ class ExternalFunctionInternal : public FXInternal{
   
   /** \brief  Array of pointers to the output */
   std::vector<double*> output_array_;
+
+  /** \brief  All-zero input, passed for null pointers in evaluateRaw */
+  std::vector<double> zeros_;
+
+  /** \brief  Work arrays for evaluate, if the library provides "evaluateWork" */
+  std::vector<int> iw_;
+  std::vector<double> w_;
   
 };
 
@@ -120,6 +120,26 @@ namespace CasADi{
     (*this)->evaluate(nfdir,nadir);
   }
 
+  void FX::evaluateRaw(const double* const* arg, double* const* res){
+    assertInit();
+    (*this)->evaluateRaw(arg,res);
+  }
+
+  void FX::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    assertInit();
+    (*this)->evaluateRaw(arg,res,iw,w);
+  }
+
+  void FX::workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const{
+    assertInit();
+    (*this)->workSize(sz_arg,sz_res,sz_iw,sz_w);
+  }
+
+  bool FX::isReentrant() const{
+    assertInit();
+    return (*this)->isReentrant();
+  }
+
   void FX::evaluateCompressed(int nfdir, int nadir){
     assertInit();
     casadi_assert(nfdir<=(*this)->nfdir_);
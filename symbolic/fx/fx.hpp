@@ -153,6 +153,28 @@ namespace CasADi{
   
     /** \brief  Evaluate with directional derivative compression */
     void evaluateCompressed(int nfdir=0, int nadir=0);
+
+#ifndef SWIG
+    /** \brief  Evaluate with inputs and outputs given as pointers to their nonzeros, no derivatives
+        arg and res must have getNumInputs() and getNumOutputs() elements, respectively.
+        A null pointer in arg is an all-zero input, a null pointer in res an output that is not needed.
+        Depending on the function class, input() and output() may be left untouched.
+    */
+    void evaluateRaw(const double* const* arg, double* const* res);
+
+    /** \brief  Evaluate as above with all temporaries in caller-owned arrays
+        The arrays must be at least as long as given by workSize. The entries of arg and res past the
+        inputs and outputs are used as scratch space. If isReentrant() returns true, the same initialized 
+        function can be evaluated concurrently from several threads, each with its own arg, res, iw and w.
+    */
+    void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Get the length of the argument, result and work arrays needed by evaluateRaw */
+    void workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const;
+#endif // SWIG
+
+    /** \brief  Can evaluateRaw with caller-owned work arrays be called concurrently? */
+    bool isReentrant() const;
   
     /// the same as evaluate(0,0)
     void solve();
@@ -31,10 +31,21 @@
 #include "../matrix/sparsity_tools.hpp"
 #include "external_function.hpp"
 #include "derivative.hpp"
+#include "../thread_pool.hpp"
+#include "../casadi_options.hpp"
+#include <cstdio>
+#include <fstream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif // _WIN32
 
 #ifdef WITH_DL 
 #include <cstdlib>
 #include <ctime>
+#include <iomanip>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif // _WIN32
 #endif // WITH_DL 
 
 using namespace std;
@@ -59,6 +70,8 @@ namespace CasADi{
     addOption("monitor",      OT_STRINGVECTOR, GenericType(),  "Monitors to be activated","inputs|outputs");
     addOption("regularity_check",         OT_BOOLEAN,             true,          "Throw exceptions when NaN or Inf appears during evaluation");
     addOption("gather_stats",             OT_BOOLEAN,             false,         "Flag to indicate wether statistics must be gathered");
+    addOption("sparsity_bitset_width",    OT_INTEGER,             bvec_size,     "Number of directions propagated in each sweep when detecting Jacobian sparsity, a multiple of 64 (e.g. 256 or 512). Wider bitsets need fewer sweeps through the algorithm. Only used by functions that support it (SXFunction)");
+    addOption("sparsity_num_threads",     OT_INTEGER,             1,             "Number of threads sharing the sweeps when detecting Jacobian sparsity with wide bitsets, 0 means one per processor");
   
     verbose_ = false;
     jacgen_ = 0;
@@ -482,6 +495,224 @@ namespace CasADi{
     return ret;
   }
 
+  namespace{
+    /// Sweeps of FXInternal::getJacSparsityWide, each task treating a contiguous range of sweeps.
+    /// Direction d seeds the nonzeros dir_nz[dir_offset[d]], ..., dir_nz[dir_offset[d+1]-1],
+    /// a dependency of sensitivity nonzero el on direction d is returned as the pair (el,d).
+    class JacSparsityWideJob : public ThreadPool::Job{
+    public:
+      JacSparsityWideJob(const FXInternal& f, int iind, int oind, bool fwd, int nw, const vector<int>& dir_offset, const vector<int>& dir_nz, int ntask) :
+        f_(f), iind_(iind), oind_(oind), fwd_(fwd), nw_(nw), dir_offset_(dir_offset), dir_nz_(dir_nz), sens_el_(ntask), dir_(ntask){
+        nz_seed_ = fwd ? f.input(iind).size() : f.output(oind).size();
+        nz_sens_ = fwd ? f.output(oind).size() : f.input(iind).size();
+        ndir_ = dir_offset.size()-1;
+        nsweep_ = (ndir_+nw*bvec_size-1)/(nw*bvec_size);
+      }
+
+      virtual void execute(int task){
+        // Directions per sweep
+        int width = nw_*bvec_size;
+        
+        // Work vectors, local to the task
+        vector<bvec_t> w(f_.spWideWorkSize()*nw_,bvec_t(0));
+        vector<bvec_t> seed(nz_seed_*nw_,bvec_t(0));
+        vector<bvec_t> sens(nz_sens_*nw_);
+        vector<int>& sens_el = sens_el_[task];
+        vector<int>& dir = dir_[task];
+        
+        // Sweeps of this task
+        int ntask = sens_el_.size();
+        int s_begin = (task*nsweep_)/ntask;
+        int s_end = ((task+1)*nsweep_)/ntask;
+        for(int s=s_begin; s<s_end; ++s){
+          // First direction and number of local directions
+          int offset = s*width;
+          int ndir_local = std::min(width,ndir_-offset);
+          
+          // Set the seeds, direction i is bit i%bvec_size of word i/bvec_size
+          for(int i=0; i<ndir_local; ++i){
+            for(int k=dir_offset_[offset+i]; k<dir_offset_[offset+i+1]; ++k){
+              seed[dir_nz_[k]*nw_ + i/bvec_size] |= bvec_t(1) << (i%bvec_size);
+            }
+          }
+          
+          // Propagate the dependencies
+          fill(sens.begin(),sens.end(),bvec_t(0));
+          f_.spEvaluateWide(fwd_,iind_,oind_,nw_,getPtr(seed),getPtr(sens),getPtr(w));
+          
+          // Collect the dependencies
+          for(int el=0; el<nz_sens_; ++el){
+            for(int k=0; k<nw_; ++k){
+              bvec_t spsens = sens[el*nw_+k];
+              if(spsens==0) continue;
+              for(int i=0; i<bvec_size && k*bvec_size+i<ndir_local; ++i){
+                if((bvec_t(1) << i) & spsens){
+                  sens_el.push_back(el);
+                  dir.push_back(offset+k*bvec_size+i);
+                }
+              }
+            }
+          }
+
+          // Remove the seeds
+          for(int i=0; i<ndir_local; ++i){
+            for(int k=dir_offset_[offset+i]; k<dir_offset_[offset+i+1]; ++k){
+              seed[dir_nz_[k]*nw_ + i/bvec_size] = 0;
+            }
+          }
+        }
+      }
+
+      const FXInternal& f_;
+      int iind_, oind_;
+      bool fwd_;
+      int nw_, nsweep_, ndir_, nz_seed_, nz_sens_;
+      const vector<int>& dir_offset_;
+      const vector<int>& dir_nz_;
+      
+      /// Dependencies found by each task
+      vector<vector<int> > sens_el_, dir_;
+    };
+  } // namespace
+
+  void FXInternal::propagateWide(int iind, int oind, bool fwd, const std::vector<int>& dir_offset, const std::vector<int>& dir_nz, std::vector<int>& sens_el, std::vector<int>& dir){
+    // Width of the bitsets
+    int width = getOption("sparsity_bitset_width");
+    int nw = width/bvec_size;
+    int nsweep = (dir_offset.size()-1+width-1)/width;
+    
+    // Pool shared with all functions, its threads are only busy during a run
+    ThreadPool& pool = ThreadPool::shared(getOption("sparsity_num_threads"));
+
+    // Distribute the sweeps over a few tasks per thread, each with its own work vectors
+    int ntask = std::min(nsweep,4*pool.size());
+    if(pool.size()==1) ntask = std::min(nsweep,1);
+
+    if(verbose()){
+      std::cout << "FXInternal::propagateWide: using " << (fwd ? "forward" : "adjoint") << " mode: ";
+      std::cout << nsweep << " sweeps of " << width << " directions in " << ntask << " tasks on " << pool.size() << " threads" << endl;
+    }
+
+    // Propagate
+    JacSparsityWideJob job(*this,iind,oind,fwd,nw,dir_offset,dir_nz,ntask);
+    pool.run(job,ntask);
+
+    // Collect the dependencies, the tasks treat increasing ranges of sweeps
+    sens_el.clear();
+    dir.clear();
+    for(int task=0; task<ntask; ++task){
+      sens_el.insert(sens_el.end(),job.sens_el_[task].begin(),job.sens_el_[task].end());
+      dir.insert(dir.end(),job.dir_[task].begin(),job.dir_[task].end());
+    }
+  }
+
+  CRSSparsity FXInternal::getJacSparsityWide(int iind, int oind, bool symmetric){
+    // Width of the bitsets
+    int width = getOption("sparsity_bitset_width");
+    casadi_assert_message(width>0 && width%bvec_size==0, "FXInternal::getJacSparsityWide: option \"sparsity_bitset_width\" must be a positive multiple of " << bvec_size << ", got " << width);
+    
+    // Number of nonzero inputs and outputs
+    int nz_in = input(iind).size();
+    int nz_out = output(oind).size();
+    casadi_assert_message(!symmetric || nz_in==nz_out, "FXInternal::getJacSparsityWide: a symmetric Jacobian must be square");
+    
+    // Number of sweeps in forward and adjoint mode
+    int nsweep_fwd = (nz_in+width-1)/width;
+    int nsweep_adj = (nz_out+width-1)/width;
+    
+    // Use forward mode?
+    bool use_fwd = spCanEvaluateWide(true) && (nsweep_fwd <= nsweep_adj || !spCanEvaluateWide(false));
+    if(getOption("ad_mode") == "forward"){
+      use_fwd = true;
+    } else if(getOption("ad_mode") == "reverse"){
+      use_fwd = false;
+    }
+    int nz_seed = use_fwd ? nz_in : nz_out;
+
+    // Dependencies as pairs (sensitivity nonzero, direction)
+    std::vector<int> sens_el, dir;
+    
+    if(!symmetric || nz_seed<=width){
+      // One direction per seed nonzero
+      std::vector<int> dir_offset(nz_seed+1), dir_nz(nz_seed);
+      for(int k=0; k<nz_seed; ++k){
+        dir_offset[k+1] = k+1;
+        dir_nz[k] = k;
+      }
+      propagateWide(iind,oind,use_fwd,dir_offset,dir_nz,sens_el,dir);
+      
+      // Construct sparsity pattern
+      return sp_triplet(nz_out, nz_in,use_fwd ? sens_el : dir, use_fwd ? dir : sens_el);
+    }
+    
+    // Symmetric Jacobian: divide the nonzeros into one block per bit, element el is in block el/bs
+    int bs = (nz_seed+width-1)/width;
+    int nb = (nz_seed+bs-1)/bs;
+    
+    // One sweep seeding each block with one direction gives the block sparsity pattern
+    std::vector<int> dir_offset(nb+1), dir_nz(nz_seed);
+    for(int b=0; b<nb; ++b) dir_offset[b+1] = std::min((b+1)*bs,nz_seed);
+    for(int k=0; k<nz_seed; ++k) dir_nz[k] = k;
+    propagateWide(iind,oind,use_fwd,dir_offset,dir_nz,sens_el,dir);
+    for(int k=0; k<sens_el.size(); ++k) sens_el[k] /= bs;
+    CRSSparsity r = sp_triplet(nb,nb,sens_el,dir);
+    
+    // Star coloring of the blocks, the structure is symmetric
+    CRSSparsity D = r.starColoring();
+    int ncolor = D.size1();
+    std::vector<int> color(nb);
+    for(int c=0; c<ncolor; ++c){
+      for(int k=D.rowind(c); k<D.rowind(c+1); ++k) color[D.col(k)] = c;
+    }
+    
+    if(verbose()){
+      std::cout << "FXInternal::getJacSparsityWide: star coloring of " << nb << " blocks of " << bs << " nonzeros: " << ncolor << " colors" << endl;
+    }
+    
+    // Direction (c,i) seeds element i of all blocks with color c
+    dir_offset.resize(ncolor*bs+1);
+    dir_nz.clear();
+    dir_offset[0] = 0;
+    for(int c=0; c<ncolor; ++c){
+      for(int i=0; i<bs; ++i){
+        for(int k=D.rowind(c); k<D.rowind(c+1); ++k){
+          int el = D.col(k)*bs + i;
+          if(el<nz_seed) dir_nz.push_back(el);
+        }
+        dir_offset[c*bs+i+1] = dir_nz.size();
+      }
+    }
+    propagateWide(iind,oind,use_fwd,dir_offset,dir_nz,sens_el,dir);
+    
+    // The block of color c that block b depends on, if there is exactly one, otherwise -1
+    std::vector<int> unique_nb(nb*ncolor,-1), count_nb(nb*ncolor,0);
+    for(int b=0; b<nb; ++b){
+      for(int k=r.rowind(b); k<r.rowind(b+1); ++k){
+        int cb = r.col(k);
+        count_nb[b*ncolor+color[cb]]++;
+        unique_nb[b*ncolor+color[cb]] = cb;
+      }
+    }
+    
+    // Recover the dependencies whose block is the only one of its color, the star coloring ensures that
+    // every nonzero is recovered either directly or via its transpose
+    std::vector<int> jrow, jcol;
+    for(int k=0; k<sens_el.size(); ++k){
+      int el = sens_el[k];
+      int c = dir[k]/bs;
+      int i = dir[k]%bs;
+      if(count_nb[(el/bs)*ncolor+c]!=1) continue;
+      int el_seed = unique_nb[(el/bs)*ncolor+c]*bs + i;
+      jrow.push_back(el);
+      jcol.push_back(el_seed);
+      jrow.push_back(el_seed);
+      jcol.push_back(el);
+    }
+    
+    // Construct sparsity pattern
+    return sp_triplet(nz_out, nz_in, jrow, jcol);
+  }
+
   CRSSparsity FXInternal::getJacSparsityHierarchicalSymm(int iind, int oind){
     casadi_assert(spCanEvaluate(true));
 
@@ -974,6 +1205,13 @@ namespace CasADi{
     // Check if we are able to propagate dependencies through the function
     if(spCanEvaluate(true) || spCanEvaluate(false)){
 
+      // Wide bitsets and/or multiple threads, if requested and supported
+      int sp_width = getOption("sparsity_bitset_width");
+      int sp_num_threads = getOption("sparsity_num_threads");
+      if((sp_width!=bvec_size || sp_num_threads!=1) && (spCanEvaluateWide(true) || spCanEvaluateWide(false))){
+        return getJacSparsityWide(iind, oind, symmetric);
+      }
+
       if (input(iind).size()>3*bvec_size && output(oind).size()>3*bvec_size) {
         if (symmetric) {
           return getJacSparsityHierarchicalSymm(iind, oind);
@@ -1009,8 +1247,18 @@ namespace CasADi{
     if(jsp.isNull()){
       if(compact){
         if(spgen_==0){
-          // Use internal routine to determine sparsity
-          jsp = getJacSparsity(iind,oind,symmetric);
+          // Look in the on-disk sparsity cache
+          string cache_file = sparsityCacheFile("jac",iind,oind,symmetric);
+          vector<CRSSparsity> cached;
+          if(!cache_file.empty() && readSparsityCache(cache_file,cached) && cached.size()==1 && 
+             cached[0].size1()==output(oind).size() && cached[0].size2()==input(iind).size()){
+            jsp = cached[0];
+            if(verbose()) cout << "FXInternal::jacSparsity: read from " << cache_file << endl;
+          } else {
+            // Use internal routine to determine sparsity
+            jsp = getJacSparsity(iind,oind,symmetric);
+            if(!cache_file.empty()) writeSparsityCache(cache_file,vector<CRSSparsity>(1,jsp));
+          }
         } else {
           // Create a temporary FX instance
           FX tmp = shared_from_this<FX>();
@@ -1066,6 +1314,24 @@ namespace CasADi{
   
     // Sparsity pattern with transpose
     CRSSparsity &A = jacSparsity(iind,oind,compact,symmetric);
+
+    // Look in the on-disk sparsity cache, the coloring depends on the AD mode and on whether the pattern is compact
+    string cache_file = sparsityCacheFile("partition_" + getOption("ad_mode").toString() + (compact ? "_compact" : ""),iind,oind,symmetric);
+    vector<CRSSparsity> cached;
+    if(!cache_file.empty() && readSparsityCache(cache_file,cached) && cached.size()==2){
+      // Only use the seed matrices if they fit A, otherwise the file is stale or colliding and the partition is recomputed
+      bool fits = (!cached[0].isNull() || !cached[1].isNull()) &&
+                  (cached[0].isNull() || cached[0].size2()==A.size2()) &&
+                  (cached[1].isNull() || cached[1].size2()==A.size1());
+      if(fits){
+        D1 = cached[0];
+        D2 = cached[1];
+        if(verbose()) cout << "FXInternal::getPartition: read from " << cache_file << endl;
+        log("FXInternal::getPartition end");
+        return;
+      }
+      if(verbose()) cout << "FXInternal::getPartition: ignoring " << cache_file << ", dimensions do not match" << endl;
+    }
     vector<int> mapping;
     CRSSparsity AT = symmetric ? A : A.transpose(mapping);
     mapping.clear();
@@ -1138,6 +1404,124 @@ namespace CasADi{
 
       log("FXInternal::getPartition end");
     }
+
+    // Save to the on-disk sparsity cache
+    if(!cache_file.empty()){
+      vector<CRSSparsity> D(2);
+      D[0] = D1;
+      D[1] = D2;
+      writeSparsityCache(cache_file,D);
+    }
+  }
+
+  string FXInternal::sparsityCacheFile(const string& what, int iind, int oind, bool symmetric) const{
+    // Quick return if the cache is disabled or the function does not have a structural hash
+    const string& cache_dir = CasadiOptions::sparsity_cache_dir;
+    if(cache_dir.empty()) return "";
+    string h = structuralHash();
+    if(h.empty()) return "";
+
+    // Form the filename
+    stringstream ss;
+    ss << cache_dir << "/" << what << "_" << h << "_" << iind << "_" << oind << (symmetric ? "_symm" : "") << ".sp";
+    return ss.str();
+  }
+
+  bool FXInternal::readSparsityCache(const string& fname, vector<CRSSparsity>& sp){
+    std::ifstream file(fname.c_str());
+    if(!file.good()) return false;
+
+    // Header
+    string header;
+    int n;
+    file >> header >> n;
+    if(!file || header!="casadi_sparsity" || n<0) return false;
+    
+    // Patterns, a negative number of rows denotes a null pattern
+    sp.resize(n);
+    for(int k=0; k<n; ++k){
+      int nrow, ncol, nnz;
+      file >> nrow >> ncol >> nnz;
+      if(!file) return false;
+      if(nrow<0){
+        sp[k] = CRSSparsity();
+        continue;
+      }
+      if(ncol<0 || nnz<0) return false;
+      vector<int> rowind(nrow+1), col(nnz);
+      for(int i=0; i<rowind.size(); ++i) file >> rowind[i];
+      for(int i=0; i<col.size(); ++i) file >> col[i];
+      if(!file || rowind.front()!=0 || rowind.back()!=nnz) return false;
+      for(int i=0; i<nrow; ++i) if(rowind[i]>rowind[i+1]) return false;
+      for(int el=0; el<nnz; ++el) if(col[el]<0 || col[el]>=ncol) return false;
+      sp[k] = CRSSparsity(nrow,ncol,col,rowind);
+    }
+    return true;
+  }
+
+  void FXInternal::writeSparsityCache(const string& fname, const vector<CRSSparsity>& sp){
+    // Write to a temporary file first, so that other processes never see a partially written file
+    stringstream tmpname;
+    tmpname << fname << ".tmp";
+#ifndef _WIN32
+    tmpname << getpid();
+#endif // _WIN32
+    std::ofstream file(tmpname.str().c_str());
+    if(!file.good()){
+      casadi_warning("FXInternal::writeSparsityCache: cannot write to " << tmpname.str());
+      return;
+    }
+    file << "casadi_sparsity " << sp.size() << endl;
+    for(int k=0; k<sp.size(); ++k){
+      if(sp[k].isNull()){
+        file << "-1 -1 -1" << endl;
+        continue;
+      }
+      file << sp[k].size1() << " " << sp[k].size2() << " " << sp[k].size() << endl;
+      const vector<int>& rowind = sp[k].rowind();
+      const vector<int>& col = sp[k].col();
+      for(int i=0; i<rowind.size(); ++i) file << rowind[i] << " ";
+      file << endl;
+      for(int i=0; i<col.size(); ++i) file << col[i] << " ";
+      file << endl;
+    }
+    file.close();
+    if(rename(tmpname.str().c_str(),fname.c_str())!=0){
+      remove(tmpname.str().c_str());
+    }
+  }
+
+  void FXInternal::evaluateRaw(const double* const* arg, double* const* res){
+    // Pass the inputs
+    for(int ind=0; ind<getNumInputs(); ++ind){
+      vector<double>& v = input(ind).data();
+      if(arg[ind]==0){
+        fill(v.begin(),v.end(),0.);
+      } else {
+        copy(arg[ind],arg[ind]+v.size(),v.begin());
+      }
+    }
+
+    // Evaluate
+    evaluate(0,0);
+
+    // Get the outputs
+    for(int ind=0; ind<getNumOutputs(); ++ind){
+      if(res[ind]!=0){
+        const vector<double>& v = output(ind).data();
+        copy(v.begin(),v.end(),res[ind]);
+      }
+    }
+  }
+
+  void FXInternal::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    evaluateRaw(static_cast<const double* const*>(arg),static_cast<double* const*>(res));
+  }
+
+  void FXInternal::workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const{
+    sz_arg = getNumInputs();
+    sz_res = getNumOutputs();
+    sz_iw = sz_w = 0;
   }
 
   void FXInternal::evaluateCompressed(int nfdir, int nadir){
@@ -1379,6 +1763,10 @@ namespace CasADi{
     casadi_error("FXInternal::evalMX not defined for class " << typeid(*this).name());
   }
 
+  void FXInternal::spEvaluateWide(bool fwd, int iind, int oind, int nw, const bvec_t* seed, bvec_t* sens, bvec_t* w) const{
+    casadi_error("FXInternal::spEvaluateWide not defined for class " << typeid(*this).name());
+  }
+
   void FXInternal::spEvaluate(bool fwd){
     // By default, everything is assumed to depend on everything
   
@@ -1717,11 +2105,18 @@ namespace CasADi{
   }
     
   void FXInternal::generateCode(const string& src_name){
-    assertInit();
-    
     // Create the c source file
     std::ofstream cfile;
     cfile.open (src_name.c_str());
+    generateCode(cfile);
+
+    // Close the results file
+    cfile.close();
+  }
+
+  void FXInternal::generateCode(std::ostream &cfile){
+    assertInit();
+    
     cfile.precision(std::numeric_limits<double>::digits10+2);
     cfile << std::scientific; // This is really only to force a decimal dot, would be better if it can be avoided
 
@@ -1740,32 +2135,62 @@ namespace CasADi{
     // Generate the actual function
     generateFunction(gen.function_, "evaluate", "const d*","d*","d",gen);
 
+    // Generate vectorized entry points, if any
+    generateVectorized(gen.function_,gen);
+
     // Flush the code generator
     gen.flush(cfile);
   
-    // Define wrapper function
-    cfile << "int evaluateWrap(const d** x, d** r){" << std::endl;
-    cfile << "  evaluate(";
-  
     // Number of inputs/outputs
     int n_i = input_.size();
     int n_o = output_.size();
 
-    // Pass inputs
+    // Length of the work vectors
+    size_t ni, nr;
+    workSizeCode(ni,nr);
+
+    // Function that returns the length of the work vectors
+    cfile << "int work_size(int *sz_iw, int *sz_w){" << std::endl;
+    cfile << "  *sz_iw = " << ni << ";" << std::endl;
+    cfile << "  *sz_w = " << nr << ";" << std::endl;
+    cfile << "  return 0;" << std::endl;
+    cfile << "}" << std::endl << std::endl;
+
+    // Reentrant wrapper function, the work vectors are provided by the caller
+    cfile << "int evaluateWork(const d** x, d** r, int* iw, d* w){" << std::endl;
+    cfile << "  evaluate(";
     for(int i=0; i<n_i; ++i){
-      if(i!=0) cfile << ",";
-      cfile << "x[" << i << "]";
+      cfile << "x[" << i << "],";
     }
-
-    // Pass outputs
     for(int i=0; i<n_o; ++i){
-      if(i+n_i!= 0) cfile << ",";
-      cfile << "r[" << i << "]";
+      cfile << "r[" << i << "],";
     }
+    cfile << "iw,w);" << std::endl;
+    cfile << "  return 0;" << std::endl;
+    cfile << "}" << std::endl << std::endl;
 
-    cfile << "); " << std::endl;
+    // Evaluate at n points, point j of argument i starting at x[i]+j*nnz(i), sharing the work vectors
+    cfile << "int evaluateBatch(int n, const d** x, d** r, int* iw, d* w){" << std::endl;
+    cfile << "  int j;" << std::endl;
+    cfile << "  for(j=0; j<n; ++j){" << std::endl;
+    cfile << "    evaluate(";
+    for(int i=0; i<n_i; ++i){
+      cfile << "x[" << i << "]+j*" << input(i).size() << ",";
+    }
+    for(int i=0; i<n_o; ++i){
+      cfile << "r[" << i << "] ? r[" << i << "]+j*" << output(i).size() << " : 0,";
+    }
+    cfile << "iw,w);" << std::endl;
+    cfile << "  }" << std::endl;
     cfile << "  return 0;" << std::endl;
     cfile << "}" << std::endl << std::endl;
+
+    // Define wrapper function with static work vectors, not reentrant
+    cfile << "int evaluateWrap(const d** x, d** r){" << std::endl;
+    cfile << "  static int iw[" << std::max(ni,size_t(1)) << "];" << std::endl;
+    cfile << "  static d w[" << std::max(nr,size_t(1)) << "];" << std::endl;
+    cfile << "  return evaluateWork(x,r,iw,w);" << std::endl;
+    cfile << "}" << std::endl << std::endl;
   
     // Create a main for debugging and profiling: TODO: Cleanup and expose to user, see #617
     if(true){
@@ -1786,6 +2211,10 @@ namespace CasADi{
         cfile << "  d t_r" << i << "[" << output(i).sparsity().size() << "];" << std::endl;
       }
 
+      // Declare work vectors
+      cfile << "  static int t_iw[" << std::max(ni,size_t(1)) << "];" << std::endl;
+      cfile << "  static d t_w[" << std::max(nr,size_t(1)) << "];" << std::endl;
+
       // Repeat 10 times
       cfile << "  for(j=0; j<10; ++j){" << std::endl;
 
@@ -1797,18 +2226,16 @@ namespace CasADi{
       // Pass inputs
       cfile << "    evaluate(";
       for(int i=0; i<n_in; ++i){
-        cfile << "t_x" << i;
-        if(i+1<n_in+n_out)
-          cfile << ",";
+        cfile << "t_x" << i << ",";
       }
 
       // Pass output buffers
       for(int i=0; i<n_out; ++i){
-        cfile << "t_r" << i;
-        if(i+1<n_out)
-          cfile << ",";
+        cfile << "t_r" << i << ",";
       }
-      cfile << "); " << std::endl;
+
+      // Pass work vectors
+      cfile << "t_iw,t_w); " << std::endl;
 
     
       // Dummy printout
@@ -1826,13 +2253,9 @@ namespace CasADi{
       cfile << "  return 0;" << std::endl;
       cfile << "}" << std::endl << std::endl;
     }
-
-
-    // Close the results file
-    cfile.close();
   }
 
-  void FXInternal::generateFunction(std::ostream &stream, const std::string& fname, const std::string& input_type, const std::string& output_type, const std::string& type, CodeGenerator& gen) const{
+  void FXInternal::generateFunction(std::ostream &stream, const std::string& fname, const std::string& input_type, const std::string& output_type, const std::string& type, CodeGenerator& gen, bool work_arguments) const{
 
     // Generate declarations
     generateDeclarations(stream,type,gen);
@@ -1857,6 +2280,12 @@ namespace CasADi{
       if(i+1<n_out)
         stream << ",";
     }
+
+    // Declare work vectors
+    if(work_arguments){
+      if(n_in+n_out>0) stream << ",";
+      stream << "int* iw, " << type << "* w";
+    }
     stream << "){ " << std::endl;
   
     // Insert the function body
@@ -1871,6 +2300,21 @@ namespace CasADi{
     // Nothing to declare
   }
 
+  void FXInternal::generateVectorized(std::ostream &stream, CodeGenerator& gen) const{
+    // Not supported by default
+  }
+
+  void FXInternal::workSizeCode(size_t& ni, size_t& nr) const{
+    // No work vectors needed by default
+    ni=0;
+    nr=0;
+  }
+
+  size_t FXInternal::persistentSizeCode() const{
+    // No persistent data by default
+    return 0;
+  }
+
   void FXInternal::generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const{
     casadi_error("FXInternal::generateBody: generateBody not defined for class " << typeid(*this).name());
   }
@@ -1960,8 +2404,67 @@ namespace CasADi{
     }
   }
 
+#ifdef WITH_DL 
+  namespace{
+    /// 64-bit FNV-1a hash of a string, as a hexadecimal string
+    std::string hashString(const std::string& s){
+      unsigned long long h = 14695981039346656037ULL;
+      for(std::string::const_iterator it=s.begin(); it!=s.end(); ++it){
+        h ^= static_cast<unsigned char>(*it);
+        h *= 1099511628211ULL;
+      }
+      std::stringstream ss;
+      ss << std::hex << std::setfill('0') << std::setw(16) << h;
+      return ss.str();
+    }
+
+    /// Run shell commands concurrently (empty commands are skipped), returns the exit status of each
+    std::vector<int> systemParallel(const std::vector<std::string>& cmd){
+      std::vector<int> ret(cmd.size(),0);
+#ifndef _WIN32
+      // Start all processes
+      std::vector<pid_t> pid(cmd.size(),-1);
+      for(int k=0; k<cmd.size(); ++k){
+        if(cmd[k].empty()) continue;
+        pid[k] = fork();
+        if(pid[k]==0){
+          execl("/bin/sh","sh","-c",cmd[k].c_str(),static_cast<char*>(0));
+          _exit(127);
+        } else if(pid[k]<0){
+          // Could not create a new process, run the command in this process
+          ret[k] = system(cmd[k].c_str());
+        }
+      }
+
+      // Wait for the processes to finish
+      for(int k=0; k<cmd.size(); ++k){
+        if(pid[k]>0){
+          int status;
+          if(waitpid(pid[k],&status,0)<0){
+            ret[k] = -1;
+          } else {
+            ret[k] = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+          }
+        }
+      }
+#else // _WIN32
+      for(int k=0; k<cmd.size(); ++k){
+        if(!cmd[k].empty()) ret[k] = system(cmd[k].c_str());
+      }
+#endif // _WIN32
+      return ret;
+    }
+  } // namespace
+#endif // WITH_DL 
+
   FX FXInternal::dynamicCompilation(FX f, std::string fname, std::string fdescr, std::string compiler){
+    return dynamicCompilation(vector<FX>(1,f),vector<string>(1,fname),vector<string>(1,fdescr),compiler).front();
+  }
+
+  std::vector<FX> FXInternal::dynamicCompilation(const std::vector<FX>& f, const std::vector<std::string>& fname, 
+                                                 const std::vector<std::string>& fdescr, std::string compiler){
 #ifdef WITH_DL 
+    casadi_assert(f.size()==fname.size() && f.size()==fdescr.size());
 
     // Flag to get a DLL
 #ifdef __APPLE__
@@ -1970,54 +2473,109 @@ namespace CasADi{
     string dlflag = " -shared";
 #endif // __APPLE__
 
-    // Check if f is initialized
-    bool f_is_init = f.isInit();
-    if(!f_is_init) f.init();
+    // Cache directory, if any
+    const string& cache_dir = CasadiOptions::compilation_cache_dir;
+    
+    // Generate the code and form the compilation commands
+    vector<bool> f_is_init(f.size());
+    vector<string> dlname(f.size()), tmpname(f.size()), compile_command(f.size());
+    for(int k=0; k<f.size(); ++k){
+      // Check if f is initialized
+      FX fk = f[k];
+      f_is_init[k] = fk.isInit();
+      if(!f_is_init[k]) fk.init();
+
+      // Codegen it
+      stringstream src;
+      fk->generateCode(src);
+
+      // Filenames
+      string cname;
+      if(cache_dir.empty()){
+        cname = fname[k] + ".c";
+        dlname[k] = "./" + fname[k] + ".so";
+
+        // Remove existing files, if any
+        remove(cname.c_str());
+        remove(dlname[k].c_str());
+      } else {
+        // Content-addressed names: hash of the source and of the compiler command
+        string base = cache_dir + "/" + fname[k] + "_" + hashString(src.str() + "\n" + compiler + dlflag);
+        cname = base + ".c";
+        dlname[k] = base + ".so";
+
+        // Reuse the binary if it exists
+        if(std::ifstream(dlname[k].c_str()).good()){
+          if(verbose_){
+            cout << "Reusing cached binary for " << fdescr[k] << " (" << dlname[k] << ")" << endl;
+          }
+          continue;
+        }
+      }
 
-    // Filenames
-    string cname = fname + ".c";
-    string dlname = fname + ".so";
-  
-    // Remove existing files, if any
-    string rm_command = "rm -rf " + cname + " " + dlname;
-    int flag = system(rm_command.c_str());
-    casadi_assert_message(flag==0, "Failed to remove old source");
+      // Suffix of temporary files, unique for the process
+      stringstream tmp;
+      tmp << ".tmp";
+#ifndef _WIN32
+      tmp << getpid();
+#endif // _WIN32
+
+      // Write the source file to a temporary name which is moved in place when complete,
+      // so that a process compiling the same source never sees a partially written file
+      string ctmpname = cname + tmp.str() + ".c";
+      std::ofstream cfile(ctmpname.c_str());
+      cfile << src.str();
+      cfile.close();
+      casadi_assert_message(!cfile.fail(), "Failed to write " << ctmpname);
+#ifdef _WIN32
+      remove(cname.c_str()); // rename does not replace existing files
+#endif // _WIN32
+      casadi_assert_message(rename(ctmpname.c_str(),cname.c_str())==0, "Failed to move " << ctmpname << " to " << cname);
+      if(verbose_){
+        cout << "Generated c-code for " << fdescr[k] << " (" << cname << ")" << endl;
+      }
 
-    // Codegen it
-    f.generateCode(cname);
-    if(verbose_){
-      cout << "Generated c-code for " << fdescr << " (" << cname << ")" << endl;
-    }
-  
-    // Compile it
-    string compile_command = compiler + " " + dlflag + " " + cname + " -o " + dlname;
-    if(verbose_){
-      cout << "Compiling " << fdescr <<  " using \"" << compile_command << "\"" << endl;
+      // Compile to a temporary name which is moved in place when complete, so that the cache never contains partial binaries
+      tmpname[k] = dlname[k] + tmp.str();
+      compile_command[k] = compiler + " " + dlflag + " " + cname + " -o " + tmpname[k];
+      if(verbose_){
+        cout << "Compiling " << fdescr[k] <<  " using \"" << compile_command[k] << "\"" << endl;
+      }
     }
 
+    // Compile in parallel
     time_t time1 = time(0);
-    flag = system(compile_command.c_str());
+    vector<int> flag = systemParallel(compile_command);
     time_t time2 = time(0);
     double comp_time = difftime(time2,time1);
-    casadi_assert_message(flag==0, "Compilation failed");
-    if(verbose_){
-      cout << "Compiled " << fdescr << " (" << dlname << ") in " << comp_time << " s."  << endl;
+    for(int k=0; k<f.size(); ++k){
+      if(compile_command[k].empty()) continue;
+      casadi_assert_message(flag[k]==0, "Compilation of " << fdescr[k] << " failed");
+      remove(dlname[k].c_str());
+      casadi_assert_message(rename(tmpname[k].c_str(),dlname[k].c_str())==0, "Failed to move " << tmpname[k] << " to " << dlname[k]);
+      if(verbose_){
+        cout << "Compiled " << fdescr[k] << " (" << dlname[k] << ") in " << comp_time << " s."  << endl;
+      }
     }
 
-    // Load it
-    ExternalFunction f_gen("./" + dlname);
-    f_gen.setOption("number_of_fwd_dir",0);
-    f_gen.setOption("number_of_adj_dir",0);
-    f_gen.setOption("name",fname + "_gen");
+    // Load them
+    vector<FX> ret(f.size());
+    for(int k=0; k<f.size(); ++k){
+      ExternalFunction f_gen(dlname[k]);
+      f_gen.setOption("number_of_fwd_dir",0);
+      f_gen.setOption("number_of_adj_dir",0);
+      f_gen.setOption("name",fname[k] + "_gen");
 
-    // Initialize it if f was initialized
-    if(f_is_init){
-      f_gen.init();
-      if(verbose_){
-        cout << "Dynamically loaded " << fdescr << " (" << dlname << ")" << endl;
+      // Initialize it if f was initialized
+      if(f_is_init[k]){
+        f_gen.init();
+        if(verbose_){
+          cout << "Dynamically loaded " << fdescr[k] << " (" << dlname[k] << ")" << endl;
+        }
       }
+      ret[k] = f_gen;
     }
-    return f_gen;
+    return ret;
 #else // WITH_DL 
     casadi_error("Codegen in SCPgen requires CasADi to be compiled with option \"WITH_DL\" enabled");
 #endif // WITH_DL 
@@ -2257,6 +2815,10 @@ namespace CasADi{
       stream << res.at(i);
       if(i+1<res.size()) stream << ",";
     }
+
+    // Pass the part of the work vectors not used for the arguments
+    if(arg.size()+res.size()>0) stream << ",";
+    stream << "iii,rrr+" << nr;
   
     // Finalize the function call
     stream << ");" << endl;  
@@ -2275,6 +2837,122 @@ namespace CasADi{
     }
   }
 
+  void FXInternal::evaluateRaw(MXNode* node, const double** arg, double** res, int* iw, double* w){
+    // Copy arguments with nonmatching sparsities to the beginning of the work vector
+    for(int i=0; i<getNumInputs(); ++i){
+      if(node->dep(i).isNull() || node->dep(i).sparsity()!=input(i).sparsity()){
+        const CRSSparsity& sp_input = input(i).sparsity();
+        if(arg[i]==0){
+          std::fill(w,w+sp_input.size(),0.);
+        } else {
+          sp_input.set(w,arg[i],node->dep(i).sparsity());
+        }
+        arg[i] = w;
+        w += sp_input.size();
+      }
+    }
+
+    // Evaluate, with the remainder of the work vector
+    evaluateRaw(arg,res,iw,w);
+  }
+
+  /// Copy the nonzeros of a dependency of a node to a matrix with possibly different sparsity, zero if missing
+  static void setDependency(const MXNode* node, int i, DMatrix& x, const double* val){
+    if(val==0){
+      x.setZero();
+    } else {
+      x.sparsity().set(x.ptr(),val,node->dep(i).sparsity());
+    }
+  }
+
+  void FXInternal::evaluateFwdRaw(MXNode* node, const double** arg, double** res, const double** fseed, double** fsens, int nfwd){
+    int num_in = getNumInputs();
+    int num_out = getNumOutputs();
+
+    // Pass the inputs to the function
+    for(int i=0; i<num_in; ++i){
+      setDependency(node,i,input(i),arg[i]);
+    }
+
+    // Evaluate in batches of at most nfdir_ directions
+    int offset_nfdir = 0;
+    bool fcn_evaluated = false;
+    while(!fcn_evaluated || offset_nfdir < nfwd){
+      int nfdir_f_batch = std::min(nfwd - offset_nfdir, nfdir_);
+
+      // Pass the forward seeds to the function
+      for(int d=0; d<nfdir_f_batch; ++d){
+        for(int i=0; i<num_in; ++i){
+          setDependency(node,i,fwdSeed(i,d),fseed[(offset_nfdir+d)*num_in+i]);
+        }
+      }
+
+      // Evaluate
+      evaluate(nfdir_f_batch,0);
+
+      // Get the outputs if first evaluation
+      if(!fcn_evaluated){
+        for(int i=0; i<num_out; ++i){
+          if(res[i]!=0) copy(output(i).begin(),output(i).end(),res[i]);
+        }
+        fcn_evaluated = true;
+      }
+
+      // Get the forward sensitivities
+      for(int d=0; d<nfdir_f_batch; ++d){
+        for(int i=0; i<num_out; ++i){
+          double* s = fsens[(offset_nfdir+d)*num_out+i];
+          if(s!=0) copy(fwdSens(i,d).begin(),fwdSens(i,d).end(),s);
+        }
+      }
+      offset_nfdir += nfdir_f_batch;
+    }
+  }
+
+  void FXInternal::evaluateAdjRaw(MXNode* node, const double** arg, double** aseed, double** asens, int nadj){
+    int num_in = getNumInputs();
+    int num_out = getNumOutputs();
+
+    // Pass the inputs to the function
+    for(int i=0; i<num_in; ++i){
+      setDependency(node,i,input(i),arg[i]);
+    }
+
+    // Evaluate in batches of at most nadir_ directions
+    for(int offset_nadir=0; offset_nadir<nadj; ){
+      int nadir_f_batch = std::min(nadj - offset_nadir, nadir_);
+
+      // Pass the adjoint seeds to the function and clear them
+      for(int d=0; d<nadir_f_batch; ++d){
+        for(int i=0; i<num_out; ++i){
+          double* s = aseed[(offset_nadir+d)*num_out+i];
+          DMatrix& a = adjSeed(i,d);
+          if(s!=0){
+            copy(s,s+a.size(),a.begin());
+            std::fill(s,s+a.size(),0.);
+          } else {
+            a.setZero();
+          }
+        }
+      }
+
+      // Evaluate
+      evaluate(0,nadir_f_batch);
+
+      // Add the adjoint sensitivities
+      for(int d=0; d<nadir_f_batch; ++d){
+        for(int i=0; i<num_in; ++i){
+          double* s = asens[(offset_nadir+d)*num_in+i];
+          if(s!=0){
+            const DMatrix& a = adjSens(i,d);
+            node->dep(i).sparsity().add(s,a.ptr(),a.sparsity());
+          }
+        }
+      }
+      offset_nadir += nadir_f_batch;
+    }
+  }
+
   void FXInternal::evaluateSX(MXNode* node, const SXMatrixPtrV& arg, SXMatrixPtrV& res,
                               const SXMatrixPtrVV& fseed, SXMatrixPtrVV& fsens,
                               const SXMatrixPtrVV& aseed, SXMatrixPtrVV& asens, std::vector<int>& itmp, std::vector<SX>& rtmp) {
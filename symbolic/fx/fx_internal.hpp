@@ -57,6 +57,22 @@ namespace CasADi{
 
     /** \brief  Evaluate */
     virtual void evaluate(int nfdir, int nadir) = 0;
+
+    /** \brief  Evaluate numerically, reading the input nonzeros from arg and writing the output nonzeros to res.
+        A null pointer in arg is an all-zero input, a null pointer in res an output that is not needed.
+        The default implementation copies to and from input() and output() and calls evaluate(0,0). */
+    virtual void evaluateRaw(const double* const* arg, double* const* res);
+
+    /** \brief  Evaluate numerically as above, but with all temporaries in caller-owned arrays of at least the lengths 
+        returned by workSize. The entries of arg and res past the inputs and outputs are scratch space for pointers.
+        The default implementation falls back to evaluateRaw(arg,res), which is not reentrant. */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Get the length of the argument, result and work arrays needed by evaluateRaw(arg,res,iw,w) */
+    virtual void workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const;
+
+    /** \brief  Can evaluateRaw(arg,res,iw,w) be called concurrently with different work arrays? */
+    virtual bool isReentrant() const{ return false;}
   
     /** \brief  Evaluate with directional derivative compression */
     void evaluateCompressed(int nfdir, int nadir);
@@ -84,6 +100,19 @@ namespace CasADi{
 
     /** \brief  Reset the sparsity propagation */
     virtual void spInit(bool fwd){}
+
+    /** \brief  Is the class able to propagate wide seeds with spEvaluateWide? */
+    virtual bool spCanEvaluateWide(bool fwd) const{ return false;}
+
+    /** \brief  Length of the work vector of spEvaluateWide, per bvec_t of the seeds */
+    virtual int spWideWorkSize() const{ return 0;}
+
+    /** \brief  Propagate nw*bvec_size directions from input iind to output oind (forward) or from output oind to input iind (backward)
+    * The seeds and sensitivities hold nw consecutive bvec_t for each nonzero. The remaining inputs and outputs are treated as zero.
+    * The input and output data of the function are not touched, so the function can be called concurrently with different
+    * work vectors w, of length spWideWorkSize()*nw and zero before the first call.
+    */
+    virtual void spEvaluateWide(bool fwd, int iind, int oind, int nw, const bvec_t* seed, bvec_t* sens, bvec_t* w) const;
     
     /** \brief  Evaluate symbolically, SX type, possibly nonmatching sparsity patterns */
     virtual void evalSX(const std::vector<SXMatrix>& arg, std::vector<SXMatrix>& res, 
@@ -170,11 +199,25 @@ namespace CasADi{
     /** \brief  Print to a c file */
     virtual void generateCode(const std::string& filename);
 
+    /** \brief  Print c code to a stream */
+    void generateCode(std::ostream &cfile);
+
     /** \brief Generate code for function inputs and outputs */
     void generateIO(CodeGenerator& gen);
 
-    /** \brief Generate code the functon */
-    virtual void generateFunction(std::ostream &stream, const std::string& fname, const std::string& input_type, const std::string& output_type, const std::string& type, CodeGenerator& gen) const;
+    /** \brief Generate code the functon
+     * Unless work_arguments is false, the function takes an integer and a real work vector 
+     * as the two last arguments, making the generated code reentrant.
+     */
+    virtual void generateFunction(std::ostream &stream, const std::string& fname, const std::string& input_type, const std::string& output_type, const std::string& type, CodeGenerator& gen, bool work_arguments=true) const;
+    
+    /** \brief Get the length of the integer and real work vectors needed by the generated code */
+    virtual void workSizeCode(size_t& ni, size_t& nr) const;
+    
+    /** \brief Get the length of the beginning of the real work vector of the generated code that holds data kept
+     * between calls with the same work vector, e.g. a cached factorization. It must be zero before the first call and not be shared with other functions.
+     */
+    virtual size_t persistentSizeCode() const;
     
     /** \brief Generate code for the declarations of the C function */
     virtual void generateDeclarations(std::ostream &stream, const std::string& type, CodeGenerator& gen) const;
@@ -182,6 +225,9 @@ namespace CasADi{
     /** \brief Generate code for the function body */
     virtual void generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const;
 
+    /** \brief Generate additional, vectorized entry points of the C file, if supported */
+    virtual void generateVectorized(std::ostream &stream, CodeGenerator& gen) const;
+
     /** \brief  Print */
     virtual void print(std::ostream &stream) const;
     
@@ -215,6 +261,15 @@ namespace CasADi{
     /// A flavour of getJacSparsity without any magic
     CRSSparsity getJacSparsityPlain(int iind, int oind);
     
+    /// A flavour of getJacSparsity that propagates wide bitsets, possibly in parallel, with spEvaluateWide
+    CRSSparsity getJacSparsityWide(int iind, int oind, bool symmetric);
+
+    /** \brief Propagate sets of seed nonzeros in wide bitsets with spEvaluateWide, on the shared thread pool
+    * Direction d seeds the nonzeros dir_nz[dir_offset[d]], ..., dir_nz[dir_offset[d+1]-1].
+    * Returns the dependencies as pairs (sensitivity nonzero sens_el[k], direction dir[k]).
+    */
+    void propagateWide(int iind, int oind, bool fwd, const std::vector<int>& dir_offset, const std::vector<int>& dir_nz, std::vector<int>& sens_el, std::vector<int>& dir);
+
     /// A flavour of getJacSparsity that does hierachical block structure recognition
     CRSSparsity getJacSparsityHierarchical(int iind, int oind);
     
@@ -226,6 +281,20 @@ namespace CasADi{
     
     /// Get, if necessary generate, the sparsity of a Jacobian block
     CRSSparsity& jacSparsity(int iind, int oind, bool compact, bool symmetric);
+
+    /** \brief Hash of the structure of the function, identical for functions with the same Jacobian sparsity, also across processes
+    * Used as a key in the on-disk sparsity cache (CasadiOptions::sparsity_cache_dir), an empty string means that caching is not possible
+    */
+    virtual std::string structuralHash() const{ return "";}
+
+    /// Filename in the on-disk sparsity cache, or an empty string if not cached
+    std::string sparsityCacheFile(const std::string& what, int iind, int oind, bool symmetric) const;
+
+    /// Read sparsity patterns from the on-disk sparsity cache, returns false if not found or corrupt
+    static bool readSparsityCache(const std::string& fname, std::vector<CRSSparsity>& sp);
+
+    /// Write sparsity patterns to the on-disk sparsity cache
+    static void writeSparsityCache(const std::string& fname, const std::vector<CRSSparsity>& sp);
     
     /// Get a vector of symbolic variables with the same dimensions as the inputs
     virtual std::vector<MX> symbolicInput() const;
@@ -279,6 +348,10 @@ namespace CasADi{
     // Codegen function
     FX dynamicCompilation(FX f, std::string fname, std::string fdescr, std::string compiler);
 
+    // Codegen functions, compiling in parallel
+    std::vector<FX> dynamicCompilation(const std::vector<FX>& f, const std::vector<std::string>& fname, 
+                                       const std::vector<std::string>& fdescr, std::string compiler);
+
     // The following functions are called internally from EvaluateMX. For documentation, see the MXNode class
     //@{
     virtual void evaluateD(MXNode* node, const DMatrixPtrV& arg, DMatrixPtrV& res, const DMatrixPtrVV& fseed, DMatrixPtrVV& fsens, const DMatrixPtrVV& aseed, DMatrixPtrVV& asens, std::vector<int>& itmp, std::vector<double>& rtmp);
@@ -286,6 +359,9 @@ namespace CasADi{
     virtual void evaluateMX(MXNode* node, const MXPtrV& arg, MXPtrV& res, const MXPtrVV& fseed, MXPtrVV& fsens, const MXPtrVV& aseed, MXPtrVV& asens, bool output_given);
     virtual void propagateSparsity(MXNode* node, DMatrixPtrV& input, DMatrixPtrV& output, std::vector<int>& itmp, std::vector<double>& rtmp, bool fwd);
     virtual void nTmp(MXNode* node, size_t& ni, size_t& nr);
+    virtual void evaluateRaw(MXNode* node, const double** arg, double** res, int* iw, double* w);
+    virtual void evaluateFwdRaw(MXNode* node, const double** arg, double** res, const double** fseed, double** fsens, int nfwd);
+    virtual void evaluateAdjRaw(MXNode* node, const double** arg, double** aseed, double** asens, int nadj);
     virtual void generateOperation(const MXNode* node, std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
     virtual void printPart(const MXNode* node, std::ostream &stream, int part) const;
     //@}
@@ -283,6 +283,19 @@ std::pair<FX,FX> IntegratorInternal::getAugmentedGen(int nfwd, int nadj){
     rdae_in[RDAE_P]=p;
     rdae_in[RDAE_T]=t;
   }
+  
+  // Missing expressions (null MX) are treated as empty
+  if(rdae_in[RDAE_RX].isNull()) rdae_in[RDAE_RX] = Mat::sym("rx",0,0);
+  if(rdae_in[RDAE_RZ].isNull()) rdae_in[RDAE_RZ] = Mat::sym("rz",0,0);
+  if(rdae_in[RDAE_RP].isNull()) rdae_in[RDAE_RP] = Mat::sym("rp",0,0);
+  for(int i=0; i<RDAE_NUM_OUT; ++i){
+    if(rdae_out[i].isNull()) rdae_out[i] = Mat(0,0);
+  }
+  if(alg.isNull()) alg = Mat(0,0);
+  if(quad.isNull()) quad = Mat(0,0);
+  dae_out[DAE_ALG] = alg;
+  dae_out[DAE_QUAD] = quad;
+  
   Mat rx = rdae_in[RDAE_RX];
   Mat rz = rdae_in[RDAE_RZ];
   Mat rp = rdae_in[RDAE_RP];
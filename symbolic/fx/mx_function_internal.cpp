@@ -29,6 +29,8 @@
 #include "../casadi_types.hpp"
 
 #include <stack>
+#include <map>
+#include <set>
 #include <typeinfo>
 
 using namespace std;
@@ -344,6 +346,35 @@ namespace CasADi{
       }
     }
   
+    // Memory layout for evaluateRaw: the intermediate variables followed by the temporaries of the operations
+    allocWork(live_variables);
+    int sz_arg_op=0, sz_res_op=0, sz_iw_op=0, sz_w_op=0;
+    reentrant_ = true;
+    for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      if(it->op==OP_INPUT || it->op==OP_OUTPUT || it->op==OP_PARAMETER) continue;
+      size_t ni=0, nr=0;
+      it->data->nTmp(ni,nr);
+      int n_arg = it->arg.size(), n_res = it->res.size(), n_iw = ni, n_w = nr;
+      if(it->op==OP_CALL){
+        // Called functions get the part of the work arrays not used by the node
+        int f_arg, f_res, f_iw, f_w;
+        it->data->getFunction().workSize(f_arg,f_res,f_iw,f_w);
+        n_arg = std::max(n_arg,f_arg);
+        n_res = std::max(n_res,f_res);
+        n_iw += f_iw;
+        n_w += f_w;
+      }
+      sz_arg_op = std::max(sz_arg_op,n_arg);
+      sz_res_op = std::max(sz_res_op,n_res);
+      sz_iw_op = std::max(sz_iw_op,n_iw);
+      sz_w_op = std::max(sz_w_op,n_w);
+      reentrant_ = reentrant_ && it->data->isReentrant();
+    }
+    sz_arg_ = getNumInputs() + sz_arg_op;
+    sz_res_ = getNumOutputs() + sz_res_op;
+    sz_iw_ = sz_iw_op;
+    sz_w_ = sz_work_ + sz_w_op;
+
     // Allocate tape
     allocTape();
   
@@ -358,11 +389,22 @@ namespace CasADi{
     // Call the base class if needed
     if(recursive) XFunctionInternal<MXFunction,MXFunctionInternal,MX,MXNode>::updateNumSens(recursive);
   
-    // Allocate work for directional derivatives
-    for(vector<FunctionIO>::iterator it=work_.begin(); it!=work_.end(); it++){
-      it->dataF.resize(nfdir_,it->data);
-      it->dataA.resize(nadir_,it->data);
-    }
+    // Quick return if not yet initialized
+    if(spill_offset_.empty()) return;
+
+    // Allocate the work arrays, including the directional derivatives and the tape
+    int nw = sz_work_;
+    arg_raw_.resize(sz_arg_);
+    res_raw_.resize(sz_res_);
+    iw_raw_.resize(sz_iw_);
+    w_raw_.resize(sz_w_ + (nfdir_+nadir_)*nw + (nadir_>0 ? spill_offset_.back() : 0));
+
+    // Pointers to the directional derivatives of the operations
+    int sz_arg_op = sz_arg_ - getNumInputs(), sz_res_op = sz_res_ - getNumOutputs();
+    fseed_raw_.resize(nfdir_*sz_arg_op);
+    fsens_raw_.resize(nfdir_*sz_res_op);
+    aseed_raw_.resize(nadir_*sz_res_op);
+    asens_raw_.resize(nadir_*sz_arg_op);
 
     // Request more derivative from the embedded functions
     for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
@@ -376,51 +418,19 @@ namespace CasADi{
     }
   }
 
-  void MXFunctionInternal::updatePointers(const AlgEl& el, int nfdir, int nadir){
+  void MXFunctionInternal::updatePointers(const AlgEl& el){
     mx_input_.resize(el.arg.size());
     mx_output_.resize(el.res.size());
-
-    mx_fwdSeed_.resize(nfdir);
-    mx_fwdSens_.resize(nfdir);
-    for(int d=0; d<nfdir; ++d){
-      mx_fwdSeed_[d].resize(mx_input_.size());
-      mx_fwdSens_[d].resize(mx_output_.size());
-    }
-
-    mx_adjSens_.resize(nadir);
-    mx_adjSeed_.resize(nadir);
-    for(int d=0; d<nadir; ++d){
-      mx_adjSens_[d].resize(mx_input_.size());
-      mx_adjSeed_[d].resize(mx_output_.size());
-    }
   
     if(el.op!=OP_INPUT){
       for(int i=0; i<mx_input_.size(); ++i){
-        if(el.arg[i]>=0){
-          int k = el.arg[i];
-          int tmp = work_[k].tmp; // Positive if the data should be retrieved from the tape instead of the work vector
-          mx_input_[i] = tmp==0 ? &work_[k].data : &tape_[tmp-1].second;
-          for(int d=0; d<nfdir; ++d) mx_fwdSeed_[d][i] = &work_[k].dataF[d];
-          for(int d=0; d<nadir; ++d) mx_adjSens_[d][i] = &work_[k].dataA[d];
-        } else {
-          mx_input_[i] = 0;
-          for(int d=0; d<nfdir; ++d) mx_fwdSeed_[d][i] = 0;
-          for(int d=0; d<nadir; ++d) mx_adjSens_[d][i] = 0;
-        }
+        mx_input_[i] = el.arg[i]>=0 ? &work_[el.arg[i]].data : 0;
       }
     }
   
     if(el.op!=OP_OUTPUT){
       for(int i=0; i<mx_output_.size(); ++i){
-        if(el.res[i]>=0){
-          mx_output_[i] = &work_[el.res[i]].data;
-          for(int d=0; d<nfdir; ++d) mx_fwdSens_[d][i] = &work_[el.res[i]].dataF[d];
-          for(int d=0; d<nadir; ++d) mx_adjSeed_[d][i] = &work_[el.res[i]].dataA[d];
-        } else {
-          mx_output_[i] = 0;
-          for(int d=0; d<nfdir; ++d) mx_fwdSens_[d][i] = 0;
-          for(int d=0; d<nadir; ++d) mx_adjSeed_[d][i] = 0;
-        }
+        mx_output_[i] = el.res[i]>=0 ? &work_[el.res[i]].data : 0;
       }
     }
   }
@@ -434,6 +444,28 @@ namespace CasADi{
       repr(ss);
       casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
     }
+
+    // Without derivatives, the evaluation is the one of evaluateRaw
+    if(nfdir==0 && nadir==0){
+      for(int i=0; i<getNumInputs(); ++i) arg_raw_[i] = input(i).ptr();
+      for(int i=0; i<getNumOutputs(); ++i) res_raw_[i] = output(i).ptr();
+      evaluateRaw(getPtr(arg_raw_),getPtr(res_raw_),getPtr(iw_raw_),getPtr(w_raw_));
+      casadi_log("MXFunctionInternal::evaluate(" << nfdir << ", " << nadir<< "):end "  << getOption("name"));
+      return;
+    }
+
+    // Pointers to the arguments and results of the operations
+    const double** arg = getPtr(arg_raw_) + getNumInputs();
+    double** res = getPtr(res_raw_) + getNumOutputs();
+
+    // Layout of the real work array: the work vector, the temporaries, the forward and adjoint derivatives and the tape
+    int nw = sz_work_;
+    double* w = getPtr(w_raw_);
+    double* w_tmp = w + nw;
+    double* w_fwd = w + sz_w_;
+    double* w_adj = w_fwd + nfdir_*nw;
+    double* w_tape = w_adj + nadir_*nw;
+    int* iw = getPtr(iw_raw_);
   
     // Tape counter
     int tt = 0;
@@ -442,34 +474,53 @@ namespace CasADi{
     int alg_counter = 0;
     for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it, ++alg_counter){
   
-      // Spill existing work elements if needed
-      if(nadir>0 && it->op!=OP_OUTPUT){
-        for(vector<int>::const_iterator c=it->res.begin(); c!=it->res.end(); ++c){
-          if(*c >=0 && tt<tape_.size() && tape_[tt].first == make_pair(alg_counter,*c)){
-            tape_[tt++].second.set(work_[*c].data);
-          }
+      // Spill the memory about to be overwritten if needed
+      if(nadir>0){
+        for(; tt<spill_.size() && spill_[tt].first==alg_counter; ++tt){
+          int len = spill_offset_[tt+1]-spill_offset_[tt];
+          copy(w+spill_[tt].second,w+spill_[tt].second+len,w_tape+spill_offset_[tt]);
         }
       }
     
       if(it->op==OP_INPUT){
         // Pass the input and forward seeeds
-        work_[it->res.front()].data.set(input(it->arg.front()));
+        int k = it->res.front(), i = it->arg.front();
+        copy(input(i).begin(),input(i).end(),w+work_offset_[k]);
         for(int dir=0; dir<nfdir; ++dir){
-          work_[it->res.front()].dataF.at(dir).set(fwdSeed(it->arg.front(),dir));
+          copy(fwdSeed(i,dir).begin(),fwdSeed(i,dir).end(),w_fwd+dir*nw+work_offset_[k]);
         }
       } else if(it->op==OP_OUTPUT){
         // Get the outputs and forward sensitivities
-        work_[it->arg.front()].data.get(output(it->res.front()));
+        int k = it->arg.front(), i = it->res.front();
+        copy(w+work_offset_[k],w+work_offset_[k]+output(i).size(),output(i).begin());
         for(int dir=0; dir<nfdir; ++dir){
-          work_[it->arg.front()].dataF.at(dir).get(fwdSens(it->res.front(),dir));
+          copy(w_fwd+dir*nw+work_offset_[k],w_fwd+dir*nw+work_offset_[k]+output(i).size(),fwdSens(i,dir).begin());
         }
       } else {
 
-        // Point pointers to the data corresponding to the element
-        updatePointers(*it,nfdir,0);
+        // Point to the work vector elements of the operation
+        int n_arg = it->arg.size(), n_res = it->res.size();
+        for(int c=0; c<n_arg; ++c){
+          arg[c] = it->arg[c]>=0 ? w + work_offset_[it->arg[c]] : 0;
+        }
+        for(int c=0; c<n_res; ++c){
+          res[c] = it->res[c]>=0 ? w + work_offset_[it->res[c]] : 0;
+        }
 
         // Evaluate
-        it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_, itmp_, rtmp_);
+        if(nfdir==0){
+          it->data->evaluateRaw(arg,res,iw,w_tmp);
+        } else {
+          for(int dir=0; dir<nfdir; ++dir){
+            for(int c=0; c<n_arg; ++c){
+              fseed_raw_[dir*n_arg+c] = it->arg[c]>=0 ? w_fwd + dir*nw + work_offset_[it->arg[c]] : 0;
+            }
+            for(int c=0; c<n_res; ++c){
+              fsens_raw_[dir*n_res+c] = it->res[c]>=0 ? w_fwd + dir*nw + work_offset_[it->res[c]] : 0;
+            }
+          }
+          it->data->evaluateFwdRaw(arg,res,getPtr(fseed_raw_),getPtr(fsens_raw_),nfdir,iw,w_tmp);
+        }
       }
     }
   
@@ -479,56 +530,54 @@ namespace CasADi{
       casadi_log("MXFunctionInternal::evaluate(" << nfdir << ", " << nadir<< "):adjoints:begin "  << getOption("name"));
     
       // Clear the adjoint seeds
-      for(vector<FunctionIO>::iterator it=work_.begin(); it!=work_.end(); it++){
-        for(int dir=0; dir<nadir; ++dir){
-          fill(it->dataA.at(dir).begin(),it->dataA.at(dir).end(),0.0);
-        }
-      }
+      std::fill(w_adj,w_adj+nadir*nw,0.0);
 
       // Evaluate all of the nodes of the algorithm: should only evaluate nodes that have not yet been calculated!
       int alg_counter = algorithm_.size()-1;
       tt--;
       for(vector<AlgEl>::reverse_iterator it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it, --alg_counter){
       
-        // Mark spilled work vector elements to be recovered to allow the operator input to be updated but not the operator output 
+        // Recover the spilled memory: the adjoint propagation only needs the operator inputs, not the operator outputs
         // (important for inplace operations)
-        if(it->op!=OP_OUTPUT){
-          for(vector<int>::const_reverse_iterator c=it->res.rbegin(); c!=it->res.rend(); ++c){
-            if(*c >=0 && tt>=0 && tape_[tt].first==make_pair(alg_counter,*c)){
-              work_[*c].tmp = 1 + tt--;
-            }
-          }
+        for(; tt>=0 && spill_[tt].first==alg_counter; --tt){
+          int len = spill_offset_[tt+1]-spill_offset_[tt];
+          copy(w_tape+spill_offset_[tt],w_tape+spill_offset_[tt]+len,w+spill_[tt].second);
         }
 
-        // Point pointers to the data corresponding to the element
-        updatePointers(*it,0,nadir);
-      
         if(it->op==OP_INPUT){
           // Get the adjoint sensitivity
+          int k = it->res.front(), i = it->arg.front();
           for(int dir=0; dir<nadir; ++dir){
-            mx_adjSeed_[dir].front()->get(adjSens(it->arg.front(),dir));
-            mx_adjSeed_[dir].front()->setZero();
+            double* a = w_adj + dir*nw + work_offset_[k];
+            copy(a,a+adjSens(i,dir).size(),adjSens(i,dir).begin());
+            std::fill(a,a+adjSens(i,dir).size(),0.0);
           }
         } else if(it->op==OP_OUTPUT){
           // Pass the adjoint seeds
+          int k = it->arg.front(), i = it->res.front();
           for(int dir=0; dir<nadir; ++dir){
-            const DMatrix& aseed = adjSeed(it->res.front(),dir);
-            DMatrix& aseed_dest = *mx_adjSens_[dir].front();
-            transform(aseed_dest.begin(),aseed_dest.end(),aseed.begin(),aseed_dest.begin(),std::plus<double>());
+            const DMatrix& aseed = adjSeed(i,dir);
+            double* a = w_adj + dir*nw + work_offset_[k];
+            transform(aseed.begin(),aseed.end(),a,a,std::plus<double>());
           }
-        } else {        
-          // Evaluate
-          it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_, itmp_, rtmp_);
-        }
-
-        // Recover the spilled elements to the work vector for later access (delayed for inplace operations)
-        if(it->op!=OP_OUTPUT){
-          for(vector<int>::const_reverse_iterator c=it->res.rbegin(); c!=it->res.rend(); ++c){          
-            if(*c >=0 && work_[*c].tmp > 0){
-              tape_[work_[*c].tmp-1].second.get(work_[*c].data);
-              work_[*c].tmp = 0;
+        } else {
+          // Point to the work vector elements of the operation
+          int n_arg = it->arg.size(), n_res = it->res.size();
+          for(int c=0; c<n_arg; ++c){
+            int k = it->arg[c];
+            arg[c] = k>=0 ? w + work_offset_[k] : 0;
+            for(int dir=0; dir<nadir; ++dir){
+              asens_raw_[dir*n_arg+c] = k>=0 ? w_adj + dir*nw + work_offset_[k] : 0;
+            }
+          }
+          for(int dir=0; dir<nadir; ++dir){
+            for(int c=0; c<n_res; ++c){
+              aseed_raw_[dir*n_res+c] = it->res[c]>=0 ? w_adj + dir*nw + work_offset_[it->res[c]] : 0;
             }
           }
+
+          // Propagate the adjoint seeds
+          it->data->evaluateAdjRaw(arg,getPtr(aseed_raw_),getPtr(asens_raw_),nadir,iw,w_tmp);
         }
       }
     
@@ -537,6 +586,67 @@ namespace CasADi{
     casadi_log("MXFunctionInternal::evaluate(" << nfdir << ", " << nadir<< "):end "  << getOption("name"));
   }
 
+  void MXFunctionInternal::evaluateRaw(const double* const* arg, double* const* res){
+    copy(arg,arg+getNumInputs(),arg_raw_.begin());
+    copy(res,res+getNumOutputs(),res_raw_.begin());
+    evaluateRaw(getPtr(arg_raw_),getPtr(res_raw_),getPtr(iw_raw_),getPtr(w_raw_));
+  }
+
+  void MXFunctionInternal::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    // Make sure that there are no free variables
+    if (!free_vars_.empty()) {
+      std::stringstream ss;
+      repr(ss);
+      casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+    }
+
+    // Pointers to the arguments and results of the operations
+    const double** arg1 = arg + getNumInputs();
+    double** res1 = res + getNumOutputs();
+
+    // Temporaries of the operations
+    double* w1 = w + sz_work_;
+
+    for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      if(it->op==OP_INPUT){
+        // Copy the input to the work vector
+        int k = it->res.front();
+        double* x = w + work_offset_[k];
+        const double* x_in = arg[it->arg.front()];
+        if(x_in==0){
+          std::fill(x,x+work_[k].data.size(),0.);
+        } else {
+          copy(x_in,x_in+work_[k].data.size(),x);
+        }
+      } else if(it->op==OP_OUTPUT){
+        // Copy the output from the work vector
+        int k = it->arg.front();
+        double* r = res[it->res.front()];
+        if(r!=0){
+          copy(w+work_offset_[k],w+work_offset_[k]+work_[k].data.size(),r);
+        }
+      } else {
+        // Point to the work vector elements of the operation
+        for(int c=0; c<it->arg.size(); ++c){
+          arg1[c] = it->arg[c]>=0 ? w + work_offset_[it->arg[c]] : 0;
+        }
+        for(int c=0; c<it->res.size(); ++c){
+          res1[c] = it->res[c]>=0 ? w + work_offset_[it->res[c]] : 0;
+        }
+
+        // Evaluate
+        it->data->evaluateRaw(arg1,res1,iw,w1);
+      }
+    }
+  }
+
+  void MXFunctionInternal::workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const{
+    sz_arg = sz_arg_;
+    sz_res = sz_res_;
+    sz_iw = sz_iw_;
+    sz_w = sz_w_;
+  }
+
   void MXFunctionInternal::print(ostream &stream) const{
     FXInternal::print(stream);
     for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
@@ -629,7 +739,7 @@ namespace CasADi{
           copy(iwork,iwork+w.size(),swork);
         } else {
           // Point pointers to the data corresponding to the element
-          updatePointers(*it,0,0);
+          updatePointers(*it);
 
           // Propagate sparsity forwards
           it->data->propagateSparsity(mx_input_, mx_output_, itmp_, rtmp_, true);
@@ -659,7 +769,7 @@ namespace CasADi{
           }
         } else {
           // Point pointers to the data corresponding to the element
-          updatePointers(*it,0,0);
+          updatePointers(*it);
         
           // Propagate sparsity backwards
           it->data->propagateSparsity(mx_input_, mx_output_, itmp_, rtmp_, false);
@@ -784,7 +894,7 @@ namespace CasADi{
     if(nadir>0){
       tape.resize(tape_.size());
       for(int k=0; k<tape.size(); ++k){
-        tape[k].first = tape_[k].first;
+        tape[k].first = tape_[k];
       }
     }
 
@@ -1090,35 +1200,161 @@ namespace CasADi{
   }
 
   void MXFunctionInternal::printTape(ostream &stream){
-    for(int k=0; k<tape_.size(); ++k){
-      stream << "tape( algorithm index = " << tape_[k].first.first << ", work index = " << tape_[k].first.second << ") = " << tape_[k].second.data() << endl;
+    const double* w_tape = getPtr(w_raw_) + sz_w_ + (nfdir_+nadir_)*sz_work_;
+    for(int k=0; k<spill_.size(); ++k){
+      stream << "tape( algorithm index = " << spill_[k].first << ", offset = " << spill_[k].second << ") = ";
+      if(nadir_>0){
+        stream << vector<double>(w_tape+spill_offset_[k],w_tape+spill_offset_[k+1]) << endl;
+      } else {
+        stream << "not allocated" << endl;
+      }
     }
   }
 
   void MXFunctionInternal::printWork(int nfdir, int nadir, ostream &stream){
+    int nw = sz_work_;
+    const double* w = getPtr(w_raw_);
     for(int k=0; k<work_.size(); ++k){
-      stream << "work[" << k << "] = " << work_[k].data.data() << endl;
+      const double* x = w + work_offset_[k];
+      stream << "work[" << k << "] = " << vector<double>(x,x+work_[k].data.size()) << endl;
     }
   
     for(int d=0; d<nfdir; ++d){
+      const double* w_fwd = w + sz_w_ + d*nw;
       for(int k=0; k<work_.size(); ++k){
-        stream << "fwork[" << d << "][" << k << "] = " << work_[k].dataF[d].data() << endl;
+        const double* x = w_fwd + work_offset_[k];
+        stream << "fwork[" << d << "][" << k << "] = " << vector<double>(x,x+work_[k].data.size()) << endl;
       }
     }
   
     for(int d=0; d<nadir; ++d){
+      const double* w_adj = w + sz_w_ + (nfdir_+d)*nw;
       for(int k=0; k<work_.size(); ++k){
-        stream << "awork[" << d << "][" << k << "] = " << work_[k].dataA[d].data() << endl;
+        const double* x = w_adj + work_offset_[k];
+        stream << "awork[" << d << "][" << k << "] = " << vector<double>(x,x+work_[k].data.size()) << endl;
+      }
+    }
+  }
+
+  void MXFunctionInternal::allocWork(bool live_variables){
+    work_offset_.resize(work_.size());
+    sz_work_ = 0;
+    
+    // Without live variables, each element gets its own memory
+    if(!live_variables){
+      for(int k=0; k<work_.size(); ++k){
+        work_offset_[k] = sz_work_;
+        sz_work_ += work_[k].data.size();
+      }
+      return;
+    }
+    
+    // Lifetime of each element: from the first time it is written to the last time it is read
+    vector<int> first_write(work_.size(),-1), last_read(work_.size(),-1);
+    int alg_counter = 0;
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it, ++alg_counter){
+      if(it->op!=OP_INPUT){
+        for(vector<int>::const_iterator c=it->arg.begin(); c!=it->arg.end(); ++c){
+          if(*c>=0) last_read[*c] = alg_counter;
+        }
+      }
+      if(it->op!=OP_OUTPUT){
+        for(vector<int>::const_iterator c=it->res.begin(); c!=it->res.end(); ++c){
+          if(*c>=0 && first_write[*c]<0) first_write[*c] = alg_counter;
+        }
+      }
+    }
+    
+    // Elements sorted by the beginning of their lifetimes, the largest first, and by the end of their lifetimes
+    vector<pair<pair<int,int>,int> > by_first(work_.size()), by_last(work_.size());
+    for(int k=0; k<work_.size(); ++k){
+      by_first[k] = make_pair(make_pair(first_write[k],-work_[k].data.size()),k);
+      by_last[k] = make_pair(make_pair(std::max(first_write[k],last_read[k]),0),k);
+    }
+    sort(by_first.begin(),by_first.end());
+    sort(by_last.begin(),by_last.end());
+    
+    // Free blocks of memory, sorted by offset and by length
+    map<int,int> free_by_offset;
+    set<pair<int,int> > free_by_length;
+    
+    // Linear scan over the lifetimes, results of an operation are allocated before its arguments are freed
+    vector<pair<pair<int,int>,int> >::const_iterator next_first=by_first.begin(), next_last=by_last.begin();
+    while(next_last!=by_last.end()){
+      if(next_first!=by_first.end() && next_first->first.first <= next_last->first.first){
+        int k = next_first++->second;
+        int n = work_[k].data.size();
+        work_offset_[k] = 0;
+        if(n==0) continue;
+      
+        // Best fit among the free blocks
+        set<pair<int,int> >::iterator b = free_by_length.lower_bound(make_pair(n,0));
+        if(b!=free_by_length.end()){
+          int offset = b->second, len = b->first;
+          free_by_length.erase(b);
+          free_by_offset.erase(offset);
+          if(len>n){
+            free_by_offset[offset+n] = len-n;
+            free_by_length.insert(make_pair(len-n,offset+n));
+          }
+          work_offset_[k] = offset;
+          continue;
+        }
+        
+        // Grow the memory, extending a free block at the end if any
+        map<int,int>::iterator e = free_by_offset.empty() ? free_by_offset.end() : --free_by_offset.end();
+        if(e!=free_by_offset.end() && e->first+e->second==sz_work_){
+          work_offset_[k] = e->first;
+          free_by_length.erase(make_pair(e->second,e->first));
+          free_by_offset.erase(e);
+          sz_work_ = work_offset_[k] + n;
+        } else {
+          work_offset_[k] = sz_work_;
+          sz_work_ += n;
+        }
+      } else {
+        int k = next_last++->second;
+        int offset = work_offset_[k], len = work_[k].data.size();
+        if(len==0) continue;
+        
+        // Merge with the neighboring free blocks
+        map<int,int>::iterator e = free_by_offset.find(offset+len);
+        if(e!=free_by_offset.end()){
+          len += e->second;
+          free_by_length.erase(make_pair(e->second,e->first));
+          free_by_offset.erase(e);
+        }
+        e = free_by_offset.lower_bound(offset);
+        if(e!=free_by_offset.begin() && (--e)->first+e->second==offset){
+          offset = e->first;
+          len += e->second;
+          free_by_length.erase(make_pair(e->second,e->first));
+          free_by_offset.erase(e);
+        }
+        free_by_offset[offset] = len;
+        free_by_length.insert(make_pair(len,offset));
       }
     }
+    
+    if(verbose()){
+      int sz_all = 0;
+      for(int k=0; k<work_.size(); ++k) sz_all += work_[k].data.size();
+      cout << "Using live variables: work array has " << sz_work_ << " nonzeros instead of " << sz_all << endl;
+    }
   }
 
   void MXFunctionInternal::allocTape(){
     // Marker of elements in the work vector still in use when being overwritten
     vector<bool> in_use(work_.size(),false);
   
+    // Marker of memory in the real work array that has been written, elements may share memory
+    vector<bool> written(sz_work_,false);
+  
     // Remove existing entries in the tape
     tape_.clear();
+    spill_.clear();
+    spill_offset_.clear();
+    spill_offset_.push_back(0);
   
     // Evaluate the algorithm, keeping track of variables that are in use
     int alg_counter = 0;
@@ -1130,11 +1366,24 @@ namespace CasADi{
           if(ind>=0){
             if(in_use[ind]){
               // Spill
-              tape_.push_back(make_pair(make_pair(alg_counter,ind),DMatrix(it->data->sparsity(c))));
+              tape_.push_back(make_pair(alg_counter,ind));
             } else {
               // Mark in use
               in_use[ind] = true;
             }
+            
+            // Spill the blocks of memory that have already been written
+            int start = work_offset_[ind], stop = start + work_[ind].data.size();
+            for(int i=start; i<stop; ){
+              if(!written[i]){
+                written[i++] = true;
+              } else {
+                int i_begin = i;
+                while(i<stop && written[i]) ++i;
+                spill_.push_back(make_pair(alg_counter,i_begin));
+                spill_offset_.push_back(spill_offset_.back() + i - i_begin);
+              }
+            }
           }
         }
       }
@@ -1166,29 +1415,75 @@ namespace CasADi{
     }
   }
 
+  size_t MXFunctionInternal::dedicatedSizeCode(const AlgEl& el) const{
+    if(el.op!=OP_CALL && el.op!=OP_SOLVE) return 0;
+    if(el.data->getFunction()->persistentSizeCode()==0) return 0;
+
+    // Temporaries of the operation and the complete work vector of the called function
+    size_t ni_op, nr_op, ni_f, nr_f;
+    const_cast<MX&>(el.data)->nTmp(ni_op,nr_op);
+    el.data->getFunction()->workSizeCode(ni_f,nr_f);
+    return nr_op + nr_f;
+  }
+
+  size_t MXFunctionInternal::persistentSizeCode() const{
+    // Calls to functions with persistent data get a dedicated part of the real work vector each
+    size_t np = 0;
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      np += dedicatedSizeCode(*it);
+    }
+    return np;
+  }
+
+  void MXFunctionInternal::workSizeCode(size_t& ni, size_t& nr) const{
+    // Intermediate variables
+    size_t nw = 0;
+    for(int i=0; i<work_.size(); ++i){
+      nw += work_[i].data.size();
+    }
+
+    // Temporaries, including the work vectors of called functions
+    ni = 0;
+    nr = 0;
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      if(it->op==OP_INPUT || it->op==OP_OUTPUT) continue;
+      size_t ni_op, nr_op;
+      const_cast<MX&>(it->data)->nTmp(ni_op,nr_op);
+      if(it->op==OP_CALL || it->op==OP_SOLVE){
+        size_t ni_f, nr_f;
+        it->data->getFunction()->workSizeCode(ni_f,nr_f);
+        ni_op += ni_f;
+        nr_op += nr_f;
+      }
+      ni = std::max(ni,ni_op);
+      if(dedicatedSizeCode(*it)==0) nr = std::max(nr,nr_op);
+    }
+    nr += persistentSizeCode() + nw;
+  }
+
   void MXFunctionInternal::generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const{
     
-    // Data structure to hold intermediate variables
-    stream << "  static struct wstruct{" << endl;
-    
-    // Declare all work variables
+    // Dedicated parts for calls to functions with persistent data come first, then the intermediate variables
+    size_t np = persistentSizeCode();
+    size_t nw = np;
     for(int i=0; i<work_.size(); ++i){
-      stream << "    d a" << i << "[" << work_[i].data.size() << "];" << endl;
+      stream << "  d *a" << i << "=w+" << nw << ";" << endl;
+      nw += work_[i].data.size();
     }
-    
-    // Finalize work structure
-    stream << "  } w;" << endl;
     stream << endl;
 
     // Temporary variables and vectors
     stream << "  int i,j,k,*ii,*jj,*kk;" << endl;
     stream << "  d r,s,t,*rr,*ss,*tt;" << endl;
-    stream << "  static int iii[" << itmp_.size() << "];" << endl;
-    stream << "  static d rrr[" << rtmp_.size() << "];" << endl;
+    stream << "  int *iii=iw;" << endl;
+    stream << "  d *rrr=w+" << nw << ";" << endl;
 
     // Operation number (for printing)
     int k=0;
     
+    // Offset of the next dedicated part of the real work vector
+    size_t ip = 0;
+    
     // Names of operation argument and results
     vector<string> arg,res;
         
@@ -1213,7 +1508,7 @@ namespace CasADi{
       } else {
         for(int i=0; i<it->arg.size(); ++i){
           if(it->arg.at(i)>=0){
-            arg.at(i) = "w.a" + CodeGenerator::numToString(it->arg.at(i));
+            arg.at(i) = "a" + CodeGenerator::numToString(it->arg.at(i));
           } else {
             arg.at(i) = "0";
           }
@@ -1227,7 +1522,7 @@ namespace CasADi{
       } else {
         for(int i=0; i<it->res.size(); ++i){
           if(it->res.at(i)>=0){
-            res.at(i) = "w.a" + CodeGenerator::numToString(it->res.at(i));
+            res.at(i) = "a" + CodeGenerator::numToString(it->res.at(i));
           } else {
             res.at(i) = "0";
           }
@@ -1240,7 +1535,11 @@ namespace CasADi{
       } else if(it->op==OP_INPUT){
         gen.copyVector(stream,arg.front(),input(it->arg.front()).size(),res.front(),"i",false);
       } else {
+        size_t nd = dedicatedSizeCode(*it);
+        if(nd>0) stream << "  rrr=w+" << ip << ";" << endl;
         it->data->generateOperation(stream,arg,res,gen);
+        if(nd>0) stream << "  rrr=w+" << nw << ";" << endl;
+        ip += nd;
       }
     }
   }
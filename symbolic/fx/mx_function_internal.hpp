@@ -58,6 +58,18 @@ namespace CasADi{
     /** \brief  Evaluate the algorithm */
     virtual void evaluate(int nfdir, int nadir);
 
+    /** \brief  Evaluate numerically with raw pointers, using internally owned work arrays */
+    virtual void evaluateRaw(const double* const* arg, double* const* res);
+
+    /** \brief  Evaluate numerically with raw pointers and caller-owned work arrays */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Get the length of the arrays needed by evaluateRaw */
+    virtual void workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const;
+
+    /** \brief  Reentrant if all operations are */
+    virtual bool isReentrant() const{ return reentrant_;}
+
     /** \brief  Print description */
     virtual void print(std::ostream &stream) const;
 
@@ -73,6 +85,16 @@ namespace CasADi{
     /** \brief Generate code for the body of the C function */
     virtual void generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const;
 
+    /** \brief Get the length of the integer and real work vectors needed by the generated code */
+    virtual void workSizeCode(size_t& ni, size_t& nr) const;
+
+    /** \brief Get the length of the persistent part of the real work vector of the generated code */
+    virtual size_t persistentSizeCode() const;
+
+    /** \brief Length of the dedicated part of the real work vector used by an operation in the generated code, 
+     * zero unless it calls a function with persistent data */
+    size_t dedicatedSizeCode(const MXAlgEl& el) const;
+
     /** \brief Extract the residual function G and the modified function Z out of an expression (see Albersmeyer2010 paper) */
     void generateLiftingFunctions(MXFunction& vdef_fcn, MXFunction& vinit_fcn);
 
@@ -94,8 +116,40 @@ namespace CasADi{
     /** \brief  Temporary vectors needed for the evaluation (real) */
     std::vector<double> rtmp_;
 
-    /** \brief  "Tape" with spilled variables */
-    std::vector<std::pair<std::pair<int,int>,DMatrix> > tape_;
+    /** \brief  Offset of each work vector element in the real work array of evaluateRaw
+        With live variables, elements with disjoint lifetimes share memory regardless of their sparsity */
+    std::vector<int> work_offset_;
+
+    /** \brief  Length of the part of the real work array holding the work vector */
+    int sz_work_;
+
+    /** \brief  Memory in the work vector that is overwritten while still needed by the adjoint sweep:
+        algorithm index and offset in the real work array */
+    std::vector<std::pair<int,int> > spill_;
+
+    /** \brief  Offset of each spilled block in the tape, with the total length last */
+    std::vector<int> spill_offset_;
+
+    /** \brief  Lengths of the arrays needed by evaluateRaw */
+    int sz_arg_, sz_res_, sz_iw_, sz_w_;
+
+    /** \brief  Can evaluateRaw be called concurrently? */
+    bool reentrant_;
+
+    /** \brief  Work arrays for evaluate and evaluateRaw without caller-owned work, allocated in updateNumSens
+        The real work array holds the work vector and the temporaries of the operations (as in evaluateRaw), followed by
+        nfdir_ forward and nadir_ adjoint copies of the work vector and, if nadir_>0, the tape */
+    std::vector<const double*> arg_raw_;
+    std::vector<double*> res_raw_;
+    std::vector<int> iw_raw_;
+    std::vector<double> w_raw_;
+
+    /** \brief  Pointers to the directional derivatives of the operations, allocated in updateNumSens */
+    std::vector<const double*> fseed_raw_;
+    std::vector<double*> fsens_raw_, aseed_raw_, asens_raw_;
+
+    /** \brief  "Tape" with spilled variables for symbolic evaluation: algorithm index and work vector index */
+    std::vector<std::pair<int,int> > tape_;
     
     /// Free variables
     std::vector<MX> free_vars_;
@@ -113,16 +167,12 @@ namespace CasADi{
     /** \brief Expand the matrix valued graph into a scalar valued graph */
     SXFunction expand(const std::vector<SXMatrix>& inputv );
     
-    // Update pointers to a particular element
-    void updatePointers(const AlgEl& el, int nfdir, int nadir);
+    // Update pointers to a particular element, for sparsity propagation
+    void updatePointers(const AlgEl& el);
     
-    // Vectors to hold pointers during evaluation
+    // Vectors to hold pointers during sparsity propagation
     DMatrixPtrV mx_input_;
     DMatrixPtrV mx_output_;
-    DMatrixPtrVV mx_fwdSeed_;
-    DMatrixPtrVV mx_fwdSens_;
-    DMatrixPtrVV mx_adjSeed_;
-    DMatrixPtrVV mx_adjSens_;
 
     /// Get a vector of symbolic variables with the same dimensions as the inputs
     virtual std::vector<MX> symbolicInput() const{ return inputv_;}
@@ -142,6 +192,9 @@ namespace CasADi{
     /// Print tape
     void printTape(std::ostream &stream=std::cout);
     
+    /// Place the work vector elements in the real work array
+    void allocWork(bool live_variables);
+
     /// Allocate tape
     void allocTape();
     
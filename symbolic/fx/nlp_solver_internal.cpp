@@ -44,6 +44,7 @@ namespace CasADi{
     addOption("grad_lag",           OT_FX,       GenericType(),  "Function for calculating the gradient of the Lagrangian (autogenerated by default)"); 
     addOption("jac_g",              OT_FX,       GenericType(),  "Function for calculating the Jacobian of the constraints (autogenerated by default)"); 
     addOption("grad_f",             OT_FX,       GenericType(),  "Function for calculating the gradient of the objective (autogenerated by default)"); 
+    addOption("fused_oracle",       OT_BOOLEAN,  false,          "Calculate the objective, the constraints and, when requested, the objective gradient and the constraint Jacobian from a single function of [g;f], reusing the results as long as x does not change. Ignored if \"grad_f\" or \"jac_g\" is provided.");
     addOption("iteration_callback", OT_FX,       GenericType(),  "A function that will be called at each iteration. Input scheme is the same as NLPSolver's output scheme. Output is scalar.");
     addOption("iteration_callback_step", OT_INTEGER,         1,  "Only call the callback function every few iterations.");
     addOption("iteration_callback_ignore_errors", OT_BOOLEAN, false, "If set to true, errors thrown by iteration_callback will be ignored.");
@@ -150,6 +151,16 @@ namespace CasADi{
     }
   
     callback_step_ = getOption("iteration_callback_step");
+
+    // Fused evaluation of the objective, the constraints and their derivatives
+    fused_ = getOption("fused_oracle");
+    if(fused_ && (hasSetOption("grad_f") || hasSetOption("jac_g"))){
+      casadi_warning("Option \"fused_oracle\" ignored since \"grad_f\" or \"jac_g\" has been provided.");
+      fused_ = false;
+    }
+    fused_level_ = FUSED_NONE;
+    fused_num_eval_ = fused_num_reuse_ = 0;
+    if(fused_) fusedOracle();
   }
 
   void NLPSolverInternal::checkInitialBounds() { 
@@ -276,6 +287,118 @@ namespace CasADi{
     return hessLag;
   }
 
+  FX& NLPSolverInternal::fusedOracle(){
+    if(fusedOracle_.isNull()){
+      fusedOracle_ = getFusedOracle();
+    }
+    return fusedOracle_;
+  }
+
+  FX NLPSolverInternal::getFusedOracle(){
+    log("Generating fused NLP oracle");
+    
+    // Function returning the nonzeros of the constraints followed by the objective, with the Jacobian of the same
+    FX fg;
+    SXFunction nlp_sx = shared_cast<SXFunction>(nlp_);
+    if(!nlp_sx.isNull()){
+      // Stay with scalar operations, the Jacobian then shares all subexpressions with the nondifferentiated outputs
+      SXMatrix g = nlp_sx.outputExpr(NL_G);
+      if(!(g.dense() && g.size2()==1)) g = g[Slice()];
+      fg = SXFunction(nlp_sx.inputExpr(),vertcat(g,nlp_sx.outputExpr(NL_F)));
+    } else {
+      vector<MX> arg = nlp_.symbolicInput();
+      vector<MX> res = nlp_.call(arg);
+      MX g = res[NL_G];
+      if(!(g.dense() && g.size2()==1)) g = g[Slice()];
+      fg = MXFunction(arg,vertcat(g,res[NL_F]));
+    }
+    fg.init();
+    fusedFG_ = fg;
+    FX fusedOracle = fg.jacobian(NL_X,0);
+    fusedOracle.setOption("name","fused_oracle");
+    fusedOracle.init();
+    log("Fused NLP oracle generated");
+
+    // The constraint Jacobian are the leading rows
+    const CRSSparsity& sp = fusedOracle.output().sparsity();
+    casadi_assert(sp.size1()==ng_+1 && sp.size2()==nx_);
+    vector<int> rowind(sp.rowind().begin(),sp.rowind().begin()+ng_+1);
+    vector<int> col(sp.col().begin(),sp.col().begin()+rowind.back());
+    fusedJacGSparsity_ = CRSSparsity(ng_,nx_,col,rowind);
+    fused_x_.resize(nx_);
+    fused_fg_.resize(ng_+1);
+    fused_grad_f_.resize(nx_);
+    return fusedOracle;
+  }
+
+  const CRSSparsity& NLPSolverInternal::fusedJacGSparsity(){
+    fusedOracle();
+    return fusedJacGSparsity_;
+  }
+
+  void NLPSolverInternal::evalFusedOracle(const double* x, FusedLevel level){
+    // Reuse the last evaluation if it was at the same x and went far enough
+    if(fused_level_!=FUSED_NONE && std::equal(x,x+nx_,fused_x_.begin())){
+      if(fused_level_>=level){
+        fused_num_reuse_++;
+        return;
+      }
+    } else {
+      fused_level_ = FUSED_NONE;
+    }
+
+    FX& fusedOracle = this->fusedOracle();
+    if(level==FUSED_JAC_G){
+      // The Jacobian of [g;f], the gradient of the objective is its last row
+      fusedOracle.setInput(x,NL_X);
+      fusedOracle.setInput(input(NLP_SOLVER_P),NL_P);
+      fusedOracle.evaluate();
+      fusedOracle.output(1).get(fused_fg_);
+      const DMatrix& J = fusedOracle.output();
+      std::fill(fused_grad_f_.begin(),fused_grad_f_.end(),0);
+      for(int el=J.rowind(ng_); el<J.rowind(ng_+1); ++el){
+        fused_grad_f_[J.col(el)] = J.at(el);
+      }
+    } else {
+      // [g;f], with the gradient of the objective in one adjoint sweep if requested
+      fusedFG_.setInput(x,NL_X);
+      fusedFG_.setInput(input(NLP_SOLVER_P),NL_P);
+      if(level==FUSED_GRAD_F){
+        fusedFG_.adjSeed().setZero();
+        fusedFG_.adjSeed().at(ng_) = 1;
+        fusedFG_.evaluate(0,1);
+        fusedFG_.adjSens(NL_X).get(fused_grad_f_,DENSE);
+      } else {
+        fusedFG_.evaluate();
+      }
+      fusedFG_.output().get(fused_fg_);
+    }
+    std::copy(x,x+nx_,fused_x_.begin());
+    fused_level_ = level;
+    fused_num_eval_++;
+  }
+
+  double NLPSolverInternal::fusedF(){
+    casadi_assert(fused_level_>=FUSED_FG);
+    return fused_fg_[ng_];
+  }
+
+  void NLPSolverInternal::getFusedG(double* g){
+    casadi_assert(fused_level_>=FUSED_FG);
+    std::copy(fused_fg_.begin(),fused_fg_.begin()+ng_,g);
+  }
+
+  void NLPSolverInternal::getFusedGradF(double* grad_f){
+    casadi_assert(fused_level_>=FUSED_GRAD_F);
+    std::copy(fused_grad_f_.begin(),fused_grad_f_.end(),grad_f);
+  }
+
+  void NLPSolverInternal::getFusedJacG(double* jac_g){
+    casadi_assert(fused_level_>=FUSED_JAC_G);
+    const vector<double>& J = fusedOracle().output().data();
+    std::copy(J.begin(),J.begin()+fusedJacGSparsity_.size(),jac_g);
+  }
+
   CRSSparsity& NLPSolverInternal::spHessLag(){
     if(spHessLag_.isNull()){
       spHessLag_ = getSpHessLag();
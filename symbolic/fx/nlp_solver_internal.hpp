@@ -85,6 +85,41 @@ namespace CasADi{
     /// Get the sparsity pattern of the Hessian of the Lagrangian
     CRSSparsity& spHessLag();
 
+    /** \brief Get or generate a function calculating the objective, the constraints, the objective gradient and the constraint Jacobian together
+    * Inputs are those of the NLP, outputs the Jacobian of [g;f] with respect to x, with the gradient of the objective in the last row, and [g;f] itself.
+    */
+    virtual FX getFusedOracle();
+
+    /// Access the fused oracle
+    FX& fusedOracle();
+
+    /// Sparsity pattern of the constraint Jacobian, as calculated by the fused oracle
+    const CRSSparsity& fusedJacGSparsity();
+
+    /// Results of the fused oracle, each level includes the previous ones
+    enum FusedLevel{FUSED_NONE, FUSED_FG, FUSED_GRAD_F, FUSED_JAC_G};
+
+    /** \brief Evaluate the fused oracle at x up to a level, unless an evaluation at the same x provides it
+    * The objective and the constraints are calculated without derivatives, the objective gradient with one
+    * adjoint sweep and the constraint Jacobian with the full Jacobian of [g;f].
+    */
+    void evalFusedOracle(const double* x, FusedLevel level);
+
+    /// Discard the results of the fused oracle, to be called when the parameters may have changed
+    void resetFusedOracle(){ fused_level_ = FUSED_NONE;}
+
+    /// Objective value from the last evaluation of the fused oracle
+    double fusedF();
+
+    /// Constraint values from the last evaluation of the fused oracle
+    void getFusedG(double* g);
+
+    /// Objective gradient (dense) from the last evaluation of the fused oracle
+    void getFusedGradF(double* grad_f);
+
+    /// Constraint Jacobian nonzeros (with sparsity fusedJacGSparsity()) from the last evaluation of the fused oracle
+    void getFusedJacG(double* jac_g);
+
     /// Number of variables
     int nx_;
   
@@ -117,6 +152,22 @@ namespace CasADi{
 
     // Sparsity pattern of the Hessian of the Lagrangian
     CRSSparsity spHessLag_;
+
+    /// Evaluate f, g, grad_f and jac_g with the fused oracle
+    bool fused_;
+
+    // Fused oracle and the function [g;f] it differentiates
+    FX fusedOracle_, fusedFG_;
+
+    // Sparsity pattern of the constraint Jacobian in the fused oracle
+    CRSSparsity fusedJacGSparsity_;
+
+    // Point, results available and values [g;f] and grad_f of the last evaluation of the fused oracle
+    std::vector<double> fused_x_, fused_fg_, fused_grad_f_;
+    FusedLevel fused_level_;
+
+    // Number of evaluations of the fused oracle and of requests served from the last evaluation
+    int fused_num_eval_, fused_num_reuse_;
   };
 
 } // namespace CasADi
@@ -22,20 +22,92 @@
 
 #include "parallelizer_internal.hpp"
 #include "mx_function.hpp"
+#include "../thread_pool.hpp"
 #include <algorithm>
+#include <cstdio>
 #ifdef WITH_OPENMP
 #include <omp.h>
 #endif //WITH_OPENMP
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif // _WIN32
 
 using namespace std;
 
 namespace CasADi{
   
-  ParallelizerInternal::ParallelizerInternal(const std::vector<FX>& funcs) : funcs_(funcs){
-    addOption("parallelization", OT_STRING, "serial","","serial|openmp|mpi"); 
+  namespace{
+    /// Evaluate the tasks of a parallelizer in a thread pool
+    class EvaluateJob : public ThreadPool::Job{
+    public:
+      EvaluateJob(ParallelizerInternal* p, int nfdir, int nadir) : p_(p), nfdir_(nfdir), nadir_(nadir){}
+      virtual void execute(int task){ p_->evaluateTask(task,nfdir_,nadir_);}
+    private:
+      ParallelizerInternal* p_;
+      int nfdir_, nadir_;
+    };
+
+    /// Propagate sparsity through the tasks of a parallelizer in a thread pool
+    class SpEvaluateJob : public ThreadPool::Job{
+    public:
+      SpEvaluateJob(ParallelizerInternal* p, bool use_fwd) : p_(p), use_fwd_(use_fwd){}
+      virtual void execute(int task){ p_->spEvaluateTask(use_fwd_,task);}
+    private:
+      ParallelizerInternal* p_;
+      bool use_fwd_;
+    };
+
+    /// Commands sent to the worker processes
+    enum ProcessCmd{CMD_EVALUATE, CMD_SP_EVALUATE, CMD_QUIT};
+
+    /// Message sent to the worker processes
+    struct ProcessMsg{
+      int cmd, nfdir, nadir, use_fwd;
+    };
+
+#ifndef _WIN32
+    /// Write a buffer to a socket, false on failure
+    bool writeAll(int fd, const void* buf, size_t n){
+      const char* p = static_cast<const char*>(buf);
+      while(n>0){
+#ifdef MSG_NOSIGNAL
+        ssize_t k = send(fd,p,n,MSG_NOSIGNAL);
+#else // MSG_NOSIGNAL
+        ssize_t k = send(fd,p,n,0);
+#endif // MSG_NOSIGNAL
+        if(k<=0) return false;
+        p += k;
+        n -= k;
+      }
+      return true;
+    }
+
+    /// Read a buffer from a socket, false on failure
+    bool readAll(int fd, void* buf, size_t n){
+      char* p = static_cast<char*>(buf);
+      while(n>0){
+        ssize_t k = recv(fd,p,n,0);
+        if(k<=0) return false;
+        p += k;
+        n -= k;
+      }
+      return true;
+    }
+#endif // _WIN32
+  } // namespace
+
+  ParallelizerInternal::ParallelizerInternal(const std::vector<FX>& funcs) : funcs_(funcs), thread_pool_(0), shm_(0), shm_size_(0){
+    addOption("parallelization", OT_STRING, "serial","","serial|openmp|threads: pool of persistent threads with work stealing|processes: worker processes forked for each evaluation, communicating via shared memory|mpi: deprecated, same as processes"); 
+    addOption("num_threads", OT_INTEGER, 0, "Number of threads in the \"threads\" mode, 0 means one per processor");
+    addOption("num_processes", OT_INTEGER, 0, "Number of worker processes in the \"processes\" mode, 0 means one per processor");
   }
 
   ParallelizerInternal::~ParallelizerInternal(){
+    stopProcesses();
+    delete thread_pool_;
   }
 
   void ParallelizerInternal::init(){
@@ -44,8 +116,13 @@ namespace CasADi{
       mode_ = SERIAL;
     } else if(getOption("parallelization")=="openmp") {
       mode_ = OPENMP;
+    } else if(getOption("parallelization")=="processes") {
+      mode_ = PROCESSES;
     } else if(getOption("parallelization")=="mpi") {
-      mode_ = MPI;
+      casadi_warning("Parallelization mode \"mpi\" is deprecated, use \"processes\" instead.");
+      mode_ = PROCESSES;
+    } else if(getOption("parallelization")=="threads") {
+      mode_ = THREADS;
     } else {
       casadi_error("Parallelization mode " << getOption("parallelization") << " unknown.");
     }
@@ -57,6 +134,26 @@ namespace CasADi{
       mode_ = SERIAL;
     }
 #endif // WITH_OPENMP
+
+    // Shared memory is reallocated on the next evaluation
+    stopProcesses();
+#ifdef _WIN32
+    if(mode_ == PROCESSES){
+      casadi_warning("Parallelization with processes is not available on this platform, switching to serial mode.");
+      mode_ = SERIAL;
+    }
+#endif // _WIN32
+
+    // Create a new thread pool if the number of threads has changed
+    if(mode_ == THREADS){
+      int num_threads = getOption("num_threads");
+      if(num_threads<=0) num_threads = ThreadPool::numProcessors();
+      if(thread_pool_!=0 && thread_pool_->size()!=num_threads){
+        delete thread_pool_;
+        thread_pool_ = 0;
+      }
+      if(thread_pool_==0) thread_pool_ = new ThreadPool(num_threads);
+    }
     
     // Check if a node is a copy of another
     copy_of_.resize(funcs_.size(),-1);
@@ -76,8 +173,8 @@ namespace CasADi{
       // Initialize
       it->init(false);
     
-      // Make sure that the functions are unique if we are using OpenMP
-      if(mode_==OPENMP && it!=funcs_.begin())
+      // Make sure that the functions are unique if we are using OpenMP or threads
+      if((mode_==OPENMP || mode_==THREADS) && it!=funcs_.begin())
         it->makeUnique();
     
     }
@@ -93,6 +190,9 @@ namespace CasADi{
     }
     setNumInputs(inind_.back());
     setNumOutputs(outind_.back());
+
+    // No cost estimates yet
+    task_cost_.assign(funcs_.size(),0);
   
     // Copy inputs and output dimensions and structure
     for(int i=0; i<funcs_.size(); ++i){
@@ -161,8 +261,43 @@ namespace CasADi{
 #ifndef WITH_OPENMP
       casadi_error("ParallelizerInternal::evaluate: OPENMP support was not available during CasADi compilation");
 #endif //WITH_OPENMP
-    } else if(mode_ == MPI){
-      casadi_error("ParallelizerInternal::evaluate: MPI not implemented");
+    } else if(mode_ == PROCESSES){
+      // Start the worker processes, copies of the current state of this process
+      startProcesses(nfdir,nadir);
+
+      // Send the arguments
+      for(int task=0; task<funcs_.size(); ++task){
+        transferTask(task,nfdir,nadir,true,false,true);
+      }
+
+      // Evaluate
+      processCommand(CMD_EVALUATE,nfdir,nadir,false);
+
+      // Get the results
+      for(int task=0; task<funcs_.size(); ++task){
+        transferTask(task,nfdir,nadir,false,true,false);
+      }
+
+      // The workers would not see later changes to the functions
+      stopWorkers();
+    } else if(mode_ == THREADS){
+      // Evaluate, the tasks are distributed according to the cost estimates
+      EvaluateJob job(this,nfdir,nadir);
+      thread_pool_->run(job,funcs_.size(),task_cost_);
+
+      // Update the cost estimates
+      const vector<double>& task_time = thread_pool_->taskTime();
+      for(int task=0; task<funcs_.size(); ++task){
+        task_cost_[task] = task_cost_[task]==0 ? task_time[task] : 0.5*(task_cost_[task] + task_time[task]);
+      }
+      
+      if (gather_stats_) {
+        stats_["num_threads"] = thread_pool_->size();
+        stats_["task_allocation"] = thread_pool_->taskThread();
+        stats_["task_cputime"] = task_time;
+        stats_["task_cost"] = task_cost_;
+        stats_["num_stolen"] = thread_pool_->numStolen();
+      }
     }
   }
 
@@ -266,15 +401,31 @@ namespace CasADi{
   }
 
   void ParallelizerInternal::spInit(bool use_fwd){
+    // In the "processes" mode, the workers inherit the initialized functions
     for(vector<FX>::iterator it=funcs_.begin(); it!=funcs_.end(); ++it){
       it->spInit(use_fwd);
     }
   }
 
   void ParallelizerInternal::spEvaluate(bool use_fwd){
-    // This function can be parallelized. Move logic in "evaluate" to a template function.
-    for(int task=0; task<funcs_.size(); ++task){
-      spEvaluateTask(use_fwd,task);
+    if(mode_ == THREADS){
+      SpEvaluateJob job(this,use_fwd);
+      thread_pool_->run(job,funcs_.size(),task_cost_);
+    } else if(mode_ == PROCESSES){
+      // The dependency patterns are stored in the nondifferentiated inputs and outputs
+      startProcesses(0,0);
+      for(int task=0; task<funcs_.size(); ++task){
+        transferTask(task,0,0,true,true,true);
+      }
+      processCommand(CMD_SP_EVALUATE,0,0,use_fwd);
+      for(int task=0; task<funcs_.size(); ++task){
+        transferTask(task,0,0,true,true,false);
+      }
+      stopWorkers();
+    } else {
+      for(int task=0; task<funcs_.size(); ++task){
+        spEvaluateTask(use_fwd,task);
+      }
     }
   }
 
@@ -380,6 +531,9 @@ namespace CasADi{
     // Call the base class if needed
     if(recursive) FXInternal::updateNumSens(recursive);
 
+    // The shared memory is reallocated with the new number of directions
+    stopProcesses();
+
     // Request more derivative from the parallelized functions
     for(vector<FX>::iterator it=funcs_.begin(); it!=funcs_.end(); ++it){
       it->requestNumSens(nfdir_,nadir_);
@@ -387,5 +541,199 @@ namespace CasADi{
   }
 
 
+  void ParallelizerInternal::transferTask(int task, int nfdir, int nadir, bool args, bool res, bool to_shm){
+    double* p = shm_ + shm_offset_[task];
+    
+    // Copy a matrix if requested, always advance in the shared memory
+    #define TRANSFER(M, copy_it) { \
+      vector<double>& v = (M).data(); \
+      if(copy_it && !v.empty()){ \
+        if(to_shm){ \
+          copy(v.begin(),v.end(),p); \
+        } else { \
+          copy(p,p+v.size(),v.begin()); \
+        } \
+      } \
+      p += v.size(); \
+    }
+
+    // Nondifferentiated inputs and outputs
+    for(int j=inind_[task]; j<inind_[task+1]; ++j) TRANSFER(input(j), args)
+    for(int j=outind_[task]; j<outind_[task+1]; ++j) TRANSFER(output(j), res)
+
+    // Forward seeds and sensitivities
+    for(int dir=0; dir<shm_nfdir_; ++dir){
+      for(int j=inind_[task]; j<inind_[task+1]; ++j) TRANSFER(fwdSeed(j,dir), args && dir<nfdir)
+      for(int j=outind_[task]; j<outind_[task+1]; ++j) TRANSFER(fwdSens(j,dir), res && dir<nfdir)
+    }
+
+    // Adjoint seeds and sensitivities
+    for(int dir=0; dir<shm_nadir_; ++dir){
+      for(int j=outind_[task]; j<outind_[task+1]; ++j) TRANSFER(adjSeed(j,dir), args && dir<nadir)
+      for(int j=inind_[task]; j<inind_[task+1]; ++j) TRANSFER(adjSens(j,dir), res && dir<nadir)
+    }
+    #undef TRANSFER
+  }
+
+  void ParallelizerInternal::startProcesses(int nfdir, int nadir){
+#ifndef _WIN32
+    // Workers left by an evaluation that failed
+    stopWorkers();
+
+    // Reallocate the shared memory if there is not enough room for the directions
+    if(shm_!=0 && (nfdir>shm_nfdir_ || nadir>shm_nadir_)){
+      stopProcesses();
+    }
+
+    // Number of processes
+    int nproc = getOption("num_processes");
+    if(nproc<=0) nproc = ThreadPool::numProcessors();
+    nproc = std::min(nproc,int(funcs_.size()));
+
+    if(shm_==0){
+      // Layout of the shared memory
+      shm_nfdir_ = std::max(nfdir,nfdir_);
+      shm_nadir_ = std::max(nadir,nadir_);
+      shm_offset_.resize(funcs_.size()+1);
+      shm_offset_[0] = 0;
+      for(int task=0; task<funcs_.size(); ++task){
+        size_t nin=0, nout=0;
+        for(int j=inind_[task]; j<inind_[task+1]; ++j) nin += input(j).size();
+        for(int j=outind_[task]; j<outind_[task+1]; ++j) nout += output(j).size();
+        shm_offset_[task+1] = shm_offset_[task] + (nin+nout)*(1+shm_nfdir_+shm_nadir_);
+      }
+      
+      // Allocate shared memory
+      shm_size_ = std::max(shm_offset_.back(),size_t(1))*sizeof(double);
+      void* shm = mmap(0,shm_size_,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANON,-1,0);
+      casadi_assert_message(shm!=MAP_FAILED, "ParallelizerInternal: failed to allocate shared memory");
+      shm_ = static_cast<double*>(shm);
+    }
+
+    // Make sure that buffered output is not written twice
+    cout.flush();
+    cerr.flush();
+    fflush(0);
+    
+    // Start the workers
+    for(int worker=0; worker<nproc; ++worker){
+      int sv[2];
+      casadi_assert_message(socketpair(AF_UNIX,SOCK_STREAM,0,sv)==0, "ParallelizerInternal: failed to create socket");
+      pid_t pid = fork();
+      if(pid==0){
+        // Worker process, close the sockets of the parent
+        close(sv[0]);
+        for(int k=0; k<worker_socket_.size(); ++k) close(worker_socket_[k]);
+        processMain(worker,nproc,sv[1]);
+      }
+      close(sv[1]);
+      if(pid<0){
+        close(sv[0]);
+        stopProcesses();
+        casadi_error("ParallelizerInternal: failed to create worker process");
+      }
+      worker_pid_.push_back(pid);
+      worker_socket_.push_back(sv[0]);
+    }
+    if(verbose()){
+      cout << "ParallelizerInternal: started " << nproc << " worker processes" << endl;
+    }
+#else // _WIN32
+    casadi_error("ParallelizerInternal: processes are not supported on this platform");
+#endif // _WIN32
+  }
+
+  void ParallelizerInternal::stopWorkers(){
+#ifndef _WIN32
+    // Ask the workers to quit and wait for them
+    for(int worker=0; worker<worker_pid_.size(); ++worker){
+      ProcessMsg msg = {CMD_QUIT, 0, 0, 0};
+      writeAll(worker_socket_[worker],&msg,sizeof(msg));
+      close(worker_socket_[worker]);
+      waitpid(worker_pid_[worker],0,0);
+    }
+    worker_pid_.clear();
+    worker_socket_.clear();
+#endif // _WIN32
+  }
+
+  void ParallelizerInternal::stopProcesses(){
+#ifndef _WIN32
+    stopWorkers();
+
+    // Free the shared memory
+    if(shm_!=0){
+      munmap(shm_,shm_size_);
+      shm_ = 0;
+    }
+#endif // _WIN32
+  }
+
+  void ParallelizerInternal::processMain(int worker, int nproc, int socket){
+#ifndef _WIN32
+    ProcessMsg msg;
+    while(readAll(socket,&msg,sizeof(msg)) && msg.cmd!=CMD_QUIT){
+      // Tasks handled by this worker
+      string error;
+      for(int task=worker; task<funcs_.size(); task+=nproc){
+        try{
+          switch(msg.cmd){
+          case CMD_EVALUATE:
+            transferTask(task,msg.nfdir,msg.nadir,true,false,false);
+            evaluateTask(task,msg.nfdir,msg.nadir);
+            transferTask(task,msg.nfdir,msg.nadir,false,true,true);
+            break;
+          case CMD_SP_EVALUATE:
+            transferTask(task,0,0,true,true,false);
+            spEvaluateTask(msg.use_fwd!=0,task);
+            transferTask(task,0,0,true,true,true);
+            break;
+          }
+        } catch(exception& e){
+          if(error.empty()) error = e.what();
+        } catch(...){
+          if(error.empty()) error = "unknown exception";
+        }
+      }
+
+      // Report back, the length of the error message followed by the message
+      int len = error.size();
+      if(!writeAll(socket,&len,sizeof(len)) || !writeAll(socket,error.c_str(),len)) break;
+    }
+    cout.flush();
+    _exit(0);
+#endif // _WIN32
+  }
+
+  void ParallelizerInternal::processCommand(int cmd, int nfdir, int nadir, bool use_fwd){
+#ifndef _WIN32
+    // Send the command to all workers
+    ProcessMsg msg = {cmd, nfdir, nadir, use_fwd ? 1 : 0};
+    vector<bool> ok(worker_pid_.size());
+    for(int worker=0; worker<worker_pid_.size(); ++worker){
+      ok[worker] = writeAll(worker_socket_[worker],&msg,sizeof(msg));
+    }
+
+    // Collect the replies
+    string error;
+    for(int worker=0; worker<worker_pid_.size(); ++worker){
+      int len;
+      if(ok[worker] && readAll(worker_socket_[worker],&len,sizeof(len))){
+        if(len>0){
+          vector<char> buf(len);
+          readAll(worker_socket_[worker],&buf.front(),len);
+          if(error.empty()) error = string(buf.begin(),buf.end());
+        }
+      } else if(error.empty()){
+        error = "worker process terminated unexpectedly";
+      }
+    }
+    if(!error.empty()){
+      stopWorkers();
+      casadi_error("ParallelizerInternal: evaluation in worker process failed: " << error);
+    }
+#endif // _WIN32
+  }
+
 } // namespace CasADi
 
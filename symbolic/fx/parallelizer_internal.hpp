@@ -28,6 +28,9 @@
 #include "fx_internal.hpp"
 
 namespace CasADi{
+
+  // Forward declaration
+  class ThreadPool;
  
   /** \brief  Internal node class for Parallelizer
   \author Joel Andersson 
@@ -44,6 +47,10 @@ class ParallelizerInternal : public FXInternal{
     /// clone
     virtual ParallelizerInternal* clone() const{ 
       ParallelizerInternal* ret = new ParallelizerInternal(*this);
+      ret->thread_pool_ = 0;
+      ret->worker_pid_.clear();
+      ret->worker_socket_.clear();
+      ret->shm_ = 0;
       for(std::vector<FX>::iterator it=ret->funcs_.begin(); it!=ret->funcs_.end(); ++it){
         it->makeUnique();
       }
@@ -68,6 +75,28 @@ class ParallelizerInternal : public FXInternal{
     /// Propagate the sparsity pattern through a set of directional derivatives forward or backward, one task only
     void spEvaluateTask(bool use_fwd, int task);
 
+    /** \brief Start the worker processes, allocating shared memory with room for nfdir and nadir directions if needed
+    * The workers are forked for each evaluation, so that they see the current state of the functions
+    */
+    void startProcesses(int nfdir, int nadir);
+
+    /// Stop the worker processes, if any
+    void stopWorkers();
+
+    /// Stop the worker processes, if any, and free the shared memory
+    void stopProcesses();
+
+    /// Main loop of a worker process, does not return
+    void processMain(int worker, int nproc, int socket);
+
+    /// Send a command to all worker processes and wait for them to finish
+    void processCommand(int cmd, int nfdir, int nadir, bool use_fwd);
+
+    /** \brief Copy the data of a task between this object and the shared memory
+    * Arguments are the inputs and seeds, results are the outputs and sensitivities
+    */
+    void transferTask(int task, int nfdir, int nadir, bool args, bool res, bool to_shm);
+
     /// Is the class able to propate seeds through the algorithm?
     virtual bool spCanEvaluate(bool fwd){ return true;}
     
@@ -102,10 +131,29 @@ class ParallelizerInternal : public FXInternal{
     std::vector<int> copy_of_;
     
     /// Parallelization modes
-    enum Mode{SERIAL,OPENMP,MPI};
+    enum Mode{SERIAL,OPENMP,PROCESSES,THREADS};
     
     /// Mode
     Mode mode_;
+
+    /// Thread pool, created on first use
+    ThreadPool* thread_pool_;
+
+    /// Estimated cost of each task, updated from the measured evaluation times
+    std::vector<double> task_cost_;
+
+    /// Worker processes and the sockets connecting to them (mode "processes")
+    std::vector<int> worker_pid_, worker_socket_;
+
+    /// Shared memory holding the arguments and results of all tasks
+    double* shm_;
+    size_t shm_size_;
+
+    /// Offset of each task in the shared memory
+    std::vector<size_t> shm_offset_;
+
+    /// Number of derivative directions the shared memory has room for
+    int shm_nfdir_, shm_nadir_;
 };
 
 
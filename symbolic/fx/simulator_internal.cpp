@@ -25,6 +25,9 @@
 #include "../stl_vector_tools.hpp"
 #include "sx_function.hpp"
 #include "../sx/sx_tools.hpp"
+#include "../mx/mx_tools.hpp"
+#include "mx_function.hpp"
+#include <fstream>
 
 INPUTSCHEME(IntegratorInput)
 
@@ -35,6 +38,11 @@ namespace CasADi{
 SimulatorInternal::SimulatorInternal(const Integrator& integrator, const FX& output_fcn, const vector<double>& grid) : integrator_(integrator), output_fcn_(output_fcn), grid_(grid){
   setOption("name","unnamed simulator");
   addOption("monitor",      OT_STRINGVECTOR, GenericType(),  "", "initial|step", true);
+  addOption("output_stride",      OT_INTEGER, 1,  "Only evaluate and store the outputs at every n-th grid point, starting with the first");
+  addOption("output_file",        OT_STRING,  "", "Stream the outputs to a binary file instead of storing them, the outputs then only hold the last stored grid point. "
+                                                  "For each stored grid point, the file contains the time followed by all outputs and then all forward sensitivities (dense, double precision). "
+                                                  "The file is truncated at the start of each evaluation");
+  addOption("output_buffer_size", OT_INTEGER, 1000, "Number of stored grid points buffered before they are written to the output file");
   
   inputScheme_ = SCHEME_IntegratorInput;
 }
@@ -84,10 +92,20 @@ void SimulatorInternal::init(){
     input(i) = integrator_.input(i);
   }
 
+  // Read options
+  stride_ = getOption("output_stride");
+  casadi_assert_message(stride_>=1, "SimulatorInternal::init: output_stride must be positive");
+  output_file_ = getOption("output_file").toString();
+  buffer_size_ = getOption("output_buffer_size");
+  casadi_assert_message(buffer_size_>=1, "SimulatorInternal::init: output_buffer_size must be positive");
+  
+  // Number of grid points at which the outputs are stored
+  int nstore = output_file_.empty() ? (grid_.size()+stride_-1)/stride_ : 1;
+  
   // Allocate outputs
   output_.resize(output_fcn_->output_.size());
   for(int i=0; i<output_.size(); ++i) {
-    output(i) = Matrix<double>(grid_.size(),output_fcn_.output(i).numel(),0);
+    output(i) = Matrix<double>(nstore,output_fcn_.output(i).numel(),0);
     if (!output_fcn_.output(i).empty()) {
       casadi_assert_message(output_fcn_.output(i).size2()==1,"SimulatorInternal::init: Output function output #" << i << " has shape " << output_fcn_.output(i).dimString() << ", while a column-matrix shape is expected.");
     }
@@ -102,15 +120,19 @@ void SimulatorInternal::init(){
   // Call base class method
   FXInternal::init();
   
-  states_.resize(grid_.size());
-  for (int k = 0; k < grid_.size(); ++k) {
+  // The states are not kept when streaming
+  states_.resize(output_file_.empty() ? grid_.size() : 0);
+  for (int k = 0; k < states_.size(); ++k) {
     states_[k]=Matrix<double>::zeros(integrator_.input(INTEGRATOR_X0).size1());
   }
+  
+  // The integrator for the adjoint sensitivities is created when first needed
+  interval_integrator_ = Integrator();
     
 }
 
 void SimulatorInternal::evaluate(int nfdir, int nadir){
-  casadi_assert_message(nadir==0, "Not implemented");
+  casadi_assert_message(nadir==0 || output_file_.empty(), "SimulatorInternal::evaluate: adjoint sensitivities not available when streaming the outputs to a file");
   
   // Pass the parameters and initial state
   integrator_.setInput(input(INTEGRATOR_X0),INTEGRATOR_X0);
@@ -131,6 +153,18 @@ void SimulatorInternal::evaluate(int nfdir, int nadir){
   // Reset the integrator_
   integrator_.reset(nfdir);
   
+  // Open the output file
+  bool streaming = !output_file_.empty();
+  std::ofstream file;
+  int row_len = 1;
+  if(streaming){
+    file.open(output_file_.c_str(), std::ios::binary | std::ios::trunc);
+    casadi_assert_message(file.good(), "SimulatorInternal::evaluate: could not open \"" << output_file_ << "\" for writing");
+    for(int i=0; i<output_.size(); ++i) row_len += (1+nfdir)*output(i).size2();
+    buffer_.clear();
+    buffer_.reserve(buffer_size_*row_len);
+  }
+  
   // Advance solution in time
   for(int k=0; k<grid_.size(); ++k){
 
@@ -147,6 +181,12 @@ void SimulatorInternal::evaluate(int nfdir, int nadir){
       std::cout << " y_final  = "  << integrator_.output(INTEGRATOR_XF) << std::endl;
     }
     
+    // Save the states for use in backwards sensitivities
+    if(!streaming) states_[k].set(integrator_.output(INTEGRATOR_XF));
+    
+    // Only evaluate the outputs at every stride_-th grid point
+    if(k % stride_ != 0) continue;
+    
     // Pass integrator output to the output function
     if(output_fcn_.input(DAE_T).size()!=0)
       output_fcn_.setInput(grid_[k],DAE_T);
@@ -155,9 +195,6 @@ void SimulatorInternal::evaluate(int nfdir, int nadir){
     if(output_fcn_.input(DAE_P).size()!=0)
       output_fcn_.setInput(input(INTEGRATOR_P),DAE_P);
       
-    // Save the states for use in backwards sensitivities
-    states_[k].set(integrator_.output(INTEGRATOR_XF));
-    
     for(int dir=0; dir<nfdir; ++dir){ 
       // Pass the forward seed to the output function 
       output_fcn_.setFwdSeed(0.0,DAE_T,dir); 
@@ -168,22 +205,150 @@ void SimulatorInternal::evaluate(int nfdir, int nadir){
     // Evaluate output function
     output_fcn_.evaluate(nfdir);
 
-    // Save the output of the function
+    // Save the output of the function in a row of the outputs, the last row only if streaming
+    int row = streaming ? 0 : k/stride_;
     for(int i=0; i<output_.size(); ++i){
-      const Matrix<double> &res = output_fcn_.output(i);
       Matrix<double> &ores = output(i);
-      for(int j=0; j<res.numel(); ++j){
-        ores(k,j) = res(j); // NOTE: inefficient implementation
+      int n = ores.size2();
+      output_fcn_.output(i).getArray(getPtr(ores.data())+row*n,n,DENSE);
+      
+      // Save the forward sensitivities
+      for(int dir=0; dir<nfdir; ++dir){
+        output_fcn_.fwdSens(i,dir).getArray(getPtr(fwdSens(i,dir).data())+row*n,n,DENSE);
       }
+    }
     
-      // Save the forward sensitivities
+    // Append the row to the buffer of the output file
+    if(streaming){
+      buffer_.push_back(grid_[k]);
+      for(int i=0; i<output_.size(); ++i){
+        buffer_.insert(buffer_.end(),output(i).begin(),output(i).end());
+      }
       for(int dir=0; dir<nfdir; ++dir){
-        const Matrix<double> &fres = output_fcn_.fwdSens(i,dir); 
-        Matrix<double> &ofres = fwdSens(i,dir); 
-        for(int j=0; j<fres.numel(); ++j){ 
-          ofres(k,j) = fres(j); // NOTE: inefficient implementation 
+        for(int i=0; i<output_.size(); ++i){
+          buffer_.insert(buffer_.end(),fwdSens(i,dir).begin(),fwdSens(i,dir).end());
         }
-      }     
+      }
+      
+      // Write to file when the buffer is full
+      if(buffer_.size()>=buffer_size_*row_len){
+        file.write(reinterpret_cast<const char*>(getPtr(buffer_)),buffer_.size()*sizeof(double));
+        buffer_.clear();
+      }
+    }
+  }
+  
+  // Write the remaining rows to the file
+  if(streaming){
+    if(!buffer_.empty()){
+      file.write(reinterpret_cast<const char*>(getPtr(buffer_)),buffer_.size()*sizeof(double));
+      buffer_.clear();
+    }
+    file.close();
+    casadi_assert_message(!file.fail(), "SimulatorInternal::evaluate: failed to write to \"" << output_file_ << "\"");
+  }
+  
+  // Adjoint sensitivities
+  if(nadir>0) evaluateAdj(nadir);
+}
+
+void SimulatorInternal::initAdj(){
+  // The DAE, with the time normalized to [0,1] on an interval [T0,TF] of the grid
+  FX f = integrator_.getDAE();
+  vector<MX> f_in = f.symbolicInput();
+  int np = f.input(DAE_P).size();
+  
+  // Structure of DAE_P : P T0 TF
+  MX tau("tau");
+  MX P("P",np+2,1);
+  MX T0 = P(np);
+  MX TF = P(np+1);
+  
+  vector<MX> dae_in = f_in;
+  dae_in[DAE_T] = tau;
+  dae_in[DAE_P] = P;
+  
+  vector<MX> f_call_in = f_in;
+  f_call_in[DAE_T] = f.input(DAE_T).empty() ? MX() : T0 + (TF-T0)*tau;
+  f_call_in[DAE_P] = P(IMatrix(f.input(DAE_P).sparsity(),range(np)));
+  vector<MX> dae_out = f.call(f_call_in);
+  dae_out[DAE_ODE] = (TF-T0)*dae_out[DAE_ODE];
+  if(!dae_out[DAE_QUAD].isNull() && !dae_out[DAE_QUAD].empty()){
+    dae_out[DAE_QUAD] = (TF-T0)*dae_out[DAE_QUAD];
+  }
+  MXFunction dae(dae_in,dae_out);
+  dae.init();
+  
+  // Create an integrator of the same class with the same options
+  interval_integrator_.assignNode(integrator_->create(dae,FX()));
+  interval_integrator_.setOption(integrator_.dictionary());
+  interval_integrator_.setOption("t0",0.0);
+  interval_integrator_.setOption("tf",1.0);
+  interval_integrator_.setOption("number_of_fwd_dir",0);
+  interval_integrator_.setOption("number_of_adj_dir",nadir_);
+  interval_integrator_.init();
+}
+
+void SimulatorInternal::evaluateAdj(int nadir){
+  if(interval_integrator_.isNull()) initAdj();
+  interval_integrator_.requestNumSens(0,nadir);
+  
+  // Adjoint sensitivities with respect to the state at the current grid point and the parameters
+  int np = integrator_.input(INTEGRATOR_P).size();
+  for(int dir=0; dir<nadir; ++dir){
+    adjSens(INTEGRATOR_X0,dir).setZero();
+    adjSens(INTEGRATOR_P,dir).setZero();
+  }
+  
+  // Parameters of the interval integrator, followed by the interval bounds
+  vector<double>& p_int = interval_integrator_.input(INTEGRATOR_P).data();
+  copy(input(INTEGRATOR_P).begin(),input(INTEGRATOR_P).end(),p_int.begin());
+  
+  // Backward sweep over the grid
+  for(int k=grid_.size()-1; k>=0; --k){
+    
+    // Contribution of the outputs at the grid point
+    if(k % stride_ == 0){
+      int row = k/stride_;
+      if(output_fcn_.input(DAE_T).size()!=0)
+        output_fcn_.setInput(grid_[k],DAE_T);
+      if(output_fcn_.input(DAE_X).size()!=0)
+        output_fcn_.setInput(states_[k],DAE_X);
+      if(output_fcn_.input(DAE_P).size()!=0)
+        output_fcn_.setInput(input(INTEGRATOR_P),DAE_P);
+      for(int dir=0; dir<nadir; ++dir){
+        for(int i=0; i<output_.size(); ++i){
+          int n = output(i).size2();
+          output_fcn_.adjSeed(i,dir).setArray(getPtr(adjSeed(i,dir).data())+row*n,n,DENSE);
+        }
+      }
+      output_fcn_.evaluate(0,nadir);
+      for(int dir=0; dir<nadir; ++dir){
+        if(output_fcn_.input(DAE_X).size()!=0)
+          adjSens(INTEGRATOR_X0,dir) += output_fcn_.adjSens(DAE_X,dir);
+        if(output_fcn_.input(DAE_P).size()!=0)
+          adjSens(INTEGRATOR_P,dir) += output_fcn_.adjSens(DAE_P,dir);
+      }
+    }
+    
+    // Propagate backwards over the interval [grid_[k-1],grid_[k]]
+    if(k>0 && grid_[k]>grid_[k-1]){
+      interval_integrator_.setInput(states_[k-1],INTEGRATOR_X0);
+      p_int[np] = grid_[k-1];
+      p_int[np+1] = grid_[k];
+      for(int dir=0; dir<nadir; ++dir){
+        for(int oind=0; oind<INTEGRATOR_NUM_OUT; ++oind){
+          interval_integrator_.adjSeed(oind,dir).setZero();
+        }
+        interval_integrator_.setAdjSeed(adjSens(INTEGRATOR_X0,dir),INTEGRATOR_XF,dir);
+      }
+      interval_integrator_.evaluate(0,nadir);
+      for(int dir=0; dir<nadir; ++dir){
+        adjSens(INTEGRATOR_X0,dir).set(interval_integrator_.adjSens(INTEGRATOR_X0,dir));
+        const vector<double>& asens_p = interval_integrator_.adjSens(INTEGRATOR_P,dir).data();
+        vector<double>& asens_p_sim = adjSens(INTEGRATOR_P,dir).data();
+        for(int i=0; i<np; ++i) asens_p_sim[i] += asens_p[i];
+      }
     }
   }
 }
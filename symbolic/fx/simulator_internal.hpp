@@ -53,12 +53,33 @@ public:
   /** \brief  Update the number of sensitivity directions during or after initialization */
   virtual void updateNumSens(bool recursive);
 
+  /** \brief  Create the integrator over a single interval of the grid, needed for the adjoint sensitivities */
+  void initAdj();
+
+  /** \brief  Adjoint sensitivities by a backward sweep over the grid, using the states of the last forward sweep */
+  void evaluateAdj(int nadir);
+
   Integrator integrator_;
+  
+  /// Integrator over a single interval of the grid with normalized time, the interval bounds appended to the parameters
+  Integrator interval_integrator_;
   FX output_fcn_;
   
   std::vector<double> grid_;
   
   std::vector< Matrix<double> > states_;
+  
+  /// Store the outputs only at every stride_-th grid point
+  int stride_;
+  
+  /// Stream the outputs to this binary file instead of storing them (if not empty)
+  std::string output_file_;
+  
+  /// Number of stored grid points buffered before writing to the output file
+  int buffer_size_;
+  
+  /// Buffer for the output file
+  std::vector<double> buffer_;
 };
   
 } // namespace CasADi
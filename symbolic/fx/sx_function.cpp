@@ -136,6 +136,13 @@ const vector<ScalarAtomic>& SXFunction::algorithm() const{
   return (*this)->algorithm_;
 }
 
+void SXFunction::evaluateBatch(int npoints, const std::vector<const double*>& arg, const std::vector<double*>& res){
+  assertInit();
+  casadi_assert_message(arg.size()==getNumInputs(), "SXFunction::evaluateBatch: Expecting " << getNumInputs() << " inputs, got " << arg.size());
+  casadi_assert_message(res.size()==getNumOutputs(), "SXFunction::evaluateBatch: Expecting " << getNumOutputs() << " outputs, got " << res.size());
+  (*this)->evaluateBatch(npoints,getPtr(arg),getPtr(res));
+}
+
 int SXFunction::countNodes() const{
   assertInit();
   return algorithm().size() - getNumScalarOutputs();
@@ -152,6 +152,15 @@ namespace CasADi{
     const std::vector<ScalarAtomic>& algorithm() const;
 #endif // SWIG
   
+#ifndef SWIG
+    /** \brief Evaluate the function at multiple points (no derivatives)
+     * Inputs and outputs are laid out structure-of-arrays: nonzero k of input (output) i at point j
+     * is stored at arg[i][k*npoints+j] (res[i][k*npoints+j]). Null output pointers are skipped and
+     * null input pointers are treated as zero.
+     */
+    void evaluateBatch(int npoints, const std::vector<const double*>& arg, const std::vector<double*>& res);
+#endif // SWIG
+
     /** \brief Get the number of atomic operations */
     int getAlgorithmSize() const{ return algorithm().size();}
 
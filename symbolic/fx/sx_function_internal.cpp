@@ -50,6 +50,12 @@
 llvm::IRBuilder<> builder(llvm::getGlobalContext());
 #endif // WITH_LLVM
 
+// Native just-in-time compilation is available for x86-64 on systems providing mmap
+#if !defined(WITH_LLVM) && defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define CASADI_NATIVE_JIT
+#include <sys/mman.h>
+#endif
+
 namespace CasADi{
 
   using namespace std;
@@ -61,6 +67,9 @@ namespace CasADi{
     addOption("just_in_time", OT_BOOLEAN,false,"Just-in-time compilation for numeric evaluation (experimental)");
     addOption("just_in_time_sparsity", OT_BOOLEAN,false,"Propagate sparsity patterns using just-in-time compilation to a CPU or GPU using OpenCL");
     addOption("just_in_time_opencl", OT_BOOLEAN,false,"Just-in-time compilation for numeric evaluation using OpenCL (experimental)");
+    addOption("evaluation_engine", OT_STRING,"switch","Interpreter used for numeric evaluation without derivatives",
+              "switch: dispatch each operation in the algorithm with a switch statement|threaded: pre-decode the algorithm into a stream of kernel function pointers");
+    addOption("codegen_simd_width", OT_INTEGER,0,"Number of lanes in the auto-vectorizable entry point \"evaluateVectorized\" of generated code (0: not generated)");
 
     // Check for duplicate entries among the input expressions
     bool has_duplicates = false;
@@ -100,9 +109,19 @@ namespace CasADi{
     sp_adj_kernel_ = 0;
     sp_program_ = 0;
 #endif // WITH_OPENCL
+
+#ifndef WITH_LLVM
+    jit_code_ = 0;
+    jit_code_size_ = 0;
+    jit_tape_offset_ = jit_fwd_offset_ = jit_adj_offset_ = 0;
+#endif // WITH_LLVM
   }
 
   SXFunctionInternal::~SXFunctionInternal(){
+#ifndef WITH_LLVM
+    jitFree();
+#endif // WITH_LLVM
+
     // Free OpenCL memory
 #ifdef WITH_OPENCL
     freeOpenCL();
@@ -161,8 +180,47 @@ namespace CasADi{
       jitfcn_(getPtr(input_ref_),getPtr(output_ref_));
       return;
     }
+#else // WITH_LLVM
+    if(jit_code_!=0){
+      // Evaluate the native code
+      updateIOPointers();
+      unsigned char* code = static_cast<unsigned char*>(jit_code_);
+      if(nfdir==0 && nadir==0){
+        reinterpret_cast<nativeFcn>(code)(getPtr(work_),getPtr(input_ptr_),getPtr(output_ptr_),0);
+        return;
+      }
+      double* pd = reinterpret_cast<double*>(getPtr(pdwork_));
+      reinterpret_cast<nativeFcn>(code+jit_tape_offset_)(getPtr(work_),getPtr(input_ptr_),getPtr(output_ptr_),pd);
+
+      // Directional derivatives, one direction at a time, each with its own part of the work vector
+      const int nw = work_.size();
+      const int ndir = std::max(nfdir,nadir);
+      if(dwork_.size()<nw*ndir) dwork_.resize(nw*ndir);
+      nativeFcn fwd = reinterpret_cast<nativeFcn>(code+jit_fwd_offset_);
+      for(int dir=0; dir<nfdir; ++dir){
+        for(int ind=0; ind<input_ptr_.size(); ++ind) input_ptr_[ind] = getPtr(fwdSeedNoCheck(ind,dir).data());
+        for(int ind=0; ind<output_ptr_.size(); ++ind) output_ptr_[ind] = getPtr(fwdSensNoCheck(ind,dir).data());
+        fwd(getPtr(dwork_)+dir*nw,getPtr(input_ptr_),getPtr(output_ptr_),pd);
+      }
+      if(nadir>0){
+        fill_n(dwork_.begin(),nw*nadir,0);
+        nativeFcn adj = reinterpret_cast<nativeFcn>(code+jit_adj_offset_);
+        for(int dir=0; dir<nadir; ++dir){
+          for(int ind=0; ind<input_ptr_.size(); ++ind) input_ptr_[ind] = getPtr(adjSensNoCheck(ind,dir).data());
+          for(int ind=0; ind<output_ptr_.size(); ++ind) output_ptr_[ind] = getPtr(adjSeedNoCheck(ind,dir).data());
+          adj(getPtr(dwork_)+dir*nw,getPtr(input_ptr_),getPtr(output_ptr_),pd);
+        }
+      }
+      return;
+    }
 #endif // WITH_LLVM
   
+    if(threaded_evaluation_ && nfdir==0 && nadir==0){
+      // Evaluate with the threaded interpreter
+      evaluateThreaded();
+      return; // Quick return
+    }
+
 #ifdef WITH_OPENCL
     if(just_in_time_opencl_ && nfdir==0 && nadir==0){
       // Evaluate with OpenCL
@@ -213,46 +271,255 @@ namespace CasADi{
     // Quick return if no sensitivities
     if(!taping) return;
 
-    // Calculate forward sensitivities
-    for(int dir=0; dir<nfdir; ++dir){
+    // Work vector for the directional derivatives, all directions of an element stored contiguously
+    const int ndir = std::max(nfdir,nadir);
+    if(dwork_.size()<work_.size()*ndir) dwork_.resize(work_.size()*ndir);
+    double* dw = getPtr(dwork_);
+
+    // Calculate forward sensitivities, all directions in one sweep
+    if(nfdir>0){
       vector<TapeEl<double> >::const_iterator it2 = pdwork_.begin();
       for(vector<AlgEl>::const_iterator it = algorithm_.begin(); it!=algorithm_.end(); ++it){
         switch(it->op){
         case OP_CONST:
-          work_[it->i0] = 0; break;
+          {
+            double* f0 = dw + it->i0*nfdir;
+            for(int dir=0; dir<nfdir; ++dir) f0[dir] = 0;
+          }
+          break;
         case OP_INPUT: 
-          work_[it->i0] = fwdSeedNoCheck(it->i1,dir).data()[it->i2]; break;
+          {
+            double* f0 = dw + it->i0*nfdir;
+            for(int dir=0; dir<nfdir; ++dir) f0[dir] = fwdSeedNoCheck(it->i1,dir).data()[it->i2];
+          }
+          break;
         case OP_OUTPUT: 
-          fwdSensNoCheck(it->i0,dir).data()[it->i2] = work_[it->i1]; break;
+          {
+            const double* f1 = dw + it->i1*nfdir;
+            for(int dir=0; dir<nfdir; ++dir) fwdSensNoCheck(it->i0,dir).data()[it->i2] = f1[dir];
+          }
+          break;
         default: // Unary or binary operation
-          work_[it->i0] = it2->d[0] * work_[it->i1] + it2->d[1] * work_[it->i2]; ++it2; break;
+          {
+            double* f0 = dw + it->i0*nfdir;
+            const double* f1 = dw + it->i1*nfdir;
+            const double* f2 = dw + it->i2*nfdir;
+            const double d0 = it2->d[0], d1 = it2->d[1];
+            for(int dir=0; dir<nfdir; ++dir) f0[dir] = d0 * f1[dir] + d1 * f2[dir];
+            ++it2;
+          }
         }
       }
     }
     
-    // Calculate adjoint sensitivities
-    if(nadir>0) fill(work_.begin(),work_.end(),0);
-    for(int dir=0; dir<nadir; ++dir){
+    // Calculate adjoint sensitivities, all directions in one sweep
+    if(nadir>0){
+      fill_n(dw,work_.size()*nadir,0);
       vector<TapeEl<double> >::const_reverse_iterator it2 = pdwork_.rbegin();
       for(vector<AlgEl>::const_reverse_iterator it = algorithm_.rbegin(); it!=algorithm_.rend(); ++it){
-        double seed;
         switch(it->op){
         case OP_CONST:
-          work_[it->i0] = 0;
+          {
+            double* f0 = dw + it->i0*nadir;
+            for(int dir=0; dir<nadir; ++dir) f0[dir] = 0;
+          }
           break;
         case OP_INPUT:
-          adjSensNoCheck(it->i1,dir).data()[it->i2] = work_[it->i0];
-          work_[it->i0] = 0;
+          {
+            double* f0 = dw + it->i0*nadir;
+            for(int dir=0; dir<nadir; ++dir){
+              adjSensNoCheck(it->i1,dir).data()[it->i2] = f0[dir];
+              f0[dir] = 0;
+            }
+          }
           break;
         case OP_OUTPUT:
-          work_[it->i1] += adjSeedNoCheck(it->i0,dir).data()[it->i2];
+          {
+            double* f1 = dw + it->i1*nadir;
+            for(int dir=0; dir<nadir; ++dir) f1[dir] += adjSeedNoCheck(it->i0,dir).data()[it->i2];
+          }
           break;
         default: // Unary or binary operation
-          seed = work_[it->i0];
-          work_[it->i0] = 0;
-          work_[it->i1] += it2->d[0] * seed;
-          work_[it->i2] += it2->d[1] * seed;
-          ++it2;
+          {
+            double* f0 = dw + it->i0*nadir;
+            double* f1 = dw + it->i1*nadir;
+            double* f2 = dw + it->i2*nadir;
+            const double d0 = it2->d[0], d1 = it2->d[1];
+            for(int dir=0; dir<nadir; ++dir){
+              double seed = f0[dir];
+              f0[dir] = 0;
+              f1[dir] += d0 * seed;
+              f2[dir] += d1 * seed;
+            }
+            ++it2;
+          }
+        }
+      }
+    }
+  }
+
+  namespace{
+    /// Kernel of the threaded interpreter for a built-in unary or binary operation
+    template<int I>
+    void threadedBuiltin(const SXFunctionInternal::ThreadedEl& el, double* w, double** x, double** r){
+      BinaryOperation<I>::fcn(w[el.arg.i1],w[el.arg.i2],w[el.i0]);
+    }
+
+    /// Kernel of the threaded interpreter for a constant
+    void threadedConst(const SXFunctionInternal::ThreadedEl& el, double* w, double** x, double** r){
+      w[el.i0] = el.d;
+    }
+
+    /// Kernel of the threaded interpreter for loading a function input to the work vector
+    void threadedInput(const SXFunctionInternal::ThreadedEl& el, double* w, double** x, double** r){
+      w[el.i0] = x[el.arg.i1][el.arg.i2];
+    }
+
+    /// Kernel of the threaded interpreter for getting a function output from the work vector
+    void threadedOutput(const SXFunctionInternal::ThreadedEl& el, double* w, double** x, double** r){
+      r[el.i0][el.arg.i2] = w[el.arg.i1];
+    }
+
+    /// Helper class to be plugged into CASADI_MATH_FUN_BUILTIN_GEN, looking up the kernel of a built-in operation
+    template<int I>
+    struct ThreadedKernelLookup{
+      static inline void fcn(int x, int y, SXFunctionInternal::ThreadedKernel& f, int n){ f = threadedBuiltin<I>;}
+    };
+  } // namespace
+
+  SXFunctionInternal::ThreadedKernel SXFunctionInternal::getThreadedKernel(int op){
+    ThreadedKernel ret = 0;
+    switch(op){
+      // Start by adding all of the built operations
+      CASADI_MATH_FUN_BUILTIN_GEN(ThreadedKernelLookup,0,0,ret,1)
+      
+      // Constant
+    case OP_CONST: ret = threadedConst; break;
+      
+      // Load function input to work vector
+    case OP_INPUT: ret = threadedInput; break;
+      
+      // Get function output from work vector
+    case OP_OUTPUT: ret = threadedOutput; break;
+    }
+    casadi_assert_message(ret!=0, "SXFunctionInternal::getThreadedKernel: No kernel for operation " << op);
+    return ret;
+  }
+
+  void SXFunctionInternal::updateIOPointers(){
+    input_ptr_.resize(getNumInputs());
+    for(int ind=0; ind<input_ptr_.size(); ++ind){
+      input_ptr_[ind] = getPtr(inputNoCheck(ind).data());
+    }
+    output_ptr_.resize(getNumOutputs());
+    for(int ind=0; ind<output_ptr_.size(); ++ind){
+      output_ptr_[ind] = getPtr(outputNoCheck(ind).data());
+    }
+  }
+
+  void SXFunctionInternal::evaluateThreaded(){
+    // Locate the input and output nonzeros
+    updateIOPointers();
+    
+    // Pointers to the work vector, inputs and outputs
+    double* w = getPtr(work_);
+    double** x = getPtr(input_ptr_);
+    double** r = getPtr(output_ptr_);
+
+    // Execute the instruction stream
+    for(vector<ThreadedEl>::const_iterator it=threaded_algorithm_.begin(); it!=threaded_algorithm_.end(); ++it){
+      it->fcn(*it,w,x,r);
+    }
+  }
+
+  bool SXFunctionInternal::isReentrant() const{
+    // Just-in-time compiled, threaded or OpenCL evaluation go through the inputs and outputs
+#ifdef WITH_LLVM
+    if(just_in_time_) return false;
+#else // WITH_LLVM
+    if(jit_code_!=0) return false;
+#endif // WITH_LLVM
+#ifdef WITH_OPENCL
+    if(just_in_time_opencl_) return false;
+#endif // WITH_OPENCL
+    return !threaded_evaluation_;
+  }
+
+  void SXFunctionInternal::workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const{
+    FXInternal::workSize(sz_arg,sz_res,sz_iw,sz_w);
+    sz_w = work_.size();
+  }
+
+  void SXFunctionInternal::evaluateRaw(const double* const* arg, double* const* res){
+    if(!isReentrant()) return FXInternal::evaluateRaw(arg,res);
+    evaluateRaw(const_cast<const double**>(arg),const_cast<double**>(res),0,getPtr(work_));
+  }
+
+  void SXFunctionInternal::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(!isReentrant()) return FXInternal::evaluateRaw(arg,res);
+
+    if (!free_vars_.empty()) {
+      std::stringstream ss;
+      repr(ss);
+      casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+    }
+
+    // Evaluate the algorithm
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      switch(it->op){
+        // Start by adding all of the built operations
+        CASADI_MATH_FUN_BUILTIN(w[it->i1],w[it->i2],w[it->i0])
+
+        // Constant
+      case OP_CONST: w[it->i0] = it->d; break;
+
+        // Load function input to work vector
+      case OP_INPUT: w[it->i0] = arg[it->i1]==0 ? 0 : arg[it->i1][it->i2]; break;
+
+        // Get function output from work vector
+      case OP_OUTPUT: if(res[it->i0]!=0) res[it->i0][it->i2] = w[it->i1]; break;
+      }
+    }
+  }
+
+  void SXFunctionInternal::evaluateBatch(int npoints, const double* const* arg, double* const* res){
+    if (!free_vars_.empty()) {
+      std::stringstream ss;
+      repr(ss);
+      casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+    }
+
+    // Each element of the work vector holds a block of points, contiguous in memory
+    const int bs = batch_block_size;
+    batch_work_.resize(work_.size()*bs);
+    double* w = getPtr(batch_work_);
+
+    // Loop over blocks of points
+    for(int offset=0; offset<npoints; offset+=bs){
+      // Number of points in the block
+      const int n = std::min(bs,npoints-offset);
+
+      // Run each instruction across all points of the block
+      for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+        switch(it->op){
+        case OP_CONST:
+          fill_n(w+it->i0*bs,n,it->d);
+          break;
+        case OP_INPUT:
+          if(arg[it->i1]==0){
+            fill_n(w+it->i0*bs,n,0.);
+          } else {
+            const double* x = arg[it->i1] + it->i2*npoints + offset;
+            copy(x,x+n,w+it->i0*bs);
+          }
+          break;
+        case OP_OUTPUT:
+          if(res[it->i0]!=0){
+            copy(w+it->i1*bs,w+it->i1*bs+n,res[it->i0] + it->i2*npoints + offset);
+          }
+          break;
+        default: // Unary or binary operation, vectorized over the points
+          casadi_math<double>::fun(it->op,w+it->i1*bs,w+it->i2*bs,w+it->i0*bs,n);
         }
       }
     }
@@ -404,6 +671,87 @@ namespace CasADi{
     }
   }
 
+  void SXFunctionInternal::generateVectorized(std::ostream &stream, CodeGenerator& gen) const{
+    // Number of lanes
+    int nl = getOption("codegen_simd_width");
+    if(nl==0) return;
+    casadi_assert_message(nl>0, "Option \"codegen_simd_width\" must be nonnegative");
+
+    // Buffers of lanes are aligned to the cache line if the lane count allows it
+    const int align = 64;
+    bool aligned = (nl*sizeof(double)) % align == 0;
+
+    // Restrict qualifier, if supported by the compiler
+    stream << "#ifndef CASADI_RESTRICT" << endl;
+    stream << "#if defined(__STDC_VERSION__) && __STDC_VERSION__>=199901L" << endl;
+    stream << "#define CASADI_RESTRICT restrict" << endl;
+    stream << "#elif defined(__GNUC__)" << endl;
+    stream << "#define CASADI_RESTRICT __restrict__" << endl;
+    stream << "#else" << endl;
+    stream << "#define CASADI_RESTRICT" << endl;
+    stream << "#endif" << endl;
+    stream << "#endif" << endl << endl;
+
+    // Work vector: one block of lanes for each variable, plus padding for the alignment
+    stream << "int work_size_vectorized(int *sz_w){" << endl;
+    stream << "  *sz_w = " << work_.size()*nl + align/sizeof(double) << ";" << endl;
+    stream << "  return 0;" << endl;
+    stream << "}" << endl << endl;
+
+    // Evaluate n points, nonzero k of argument i at point j stored at x[i][k*n+j]
+    stream << "int evaluateVectorized(int n, const d** x, d** r, d* w_unaligned){" << endl;
+    stream << "  int j, j0, nj;" << endl;
+    for(int i=0; i<getNumInputs(); ++i){
+      stream << "  const d* CASADI_RESTRICT x" << i << " = x[" << i << "];" << endl;
+    }
+    for(int i=0; i<getNumOutputs(); ++i){
+      stream << "  d* CASADI_RESTRICT r" << i << " = r[" << i << "];" << endl;
+    }
+    stream << "  d* CASADI_RESTRICT w = (d*)(((size_t)w_unaligned + " << align-1 << ") & ~(size_t)" << align-1 << ");" << endl;
+    if(aligned){
+      stream << "#ifdef __GNUC__" << endl;
+      stream << "  w = (d*)__builtin_assume_aligned(w," << align << ");" << endl;
+      stream << "#endif" << endl;
+    }
+
+    // Loop over blocks of lanes, padding the last block
+    stream << "  for(j0=0; j0<n; j0+=" << nl << "){" << endl;
+    stream << "    nj = n-j0<" << nl << " ? n-j0 : " << nl << ";" << endl;
+    
+    // Each operation in a loop over all lanes with a fixed trip count
+    for(vector<AlgEl>::const_iterator it = algorithm_.begin(); it!=algorithm_.end(); ++it){
+      if(it->op==OP_OUTPUT){
+        stream << "    if(r" << it->i0 << ") for(j=0; j<nj; ++j) r" << it->i0 << "[" << it->i2 << "*n+j0+j] = w[" << it->i1*nl << "+j];" << endl;
+        continue;
+      }
+      stream << "    for(j=0; j<" << nl << "; ++j) w[" << it->i0*nl << "+j] = ";
+      if(it->op==OP_CONST){
+        gen.printConstant(stream,it->d);
+      } else if(it->op==OP_INPUT){
+        stream << "j<nj ? x" << it->i1 << "[" << it->i2 << "*n+j0+j] : 0";
+      } else {
+        int ndep = casadi_math<double>::ndeps(it->op);
+        casadi_math<double>::printPre(it->op,stream);
+        for(int c=0; c<ndep; ++c){
+          if(c==0){
+            stream << "w[" << it->i1*nl << "+j]";
+          } else {
+            casadi_math<double>::printSep(it->op,stream);
+            stream << "w[" << it->i2*nl << "+j]";
+          }
+        }
+        casadi_math<double>::printPost(it->op,stream);
+      }
+      stream << ";" << endl;
+    }
+    stream << "  }" << endl;
+    stream << "  return 0;" << endl;
+    stream << "}" << endl << endl;
+
+    // size_t is needed for the alignment
+    gen.addInclude("stddef.h");
+  }
+
   void SXFunctionInternal::init(){
   
     // Call the init function of the base class
@@ -641,6 +989,24 @@ namespace CasADi{
   
     // Allocate memory for directional derivatives
     SXFunctionInternal::updateNumSens(false);
+
+    // Decode the algorithm for the threaded interpreter
+    threaded_evaluation_ = getOption("evaluation_engine")=="threaded";
+    threaded_algorithm_.clear();
+    if(threaded_evaluation_ && free_vars_.empty()){
+      threaded_algorithm_.resize(algorithm_.size());
+      vector<ThreadedEl>::iterator it1 = threaded_algorithm_.begin();
+      for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it, ++it1){
+        it1->fcn = getThreadedKernel(it->op);
+        it1->i0 = it->i0;
+        if(it->op==OP_CONST){
+          it1->d = it->d;
+        } else {
+          it1->arg.i1 = it->i1;
+          it1->arg.i2 = it->i2;
+        }
+      }
+    }
   
     // Initialize just-in-time compilation
     just_in_time_ = getOption("just_in_time");
@@ -833,9 +1199,15 @@ namespace CasADi{
       }
     
 #else // WITH_LLVM
-      casadi_error("Option \"just_in_time\" true requires CasADi to have been compiled with WITH_LLVM=ON");
+      // Emit native code, falls back to the interpreter if not supported on this platform
+      jitCompile();
 #endif //WITH_LLVM
     }
+#ifndef WITH_LLVM
+    else {
+      jitFree();
+    }
+#endif // WITH_LLVM
 
     // Initialize just-in-time compilation for numeric evaluation using OpenCL
     just_in_time_opencl_ = getOption("just_in_time_opencl");
@@ -868,6 +1240,9 @@ namespace CasADi{
   void SXFunctionInternal::updateNumSens(bool recursive){
     // Call the base class if needed
     if(recursive) XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>::updateNumSens(recursive);
+
+    // Allocate work vector for the directional derivatives
+    dwork_.resize(work_.size()*std::max(nfdir_,nadir_));
   }
 
   void SXFunctionInternal::evalSXsparse(const vector<SXMatrix>& arg1, vector<SXMatrix>& res1, 
@@ -1029,9 +1404,372 @@ namespace CasADi{
   }
 
   SXFunctionInternal* SXFunctionInternal::clone() const{
-    return new SXFunctionInternal(*this);
+    SXFunctionInternal* ret = new SXFunctionInternal(*this);
+#ifndef WITH_LLVM
+    // The native code is owned by this instance, emit a new copy
+    if(jit_code_!=0){
+      ret->jit_code_ = 0;
+      ret->jitCompile();
+    }
+#endif // WITH_LLVM
+    return ret;
+  }
+
+#ifndef WITH_LLVM
+#ifdef CASADI_NATIVE_JIT
+  namespace{
+    /// Function called from the native code for operations without a native instruction
+    typedef double (*JitBuiltin)(double x, double y);
+
+    /// Evaluate a built-in operation, to be called from the native code
+    template<int I>
+    double jitBuiltin(double x, double y){
+      double f;
+      BinaryOperation<I>::fcn(x,y,f);
+      return f;
+    }
+
+    /// Helper class to be plugged into CASADI_MATH_FUN_BUILTIN_GEN, looking up the function of a built-in operation
+    template<int I>
+    struct JitBuiltinLookup{
+      static inline void fcn(int x, int y, JitBuiltin& f, int n){ f = jitBuiltin<I>;}
+    };
+
+    /// Function called from the native code for the value and partial derivatives of operations without native instructions
+    typedef void (*JitBuiltinDer)(double x, double y, double* f, double* d);
+
+    /// Evaluate a built-in operation and its partial derivatives, to be called from the native code
+    template<int I>
+    void jitBuiltinDer(double x, double y, double* f, double* d){
+      DerBinaryOpertion<I>::derf(x,y,*f,d);
+    }
+
+    /// Helper class to be plugged into CASADI_MATH_FUN_BUILTIN_GEN, looking up the derivative function of a built-in operation
+    template<int I>
+    struct JitBuiltinDerLookup{
+      static inline void fcn(int x, int y, JitBuiltinDer& f, int n){ f = jitBuiltinDer<I>;}
+    };
+
+    /// Assembler for the small subset of x86-64 needed by SXFunctionInternal::jitCompile
+    class X86Emitter{
+    public:
+      /// The machine code
+      std::vector<unsigned char> code;
+
+      /// Append bytes
+      void b(unsigned char c0){ code.push_back(c0);}
+      void b(unsigned char c0, unsigned char c1){ b(c0); b(c1);}
+      void b(unsigned char c0, unsigned char c1, unsigned char c2){ b(c0,c1); b(c2);}
+      void b(unsigned char c0, unsigned char c1, unsigned char c2, unsigned char c3){ b(c0,c1); b(c2,c3);}
+
+      /// Append a 32-bit displacement for an element of a double array
+      void disp(int ind){
+        casadi_assert_message(ind>=0 && ind < std::numeric_limits<int>::max()/8, "X86Emitter: Index out of range");
+        int d = 8*ind;
+        for(int k=0; k<4; ++k) b((d >> (8*k)) & 0xff);
+      }
+
+      /// Append a 64-bit immediate
+      void imm64(unsigned long long v){
+        for(int k=0; k<8; ++k) b((v >> (8*k)) & 0xff);
+      }
+
+      /// Start a function with the signature void (double* w, double** x, double** r, double* d):
+      /// save the callee-saved registers and keep w in rbx, x in r12, r in r13 and d in r14
+      void prologue(){
+        b(0x53);              // push rbx
+        b(0x41,0x54);         // push r12
+        b(0x41,0x55);         // push r13
+        b(0x41,0x56);         // push r14
+        b(0x48,0x83,0xEC,0x08); // sub rsp, 8 (stack 16-byte aligned for calls)
+        b(0x48,0x89,0xFB);    // mov rbx, rdi
+        b(0x49,0x89,0xF4);    // mov r12, rsi
+        b(0x49,0x89,0xD5);    // mov r13, rdx
+        b(0x49,0x89,0xCE);    // mov r14, rcx
+      }
+
+      /// Restore the registers and return
+      void epilogue(){
+        b(0x48,0x83,0xC4,0x08); // add rsp, 8
+        b(0x41,0x5E);         // pop r14
+        b(0x41,0x5D);         // pop r13
+        b(0x41,0x5C);         // pop r12
+        b(0x5B);              // pop rbx
+        b(0xC3);              // ret
+      }
+
+      /// movsd xmm{reg}, [rbx+8*ind] (work vector element)
+      void loadWork(int reg, int ind){ b(0xF2,0x0F,0x10,0x83 | (reg<<3)); disp(ind);}
+
+      /// movsd [rbx+8*ind], xmm{reg}
+      void storeWork(int ind, int reg=0){ b(0xF2,0x0F,0x11,0x83 | (reg<<3)); disp(ind);}
+
+      /// movsd xmm{reg}, [r14+8*ind] and movsd [r14+8*ind], xmm{reg} (partial derivatives)
+      void loadTape(int reg, int ind){ b(0xF2,0x41,0x0F,0x10); b(0x86 | (reg<<3)); disp(ind);}
+      void storeTape(int ind, int reg){ b(0xF2,0x41,0x0F,0x11); b(0x86 | (reg<<3)); disp(ind);}
+
+      /// SSE2 scalar operation xmm{reg} = xmm{reg} (op) [rbx+8*ind], opcode 0x58: add, 0x5C: sub, 0x59: mul, 0x5E: div, 0x51: sqrt
+      void opWork(unsigned char opcode, int ind, int reg=0){ b(0xF2,0x0F,opcode,0x83 | (reg<<3)); disp(ind);}
+
+      /// SSE2 scalar operation xmm{dst} = xmm{dst} (op) xmm{src}
+      void opReg(unsigned char opcode, int dst, int src){ b(0xF2,0x0F,opcode,0xC0 | (dst<<3) | src);}
+
+      /// mov rax, [rbx+8*ind] and mov [rbx+8*ind], rax
+      void loadWorkRax(int ind){ b(0x48,0x8B,0x83); disp(ind);}
+      void storeWorkRax(int ind){ b(0x48,0x89,0x83); disp(ind);}
+
+      /// mov [r14+8*ind], rax
+      void storeTapeRax(int ind){ b(0x49,0x89,0x86); disp(ind);}
+
+      /// Set a work vector element to zero
+      void zeroWork(int ind){
+        b(0x31,0xC9);                   // xor ecx, ecx
+        b(0x48,0x89,0x8B); disp(ind);   // mov [rbx+8*ind], rcx
+      }
+
+      /// mov rax, imm64
+      void movRaxImm(unsigned long long v){ b(0x48,0xB8); imm64(v);}
+
+      /// movq xmm0, rax
+      void movXmm0Rax(){ b(0x66,0x48,0x0F); b(0x6E,0xC0);}
+
+      /// Copy nonzero i2 of x[i1] to element i0 of the work vector
+      void copyInput(int i0, int i1, int i2){
+        b(0x49,0x8B,0x84,0x24); disp(i1); // mov rax, [r12+8*i1]
+        b(0x48,0x8B,0x80); disp(i2);      // mov rax, [rax+8*i2]
+        storeWorkRax(i0);
+      }
+
+      /// Copy element i1 of the work vector to nonzero i2 of r[i0]
+      void copyOutput(int i0, int i1, int i2){
+        b(0x49,0x8B,0x85); disp(i0);      // mov rax, [r13+8*i0]
+        b(0x48,0x8B,0x8B); disp(i1);      // mov rcx, [rbx+8*i1]
+        b(0x48,0x89,0x88); disp(i2);      // mov [rax+8*i2], rcx
+      }
+
+      /// Call a function pointer, arguments already in place
+      void call(unsigned long long fcn){
+        movRaxImm(fcn);
+        b(0xFF,0xD0);   // call rax
+      }
+    };
+
+    /// Bit pattern of a double
+    unsigned long long doubleBits(double v){
+      unsigned long long ret;
+      std::copy(reinterpret_cast<const char*>(&v),reinterpret_cast<const char*>(&v)+sizeof(double),reinterpret_cast<char*>(&ret));
+      return ret;
+    }
+  } // namespace
+#endif // CASADI_NATIVE_JIT
+
+  void SXFunctionInternal::jitCompile(){
+    // Free previously emitted code
+    jitFree();
+
+#ifdef CASADI_NATIVE_JIT
+    // All functions have the signature void (double* w, double** x, double** r, double* d), see X86Emitter::prologue
+    X86Emitter e;
+    casadi_assert(sizeof(TapeEl<double>)==2*sizeof(double));
+
+    // Nondifferentiated evaluation
+    e.prologue();
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      switch(it->op){
+      case OP_CONST:
+        e.movRaxImm(doubleBits(it->d));
+        e.storeWorkRax(it->i0);
+        break;
+      case OP_INPUT: e.copyInput(it->i0,it->i1,it->i2); break;
+      case OP_OUTPUT: e.copyOutput(it->i0,it->i1,it->i2); break;
+      case OP_ADD: e.loadWork(0,it->i1); e.opWork(0x58,it->i2); e.storeWork(it->i0); break;
+      case OP_SUB: e.loadWork(0,it->i1); e.opWork(0x5C,it->i2); e.storeWork(it->i0); break;
+      case OP_MUL: e.loadWork(0,it->i1); e.opWork(0x59,it->i2); e.storeWork(it->i0); break;
+      case OP_DIV: e.loadWork(0,it->i1); e.opWork(0x5E,it->i2); e.storeWork(it->i0); break;
+      case OP_SQRT: e.opWork(0x51,it->i1); e.storeWork(it->i0); break;
+      case OP_SQ: e.loadWork(0,it->i1); e.opReg(0x59,0,0); e.storeWork(it->i0); break;
+      case OP_TWICE: e.loadWork(0,it->i1); e.opReg(0x58,0,0); e.storeWork(it->i0); break;
+      case OP_INV:
+        e.movRaxImm(doubleBits(1.0));
+        e.movXmm0Rax();
+        e.opWork(0x5E,it->i1);
+        e.storeWork(it->i0);
+        break;
+      case OP_NEG: // flip the sign bit
+        e.loadWorkRax(it->i1);
+        e.b(0x48,0x0F,0xBA); e.b(0xF8,0x3F); // btc rax, 63
+        e.storeWorkRax(it->i0);
+        break;
+      case OP_FABS: // clear the sign bit
+        e.loadWorkRax(it->i1);
+        e.b(0x48,0x0F,0xBA); e.b(0xF0,0x3F); // btr rax, 63
+        e.storeWorkRax(it->i0);
+        break;
+      default:
+        {
+          // Call the interpreter's implementation of the operation
+          JitBuiltin fcn = 0;
+          switch(it->op){
+            CASADI_MATH_FUN_BUILTIN_GEN(JitBuiltinLookup,0,0,fcn,1)
+          }
+          casadi_assert_message(fcn!=0, "SXFunctionInternal::jitCompile: No way to treat operation " << it->op);
+          e.loadWork(0,it->i1);
+          e.loadWork(1,it->i2);
+          e.call(reinterpret_cast<unsigned long long>(fcn));
+          e.storeWork(it->i0);
+        }
+      }
+    }
+    e.epilogue();
+
+    // Evaluation with the partial derivatives of each operation stored in d, the same tape as pdwork_
+    jit_tape_offset_ = e.code.size();
+    e.prologue();
+    int k = 0; // Tape index
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      switch(it->op){
+      case OP_CONST:
+        e.movRaxImm(doubleBits(it->d));
+        e.storeWorkRax(it->i0);
+        break;
+      case OP_INPUT: e.copyInput(it->i0,it->i1,it->i2); break;
+      case OP_OUTPUT: e.copyOutput(it->i0,it->i1,it->i2); break;
+      case OP_ADD:
+      case OP_SUB:
+        e.loadWork(0,it->i1);
+        e.opWork(it->op==OP_ADD ? 0x58 : 0x5C,it->i2);
+        e.storeWork(it->i0);
+        e.movRaxImm(doubleBits(1.0));
+        e.storeTapeRax(2*k);
+        e.movRaxImm(doubleBits(it->op==OP_ADD ? 1.0 : -1.0));
+        e.storeTapeRax(2*k+1);
+        k++;
+        break;
+      case OP_MUL:
+        e.loadWork(0,it->i1);
+        e.loadWork(1,it->i2);
+        e.storeTape(2*k,1);
+        e.storeTape(2*k+1,0);
+        e.opReg(0x59,0,1);
+        e.storeWork(it->i0);
+        k++;
+        break;
+      default:
+        {
+          // Call the interpreter's implementation of the operation and its partial derivatives
+          JitBuiltinDer fcn = 0;
+          switch(it->op){
+            CASADI_MATH_FUN_BUILTIN_GEN(JitBuiltinDerLookup,0,0,fcn,1)
+          }
+          casadi_assert_message(fcn!=0, "SXFunctionInternal::jitCompile: No way to treat operation " << it->op);
+          e.loadWork(0,it->i1);
+          e.loadWork(1,it->i2);
+          e.b(0x48,0x8D,0xBB); e.disp(it->i0);  // lea rdi, [rbx+8*i0]
+          e.b(0x49,0x8D,0xB6); e.disp(2*k);     // lea rsi, [r14+16*k]
+          e.call(reinterpret_cast<unsigned long long>(fcn));
+          k++;
+        }
+      }
+    }
+    e.epilogue();
+    casadi_assert(k==pdwork_.size());
+
+    // Forward sweep in one direction: w holds the directional derivatives, x the seeds and r the sensitivities
+    jit_fwd_offset_ = e.code.size();
+    e.prologue();
+    k = 0;
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      switch(it->op){
+      case OP_CONST: e.zeroWork(it->i0); break;
+      case OP_INPUT: e.copyInput(it->i0,it->i1,it->i2); break;
+      case OP_OUTPUT: e.copyOutput(it->i0,it->i1,it->i2); break;
+      default:
+        // w[i0] = d0*w[i1] + d1*w[i2]
+        e.loadTape(0,2*k);
+        e.opWork(0x59,it->i1,0);
+        if(casadi_math<double>::ndeps(it->op)==2){
+          e.loadTape(1,2*k+1);
+          e.opWork(0x59,it->i2,1);
+          e.opReg(0x58,0,1);
+        }
+        e.storeWork(it->i0);
+        k++;
+      }
+    }
+    e.epilogue();
+
+    // Adjoint sweep in one direction: w holds the adjoints (zero on entry), x the sensitivities and r the seeds
+    jit_adj_offset_ = e.code.size();
+    e.prologue();
+    k = pdwork_.size();
+    for(vector<AlgEl>::const_reverse_iterator it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it){
+      switch(it->op){
+      case OP_CONST: e.zeroWork(it->i0); break;
+      case OP_INPUT: 
+        e.b(0x49,0x8B,0x84,0x24); e.disp(it->i1); // mov rax, [r12+8*i1]
+        e.b(0x48,0x8B,0x8B); e.disp(it->i0);      // mov rcx, [rbx+8*i0]
+        e.b(0x48,0x89,0x88); e.disp(it->i2);      // mov [rax+8*i2], rcx
+        e.zeroWork(it->i0);
+        break;
+      case OP_OUTPUT:
+        e.b(0x49,0x8B,0x85); e.disp(it->i0);      // mov rax, [r13+8*i0]
+        e.loadWork(0,it->i1);
+        e.b(0xF2,0x0F,0x58,0x80); e.disp(it->i2); // addsd xmm0, [rax+8*i2]
+        e.storeWork(it->i1);
+        break;
+      default:
+        // seed = w[i0], w[i0] = 0, w[i1] += d0*seed, w[i2] += d1*seed
+        --k;
+        e.loadWork(2,it->i0);
+        e.zeroWork(it->i0);
+        e.loadTape(0,2*k);
+        e.opReg(0x59,0,2);
+        e.opWork(0x58,it->i1);
+        e.storeWork(it->i1);
+        if(casadi_math<double>::ndeps(it->op)==2){
+          e.loadTape(0,2*k+1);
+          e.opReg(0x59,0,2);
+          e.opWork(0x58,it->i2);
+          e.storeWork(it->i2);
+        }
+      }
+    }
+    e.epilogue();
+
+    // Copy to executable memory, if the system does not allow this, the interpreter is used
+    void* mem = mmap(0,e.code.size(),PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    if(mem==MAP_FAILED){
+      casadi_warning("SXFunctionInternal::jitCompile: Failed to allocate memory, falling back to the interpreter");
+      return;
+    }
+    copy(e.code.begin(),e.code.end(),static_cast<unsigned char*>(mem));
+    if(mprotect(mem,e.code.size(),PROT_READ | PROT_EXEC)!=0){
+      munmap(mem,e.code.size());
+      casadi_warning("SXFunctionInternal::jitCompile: Failed to make memory executable, falling back to the interpreter");
+      return;
+    }
+    jit_code_ = mem;
+    jit_code_size_ = e.code.size();
+
+    if(verbose()){
+      cout << "SXFunctionInternal::jitCompile: " << jit_code_size_ << " bytes of native code for " << algorithm_.size() << " elementary operations" << endl;
+    }
+#else // CASADI_NATIVE_JIT
+    casadi_warning("Native just-in-time compilation is only available for x86-64, falling back to the interpreter. Recompile CasADi with WITH_LLVM=ON for just-in-time compilation on other platforms.");
+#endif // CASADI_NATIVE_JIT
   }
 
+  void SXFunctionInternal::jitFree(){
+#ifdef CASADI_NATIVE_JIT
+    if(jit_code_!=0){
+      munmap(jit_code_,jit_code_size_);
+    }
+#endif // CASADI_NATIVE_JIT
+    jit_code_ = 0;
+    jit_code_size_ = 0;
+  }
+#endif // WITH_LLVM
+
 
   void SXFunctionInternal::clearSymbolic(){
     inputv_.clear();
@@ -1111,6 +1849,139 @@ namespace CasADi{
     }
   }
 
+  template<int NW>
+  void SXFunctionInternal::spEvaluateWideGen(bool fwd, int iind, int oind, int nw_runtime, const bvec_t* seed, bvec_t* sens, bvec_t* w) const{
+    // Number of bvec_t per element, a compile time constant when NW>0
+    const int nw = NW>0 ? NW : nw_runtime;
+    
+    if(fwd){
+      // Propagate sparsity forward
+      for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+        switch(it->op){
+        case OP_CONST:
+        case OP_PARAMETER:
+          {
+            bvec_t* r = w + it->i0*nw;
+            for(int k=0; k<nw; ++k) r[k] = 0;
+          }
+          break;
+        case OP_INPUT:
+          {
+            bvec_t* r = w + it->i0*nw;
+            if(it->i1==iind){
+              const bvec_t* x = seed + it->i2*nw;
+              for(int k=0; k<nw; ++k) r[k] = x[k];
+            } else {
+              for(int k=0; k<nw; ++k) r[k] = 0;
+            }
+          }
+          break;
+        case OP_OUTPUT:
+          if(it->i0==oind){
+            const bvec_t* x = w + it->i1*nw;
+            bvec_t* r = sens + it->i2*nw;
+            for(int k=0; k<nw; ++k) r[k] = x[k];
+          }
+          break;
+        default: // Unary or binary operation
+          {
+            bvec_t* r = w + it->i0*nw;
+            const bvec_t* x = w + it->i1*nw;
+            const bvec_t* y = w + it->i2*nw;
+            for(int k=0; k<nw; ++k) r[k] = x[k] | y[k];
+          }
+        }
+      }
+      
+    } else { // Backward propagation
+      
+      // Propagate sparsity backward, leaves the work vector zero
+      for(vector<AlgEl>::const_reverse_iterator it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it){
+        switch(it->op){
+        case OP_CONST:
+        case OP_PARAMETER:
+          {
+            bvec_t* r = w + it->i0*nw;
+            for(int k=0; k<nw; ++k) r[k] = 0;
+          }
+          break;
+        case OP_INPUT:
+          {
+            bvec_t* r = w + it->i0*nw;
+            if(it->i1==iind){
+              bvec_t* s = sens + it->i2*nw;
+              for(int k=0; k<nw; ++k) s[k] = r[k];
+            }
+            for(int k=0; k<nw; ++k) r[k] = 0;
+          }
+          break;
+        case OP_OUTPUT:
+          if(it->i0==oind){
+            bvec_t* r = w + it->i1*nw;
+            const bvec_t* s = seed + it->i2*nw;
+            for(int k=0; k<nw; ++k) r[k] |= s[k];
+          }
+          break;
+        default: // Unary or binary operation
+          {
+            bvec_t* r = w + it->i0*nw;
+            bvec_t* x = w + it->i1*nw;
+            bvec_t* y = w + it->i2*nw;
+            for(int k=0; k<nw; ++k){
+              bvec_t s = r[k];
+              r[k] = 0;
+              x[k] |= s;
+              y[k] |= s;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void SXFunctionInternal::spEvaluateWide(bool fwd, int iind, int oind, int nw, const bvec_t* seed, bvec_t* sens, bvec_t* w) const{
+    switch(nw){
+      case 1: spEvaluateWideGen<1>(fwd,iind,oind,nw,seed,sens,w); break; //  64 bits
+      case 4: spEvaluateWideGen<4>(fwd,iind,oind,nw,seed,sens,w); break; // 256 bits
+      case 8: spEvaluateWideGen<8>(fwd,iind,oind,nw,seed,sens,w); break; // 512 bits
+      default: spEvaluateWideGen<0>(fwd,iind,oind,nw,seed,sens,w);
+    }
+  }
+
+  std::string SXFunctionInternal::structuralHash() const{
+    // Integer representation of the sparsity of the inputs and outputs and of the algorithm (the values of constants do not matter)
+    vector<int> v;
+    v.push_back(getNumInputs());
+    v.push_back(getNumOutputs());
+    for(int k=0; k<getNumInputs()+getNumOutputs(); ++k){
+      const CRSSparsity& sp = k<getNumInputs() ? inputNoCheck(k).sparsity() : outputNoCheck(k-getNumInputs()).sparsity();
+      v.push_back(sp.size1());
+      v.push_back(sp.size2());
+      v.insert(v.end(),sp.rowind().begin(),sp.rowind().end());
+      v.insert(v.end(),sp.col().begin(),sp.col().end());
+    }
+    v.push_back(work_.size());
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      v.push_back(it->op);
+      v.push_back(it->i0);
+      if(it->op!=OP_CONST){
+        v.push_back(it->i1);
+        v.push_back(it->i2);
+      }
+    }
+
+    // Two independent 64-bit hashes: FNV-1a and the hash_combine used for the sparsity patterns
+    unsigned long long h1 = 14695981039346656037ULL;
+    unsigned long long h2 = 0;
+    for(vector<int>::const_iterator i=v.begin(); i!=v.end(); ++i){
+      h1 = (h1 ^ static_cast<unsigned int>(*i)) * 1099511628211ULL;
+      h2 ^= static_cast<unsigned int>(*i) + 0x9e3779b97f4a7c15ULL + (h2 << 6) + (h2 >> 2);
+    }
+    stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << h1 << std::setw(16) << h2;
+    return ss.str();
+  }
+
   FX SXFunctionInternal::getFullJacobian(){
     // Get the nonzeros of each input
     vector<SXMatrix> argv = inputv_;
@@ -1418,7 +2289,7 @@ namespace CasADi{
 
     // Generate the function
     CodeGenerator gen;
-    generateFunction(ss, "evaluate", "__global const double*","__global double*","double",gen);
+    generateFunction(ss, "evaluate", "__global const double*","__global double*","double",gen,false);
   
     // Form c-string
     std::string s = ss.str();
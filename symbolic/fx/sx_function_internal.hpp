@@ -142,10 +142,67 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
   /** \brief  all binary nodes of the tree in the order of execution */
   std::vector<AlgEl> algorithm_;
 
+  /** \brief  An element of the pre-decoded instruction stream, see ThreadedKernel */
+  struct ThreadedEl;
+
+  /** \brief  Kernel executing one pre-decoded instruction: work vector, input nonzeros, output nonzeros */
+  typedef void (*ThreadedKernel)(const ThreadedEl& el, double* w, double** x, double** r);
+
+  /** \brief  An element of the pre-decoded instruction stream: the kernel and its operands */
+  struct ThreadedEl{
+    /// Operand indices of a non-constant instruction
+    struct Arg{ int i1,i2; };
+    ThreadedKernel fcn;
+    int i0;
+    union{
+      double d;
+      Arg arg;
+    };
+  };
+
+  /** \brief  Get the kernel corresponding to an operation in the algorithm */
+  static ThreadedKernel getThreadedKernel(int op);
+
+  /** \brief  Evaluate the function numerically using the threaded instruction stream (no derivatives) */
+  void evaluateThreaded();
+
+  /** \brief  Evaluate numerically with raw pointers, interpreted directly without touching input() and output() */
+  virtual void evaluateRaw(const double* const* arg, double* const* res);
+
+  /** \brief  Evaluate numerically using the caller-owned work array w */
+  virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+  /** \brief  Get the length of the work arrays needed by evaluateRaw */
+  virtual void workSize(int& sz_arg, int& sz_res, int& sz_iw, int& sz_w) const;
+
+  /** \brief  Reentrant unless evaluated just-in-time, threaded or with OpenCL */
+  virtual bool isReentrant() const;
+
+  /** \brief  Evaluate the function numerically at multiple points, inputs and outputs structure-of-arrays */
+  void evaluateBatch(int npoints, const double* const* arg, double* const* res);
+
+  /** \brief  Number of points evaluated simultaneously in evaluateBatch */
+  static const int batch_block_size = 64;
+
+  /** \brief  Work vector for evaluateBatch, batch_block_size lanes per element of work_ */
+  std::vector<double> batch_work_;
+
+  /** \brief  The algorithm, decoded into an instruction stream for the threaded interpreter */
+  std::vector<ThreadedEl> threaded_algorithm_;
+
+  /** \brief  Pointers to the input and output nonzeros, set before each threaded or native evaluation */
+  std::vector<double*> input_ptr_, output_ptr_;
+
+  /** \brief  Update input_ptr_ and output_ptr_ */
+  void updateIOPointers();
+
   /** \brief  Working vector for numeric calculation */
   std::vector<double> work_;
   std::vector<TapeEl<double> > pdwork_;
 
+  /** \brief  Working vector for the directional derivatives, all directions of an element of work_ contiguous */
+  std::vector<double> dwork_;
+
   /// work vector for symbolic calculations (allocated first time)
   std::vector<SX> s_work_;
   std::vector<SX> free_vars_;
@@ -168,6 +225,9 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
   /** \brief Generate code for the body of the C function */
   virtual void generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const;
 
+  /** \brief Generate the entry point evaluating multiple points in lane loops (option "codegen_simd_width") */
+  virtual void generateVectorized(std::ostream &stream, CodeGenerator& gen) const;
+
   /** \brief Clear the function from its symbolic representation, to free up memory, no symbolic evaluations are possible after this */
   void clearSymbolic();
   
@@ -179,19 +239,56 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
 
   /// Reset the sparsity propagation
   virtual void spInit(bool fwd);
+
+  /// Is the class able to propagate wide seeds with spEvaluateWide?
+  virtual bool spCanEvaluateWide(bool fwd) const{ return true;}
+
+  /// Length of the work vector of spEvaluateWide, per bvec_t of the seeds
+  virtual int spWideWorkSize() const{ return work_.size();}
+
+  /// Propagate a sparsity pattern with nw*bvec_size directions through the algorithm, thread safe
+  virtual void spEvaluateWide(bool fwd, int iind, int oind, int nw, const bvec_t* seed, bvec_t* sens, bvec_t* w) const;
+
+  /// Implementation of spEvaluateWide for NW bvec_t per element (or nw if NW==0), fixed widths are unrolled and vectorized by the compiler
+  template<int NW>
+  void spEvaluateWideGen(bool fwd, int iind, int oind, int nw, const bvec_t* seed, bvec_t* sens, bvec_t* w) const;
   
+  /// Hash of the algorithm and of the input and output sparsity, key in the on-disk sparsity cache
+  virtual std::string structuralHash() const;
+
   /// Get jacobian of all nonzero outputs with respect to all nonzero inputs
   virtual FX getFullJacobian();
 
   /// With just-in-time compilation
   bool just_in_time_;
 
+  /// Evaluate using the threaded interpreter rather than the switch-based one
+  bool threaded_evaluation_;
+
   /// With just-in-time compilation using OpenCL
   bool just_in_time_opencl_;
 
   /// With just-in-time compilation for the sparsity propagation
   bool just_in_time_sparsity_;
   
+#ifndef WITH_LLVM
+  /// Emit native x86-64 machine code for the algorithm and its forward and adjoint sweeps (just-in-time compilation without LLVM)
+  void jitCompile();
+
+  /// Free the native machine code
+  void jitFree();
+
+  // Function pointer type to the native functions: work vector, input nonzeros, output nonzeros, partial derivatives
+  typedef void (*nativeFcn)(double* w, double** x, double** r, double* d);
+
+  /// Executable memory holding the native machine code (null if not compiled) and its size in bytes
+  void* jit_code_;
+  size_t jit_code_size_;
+
+  /// Offsets in jit_code_ of the evaluation with partial derivatives and of the forward and adjoint sweeps in one direction
+  size_t jit_tape_offset_, jit_fwd_offset_, jit_adj_offset_;
+#endif // WITH_LLVM
+
 #ifdef WITH_LLVM
   llvm::Module *jit_module_;
   llvm::Function *jit_function_;
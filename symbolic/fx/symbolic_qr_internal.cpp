@@ -111,7 +111,7 @@ namespace CasADi{
     // Symbolic expressions for solve function
     SXMatrix Q = ssym("Q",QR[0].sparsity());
     SXMatrix R = ssym("R",QR[1].sparsity());
-    SXMatrix b = ssym("b",input(1).sparsity());
+    SXMatrix b = ssym("b",input(LINSOL_B).size2(),1); // one right hand side at a time
     
     // Solve non-transposed
     // We have inv(A) = inv(Px) * inv(R) * Q' * Pb
@@ -208,6 +208,7 @@ namespace CasADi{
     fact_fcn_.evaluate();
     fact_fcn_.getOutput(Q_,0);
     fact_fcn_.getOutput(R_,1);
+    prepared_ = true;
   }
 
   void SymbolicQRInternal::solve(double* x, int nrhs, bool transpose){
@@ -235,35 +236,58 @@ namespace CasADi{
     gen.addDependency(solv_fcn_T_);
   }
 
+  size_t SymbolicQRInternal::persistentSizeCode() const{
+    // Flag, A, Q and R
+    return 1 + input(LINSOL_A).size() + Q_.size() + R_.size();
+  }
+
+  void SymbolicQRInternal::workSizeCode(size_t& ni, size_t& nr) const{
+    // Work vectors of the embedded functions
+    const FX* fcn[] = {&fact_fcn_, &solv_fcn_N_, &solv_fcn_T_};
+    ni = nr = 0;
+    for(int k=0; k<3; ++k){
+      size_t ni_f, nr_f;
+      (*fcn[k])->workSizeCode(ni_f,nr_f);
+      ni = std::max(ni,ni_f);
+      nr = std::max(nr,nr_f);
+    }
+
+    // Factorization kept between calls
+    nr += persistentSizeCode();
+  }
+
   void SymbolicQRInternal::generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const{
     
-    // Data structures to hold A, Q and R
-    stream << "  static int prepared = 0;" << endl;
-    stream << "  static d A[" << input(LINSOL_A).size() << "];" << endl;
-    stream << "  static d Q[" << Q_.size() << "];" << endl;
-    stream << "  static d R[" << R_.size() << "];" << endl;
+    // A, Q and R of the last factorization are kept at the beginning of the work vector, 
+    // followed by the work vector for the embedded functions
+    int nA = input(LINSOL_A).size();
+    stream << "  d *prepared=w, *A=w+1, *Q=w+" << 1+nA << ", *R=w+" << 1+nA+Q_.size() << ";" << endl;
+    stream << "  w += " << persistentSizeCode() << ";" << endl;
 
     // Store matrix to be factorized and check if up-to-date
     stream << "  int i;" << endl;
-    stream << "  for(i=0; i<" << input(LINSOL_A).size() << "; ++i){" << endl;
-    stream << "    prepared = prepared && A[i] == x0[i];" << endl;
+    stream << "  for(i=0; i<" << nA << "; ++i){" << endl;
+    stream << "    if(A[i] != x0[i]) *prepared = 0;" << endl;
     stream << "    A[i] = x0[i];" << endl;
     stream << "  }" << endl;
 
     // Factorize if needed
     int fact_ind = gen.getDependency(fact_fcn_);
-    stream << "  if(!prepared){" << endl;
-    stream << "    f" << fact_ind << "(A,Q,R);" << endl;
-    stream << "    prepared = 1;" << endl;
+    stream << "  if(*prepared != 1){" << endl;
+    stream << "    f" << fact_ind << "(A,Q,R,iw,w);" << endl;
+    stream << "    *prepared = 1;" << endl;
     stream << "  }" << endl;
 
-    // Solve
+    // Solve for each right hand side, using the same functions as SymbolicQRInternal::solve
     int solv_ind_N = gen.getDependency(solv_fcn_N_);
     int solv_ind_T = gen.getDependency(solv_fcn_T_);
-    stream << "  if(*x2==0){" << endl;
-    stream << "    f" << solv_ind_N << "(Q,R,x1,r0);" << endl;    
-    stream << "  } else {" << endl;
-    stream << "    f" << solv_ind_T << "(Q,R,x1,r0);" << endl;    
+    int n = input(LINSOL_B).size2();
+    stream << "  for(i=0; i<" << input(LINSOL_B).size1() << "; ++i){" << endl;
+    stream << "    if(*x2==0){" << endl;
+    stream << "      f" << solv_ind_T << "(Q,R,x1+i*" << n << ",r0+i*" << n << ",iw,w);" << endl;    
+    stream << "    } else {" << endl;
+    stream << "      f" << solv_ind_N << "(Q,R,x1+i*" << n << ",r0+i*" << n << ",iw,w);" << endl;    
+    stream << "    }" << endl;
     stream << "  }" << endl;
   }
 
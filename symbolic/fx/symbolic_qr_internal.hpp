@@ -57,6 +57,12 @@ namespace CasADi{
     /** \brief Generate code for the body of the C function */
     virtual void generateBody(std::ostream &stream, const std::string& type, CodeGenerator& gen) const;
 
+    /** \brief Get the length of the integer and real work vectors needed by the generated code */
+    virtual void workSizeCode(size_t& ni, size_t& nr) const;
+
+    /** \brief Get the length of the persistent part of the real work vector of the generated code: A, Q and R of the last factorization */
+    virtual size_t persistentSizeCode() const;
+
     // Factorization function
     FX fact_fcn_;
 
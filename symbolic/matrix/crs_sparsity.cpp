@@ -25,6 +25,9 @@
 #include "../matrix/matrix.hpp"
 #include "../stl_vector_tools.hpp"
 #include <climits>
+#ifdef WITH_THREADS
+#include <pthread.h>
+#endif // WITH_THREADS
 
 using namespace std;
 
@@ -64,7 +67,7 @@ namespace CasADi{
   }
  
   CRSSparsityInternal* CRSSparsity::operator->(){
-    makeUnique();
+    makeUniqueUncached();
     return (CRSSparsityInternal*)(SharedObject::operator->());
   }
 
@@ -109,12 +112,12 @@ namespace CasADi{
   }
     
   vector<int>& CRSSparsity::colRef(){
-    makeUnique();
+    makeUniqueUncached();
     return (*this)->col_;
   }
     
   vector<int>& CRSSparsity::rowindRef(){
-    makeUnique();
+    makeUniqueUncached();
     return (*this)->rowind_;
   }
     
@@ -131,7 +134,7 @@ namespace CasADi{
   }
     
   void CRSSparsity::resize(int nrow, int ncol){
-    makeUnique();
+    makeUniqueUncached();
     (*this)->resize(nrow,ncol);
   }
 
@@ -166,7 +169,7 @@ namespace CasADi{
     }
   
     // Make sure that there no other objects are affected
-    makeUnique();
+    makeUniqueUncached();
   
     // insert the element
     colRef().insert(colRef().begin()+ind,j);
@@ -247,7 +250,7 @@ namespace CasADi{
   }
 
   vector<int> CRSSparsity::erase(const vector<int>& ii, const vector<int>& jj){
-    makeUnique();
+    makeUniqueUncached();
     return (*this)->erase(ii,jj);
   }
 
@@ -340,13 +343,13 @@ namespace CasADi{
   }
 
   void CRSSparsity::reserve(int nnz, int nrow){
-    makeUnique();
+    makeUniqueUncached();
     (*this)->reserve(nnz,nrow);
   }
 
   void CRSSparsity::append(const CRSSparsity& sp){
     casadi_assert(this!=&sp); // NOTE: this case needs to be handled
-    makeUnique();
+    makeUniqueUncached();
     (*this)->append(sp);
   }
 
@@ -362,12 +365,12 @@ namespace CasADi{
   }
 
   void CRSSparsity::enlargeRows(int nrow, const std::vector<int>& ii){
-    makeUnique();
+    makeUniqueUncached();
     (*this)->enlargeRows(nrow,ii);
   }
 
   void CRSSparsity::enlargeColumns(int ncol, const std::vector<int>& jj){
-    makeUnique();
+    makeUniqueUncached();
     (*this)->enlargeColumns(ncol,jj);
   }
 
@@ -428,7 +431,7 @@ namespace CasADi{
   }
 
   void CRSSparsity::removeDuplicates(std::vector<int>& mapping){
-    makeUnique();
+    makeUniqueUncached();
     (*this)->removeDuplicates(mapping);
   }
 
@@ -487,94 +490,135 @@ namespace CasADi{
     return (*this)->hash();
   }
 
-  void CRSSparsity::assignCached(int nrow, int ncol, const std::vector<int>& col, const std::vector<int>& rowind){
-    // Hash the pattern
-    std::size_t h = hash_sparsity(nrow,ncol,col,rowind);
+  namespace{
+    /// Number of independently locked shards of the sparsity cache
+    const int CACHE_NUM_SHARDS = 64;
+
+    /// Multimap from hash key to the (non-owning) cached sparsity patterns
+    typedef CACHING_MULTIMAP<std::size_t,CRSSparsityInternal*> CachingMap;
+
+    /// A shard of the sparsity cache, patterns are assigned to shards according to their hash key
+    struct CacheShard{
+      CacheShard() : hits(0), misses(0){
+#ifdef WITH_THREADS
+        pthread_mutex_init(&mutex,0);
+#endif // WITH_THREADS
+      }
+
+      /// Cached patterns
+      CachingMap map;
+
+      /// Statistics
+      long hits, misses;
+
+#ifdef WITH_THREADS
+      /// Lock guarding the map, the statistics and the cached_ flag of all patterns in the shard
+      pthread_mutex_t mutex;
+#endif // WITH_THREADS
+    };
+
+    /// Get the shards. Allocated on first use and never freed, so that the cache outlives all (also static) patterns
+    CacheShard* cacheShards(){
+      static CacheShard* shards = new CacheShard[CACHE_NUM_SHARDS];
+      return shards;
+    }
+
+    /// Get the shard for a hash key
+    CacheShard& cacheShard(std::size_t key){
+      return cacheShards()[(key ^ (key >> 16)) % CACHE_NUM_SHARDS];
+    }
+
+    /// Scoped lock of a cache shard
+    class ShardLock{
+    public:
+#ifdef WITH_THREADS
+      explicit ShardLock(CacheShard& shard) : shard_(shard){ pthread_mutex_lock(&shard_.mutex);}
+      ~ShardLock(){ pthread_mutex_unlock(&shard_.mutex);}
+#else // WITH_THREADS
+      explicit ShardLock(CacheShard& shard) : shard_(shard){}
+#endif // WITH_THREADS
+    private:
+      CacheShard& shard_;
+    };
+
+    /// Remove a pattern from its shard, the shard must be locked
+    void removeFromShard(CacheShard& shard, CRSSparsityInternal* node){
+      if(!node->cached_) return;
+      pair<CachingMap::iterator,CachingMap::iterator> eq = shard.map.equal_range(node->cache_key_);
+      for(CachingMap::iterator i=eq.first; i!=eq.second; ++i){
+        if(i->second==node){
+          shard.map.erase(i);
+          break;
+        }
+      }
+      node->cached_ = false;
+    }
+  } // namespace
+
+  CRSSparsityInternal::~CRSSparsityInternal(){
+    // The reference count has reached zero, so the pattern can no longer be picked up from the cache, but the entry must go
+    if(cached_){
+      CacheShard& shard = cacheShard(cache_key_);
+      ShardLock lock(shard);
+      removeFromShard(shard,this);
+    }
+  }
+
+  void CRSSparsity::makeUniqueUncached(){
+    CRSSparsityInternal* node = static_cast<CRSSparsityInternal*>(get());
+
+    // Patterns that are not cached never become cached, so they can be handled by makeUnique
+    if(node!=0 && node->cached_){
+      CRSSparsityInternal* copy = 0;
+      {
+        CacheShard& shard = cacheShard(node->cache_key_);
+        ShardLock lock(shard);
+        if(node->cached_){
+          if(getCount()==1){
+            // No other thread can obtain a reference while the shard is locked, so the pattern can be modified once evicted
+            removeFromShard(shard,node);
+          } else {
+            // Shared with other references, which may be released at any time: always work on an uncached copy
+            copy = node->clone();
+          }
+        }
+      }
 
+      // Assign the copy after unlocking, releasing the last reference to the cached pattern locks the shard in its destructor
+      if(copy!=0){
+        assignNode(copy);
+        return;
+      }
+    }
+    makeUnique();
+  }
+
+  void CRSSparsity::assignCached(int nrow, int ncol, const std::vector<int>& col, const std::vector<int>& rowind){
     // Workaround: Disable caching for scalars and small empty matrices
     if(nrow<=1 && ncol<=1){
       assignNode(new CRSSparsityInternal(nrow, ncol, col, rowind));
       return;
     }
+
+    // Hash the pattern
+    std::size_t h = hash_sparsity(nrow,ncol,col,rowind);
     
-    // Record the current number of buckets (for garbage collection below)
-#ifdef USE_CXX11
-    int bucket_count_before = cached_.bucket_count();
-#endif // USE_CXX11
+    // Lock the shard
+    CacheShard& shard = cacheShard(h);
+    ShardLock lock(shard);
 
     // WORKAROUND, functions do not appear to work when bucket_count==0
 #ifdef USE_CXX11
-    if(bucket_count_before>0){
+    if(shard.map.bucket_count()>0){
 #endif // USE_CXX11
 
       // Find the range of patterns equal to the key (normally only zero or one)
-      pair<CachingMap::iterator,CachingMap::iterator> eq = cached_.equal_range(h);
+      pair<CachingMap::iterator,CachingMap::iterator> eq = shard.map.equal_range(h);
 
-      // Loop over maching patterns
+      // Loop over matching patterns, skipping hash collisions and patterns that are being destroyed by another thread
       for(CachingMap::iterator i=eq.first; i!=eq.second; ++i){
-      
-        // Get a weak reference to the cached sparsity pattern
-        WeakRef& wref = i->second;
-      
-        // Check if the pattern still exists
-        if(wref.alive()){
-        
-          // Get an owning reference to the cached pattern
-          CRSSparsity ref = shared_cast<CRSSparsity>(wref.shared());
-        
-          // Check if the pattern matches
-          if(ref.isEqual(nrow,ncol,col,rowind)){
-          
-            // Found match!
-            assignNode(ref.get());
-            return;
-
-          } else {
-            // There are two options, either the pattern has changed or there is a hash collision, so let's rehash the pattern
-            std::size_t h_ref = ref.hash();
-          
-            if(h_ref!=h){ // The sparsity pattern has changed (the most likely event)
-
-              // Create a new pattern
-              assignNode(new CRSSparsityInternal(nrow, ncol, col, rowind));
-
-              // Cache this pattern instead of the old one
-              wref = *this;
-
-              // Recache the old sparsity pattern 
-              // TODO: recache "ref"
-              return;
-
-            } else { // There is a hash colision (unlikely, but possible)
-              // Leave the pattern alone, continue to the next matching pattern
-              continue; 
-            }
-          }
-        } else {
-          // Check if one of the other cache entries indeed has a matching sparsity
-          CachingMap::iterator j=i;
-          j++; // Start at the next matching key
-          for(; j!=eq.second; ++j){
-            if(j->second.alive()){
-            
-              // Recover cached sparsity
-              CRSSparsity ref = shared_cast<CRSSparsity>(j->second.shared());
-            
-              // Match found if sparsity matches
-              if(ref.isEqual(nrow,ncol,col,rowind)){
-                assignNode(ref.get());
-                return;
-              }
-            }
-          }
-
-          // The cached entry has been deleted, create a new one
-          assignNode(new CRSSparsityInternal(nrow, ncol, col, rowind));
-        
-          // Cache this pattern
-          wref = *this;
-
-          // Return
+        if(i->second->isEqual(nrow,ncol,col,rowind) && assignNodeIfAlive(i->second)){
+          shard.hits++;
           return;
         }
       }
@@ -585,35 +629,56 @@ namespace CasADi{
 #endif // USE_CXX11
 
     // No matching sparsity pattern could be found, create a new one
-    assignNode(new CRSSparsityInternal(nrow, ncol, col, rowind));
+    CRSSparsityInternal* node = new CRSSparsityInternal(nrow, ncol, col, rowind);
+    assignNode(node);
 
     // Cache this pattern
-    //cached_.insert(eq.second,std::pair<std::size_t,WeakRef>(h,ret));
-    cached_.insert(std::pair<std::size_t,WeakRef>(h,*this));
+    shard.map.insert(std::pair<std::size_t,CRSSparsityInternal*>(h,node));
+    node->cached_ = true;
+    node->cache_key_ = h;
+    shard.misses++;
+  }
 
-    // Garbage collection (currently only supported for unordered_multimap)
-#ifdef USE_CXX11
-    int bucket_count_after = cached_.bucket_count();
-    
-    // We we increased the number of buckets, take time to garbage-collect deleted references
-    if(bucket_count_before!=bucket_count_after){
-      CachingMap::const_iterator i=cached_.begin();
-      while(i!=cached_.end()){
-        if(!i->second.alive()){
-          i = cached_.erase(i);
-        } else {
-          i++;
-        }
+  void CRSSparsity::clearCache(){
+    for(int k=0; k<CACHE_NUM_SHARDS; ++k){
+      CacheShard& shard = cacheShards()[k];
+      ShardLock lock(shard);
+      for(CachingMap::iterator i=shard.map.begin(); i!=shard.map.end(); ++i){
+        i->second->cached_ = false;
       }
+      shard.map.clear();
+      shard.hits = shard.misses = 0;
     }
-#endif // USE_CXX11    
   }
 
-  CRSSparsity::CachingMap CRSSparsity::cached_;
+  long CRSSparsity::cacheSize(){
+    long ret = 0;
+    for(int k=0; k<CACHE_NUM_SHARDS; ++k){
+      CacheShard& shard = cacheShards()[k];
+      ShardLock lock(shard);
+      ret += shard.map.size();
+    }
+    return ret;
+  }
 
-  void CRSSparsity::clearCache(){
-    cached_.clear();
+  long CRSSparsity::cacheHits(){
+    long ret = 0;
+    for(int k=0; k<CACHE_NUM_SHARDS; ++k){
+      CacheShard& shard = cacheShards()[k];
+      ShardLock lock(shard);
+      ret += shard.hits;
+    }
+    return ret;
   }
 
+  long CRSSparsity::cacheMisses(){
+    long ret = 0;
+    for(int k=0; k<CACHE_NUM_SHARDS; ++k){
+      CacheShard& shard = cacheShards()[k];
+      ShardLock lock(shard);
+      ret += shard.misses;
+    }
+    return ret;
+  }
 
 } // namespace CasADi
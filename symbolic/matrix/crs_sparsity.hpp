@@ -89,11 +89,6 @@ namespace CasADi{
    * \date 2010
    */
   class CRSSparsity : public SharedObject{
-  private:
-    /// Multimap holding all cached sparsity patterns (put first to ensure that it is initialized before being used)
-    typedef CACHING_MULTIMAP<std::size_t,WeakRef> CachingMap;
-    static CachingMap cached_;
-
   public:
   
     /// Default constructor
@@ -116,6 +111,15 @@ namespace CasADi{
     /** \brief Clear the cache */
     static void clearCache();
 
+    /** \brief Number of patterns currently held in the cache */
+    static long cacheSize();
+
+    /** \brief Number of constructions that were resolved to an existing pattern in the cache (since the last clearCache) */
+    static long cacheHits();
+
+    /** \brief Number of constructions that added a new pattern to the cache (since the last clearCache) */
+    static long cacheMisses();
+
     /** \brief Check if the dimensions and rowind,col vectors are compatible.
      * \param complete  set to true to also check elementwise
      * throws an error as possible result
@@ -468,28 +472,31 @@ namespace CasADi{
 #ifndef SWIG
     /** \brief Assign the nonzero entries of one sparsity pattern to the nonzero entries of another sparsity pattern */
     template<typename T>
-    void set(T* data, const T* val_data, CRSSparsity val_sp) const;
+    void set(T* data, const T* val_data, const CRSSparsity& val_sp) const;
 
     /** \brief Add the nonzero entries of one sparsity pattern to the nonzero entries of another sparsity pattern */
     template<typename T>
-    void add(T* data, const T* val_data, CRSSparsity val_sp) const;
+    void add(T* data, const T* val_data, const CRSSparsity& val_sp) const;
 
     /** \brief Bitwise or of the nonzero entries of one sparsity pattern and the nonzero entries of another sparsity pattern */
     template<typename T>
-    void bor(T* data, const T* val_data, CRSSparsity val_sp) const;
+    void bor(T* data, const T* val_data, const CRSSparsity& val_sp) const;
 
 
   private:
     /// Construct a sparsity pattern from vectors, reuse cached pattern if possible
     void assignCached(int nrow, int ncol, const std::vector<int>& col, const std::vector<int>& rowind);
 
+    /// Remove the pattern from the cache before it is modified in-place, or make a copy if it is still shared
+    void makeUniqueUncached();
+
 #endif //SWIG
   };
 
   // Template instantiations
 #ifndef SWIG
   template<typename T>
-  void CRSSparsity::set(T* data, const T* val_data, CRSSparsity val_sp) const{
+  void CRSSparsity::set(T* data, const T* val_data, const CRSSparsity& val_sp) const{
     // Get dimensions of this
     const int sz = size();
     const int sz1 = size1();
@@ -563,7 +570,7 @@ namespace CasADi{
   }
 
   template<typename T>
-  void CRSSparsity::add(T* data, const T* val_data, CRSSparsity val_sp) const{
+  void CRSSparsity::add(T* data, const T* val_data, const CRSSparsity& val_sp) const{
     // Get dimensions of this
     const int sz = size();
     const int sz1 = size1();
@@ -641,7 +648,7 @@ namespace CasADi{
   }
 
   template<typename T>
-  void CRSSparsity::bor(T* data, const T* val_data, CRSSparsity val_sp) const{
+  void CRSSparsity::bor(T* data, const T* val_data, const CRSSparsity& val_sp) const{
     // Get dimensions of this
     const int sz = size();
     const int sz1 = size1();
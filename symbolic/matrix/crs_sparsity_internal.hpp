@@ -30,7 +30,10 @@ namespace CasADi{
   class CRSSparsityInternal : public SharedObjectNode{
   public:    
     /// Construct a sparsity pattern from vectors
-    CRSSparsityInternal(int nrow, int ncol, const std::vector<int>& col, const std::vector<int>& rowind) : nrow_(nrow), ncol_(ncol), col_(col), rowind_(rowind) { sanityCheck(false); }
+    CRSSparsityInternal(int nrow, int ncol, const std::vector<int>& col, const std::vector<int>& rowind) : nrow_(nrow), ncol_(ncol), col_(col), rowind_(rowind), cached_(false) { sanityCheck(false); }
+
+    /// Destructor, removes the pattern from the cache (defined in crs_sparsity.cpp)
+    virtual ~CRSSparsityInternal();
     
     /// Check if the dimensions and rowind,col vectors are compatible
     void sanityCheck(bool complete=false) const;
@@ -237,7 +240,7 @@ namespace CasADi{
     std::size_t hash() const;
 
     /// Clone
-    virtual CRSSparsityInternal* clone() const{ return new CRSSparsityInternal(*this); }
+    virtual CRSSparsityInternal* clone() const{ return new CRSSparsityInternal(nrow_,ncol_,col_,rowind_); }
 
     /// Print representation
     virtual void repr(std::ostream &stream) const;
@@ -256,6 +259,12 @@ namespace CasADi{
     
     /// vector of length n+1 containing the index of the last non-zero element up till each row 
     std::vector<int> rowind_;
+
+    /// Is the pattern held in the sparsity cache (guarded by the lock of the cache shard)
+    bool cached_;
+
+    /// Hash key of the pattern in the sparsity cache
+    std::size_t cache_key_;
     
     /// Perform a unidirectional coloring: A greedy distance-2 coloring algorithm (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) 
     CRSSparsity unidirectionalColoring(const CRSSparsity& AT, int cutoff) const;
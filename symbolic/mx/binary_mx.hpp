@@ -60,6 +60,18 @@ namespace CasADi{
     /** \brief  Evaluate the function numerically */
     virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
 
+    /** \brief  Evaluate the function on arrays of nonzeros */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Can evaluateRaw be called concurrently? */
+    virtual bool isReentrant() const{ return true;}
+
+    /** \brief  Evaluate the function and forward directional derivatives on arrays of nonzeros */
+    virtual void evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w);
+
+    /** \brief  Propagate adjoint directional derivatives on arrays of nonzeros */
+    virtual void evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w);
+
     /** \brief  Evaluate the function symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
 
@@ -151,6 +151,50 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  template<bool ScX, bool ScY>
+  void BinaryMX<ScX,ScY>::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(!ScX && !ScY){
+      casadi_math<double>::fun(op_, arg[0], arg[1], res[0], size());
+    } else if(ScX){
+      casadi_math<double>::fun(op_, arg[0][0], arg[1], res[0], size());
+    } else {
+      casadi_math<double>::fun(op_, arg[0], arg[1][0], res[0], size());
+    }
+  }
+
+  template<bool ScX, bool ScY>
+  void BinaryMX<ScX,ScY>::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    const double *x = arg[0], *y = arg[1];
+    double* f = res[0];
+    double fk, pd[2];
+    for(int k=0; k<size(); ++k){
+      int kx = ScX ? 0 : k, ky = ScY ? 0 : k;
+      casadi_math<double>::fun(op_,x[kx],y[ky],fk);
+      casadi_math<double>::der(op_,x[kx],y[ky],fk,pd);
+      for(int d=0; d<nfwd; ++d){
+        fsens[d][k] = pd[0]*fseed[2*d][kx] + pd[1]*fseed[2*d+1][ky];
+      }
+      f[k] = fk;
+    }
+  }
+
+  template<bool ScX, bool ScY>
+  void BinaryMX<ScX,ScY>::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    const double *x = arg[0], *y = arg[1];
+    double fk, pd[2];
+    for(int k=0; k<size(); ++k){
+      int kx = ScX ? 0 : k, ky = ScY ? 0 : k;
+      casadi_math<double>::fun(op_,x[kx],y[ky],fk);
+      casadi_math<double>::der(op_,x[kx],y[ky],fk,pd);
+      for(int d=0; d<nadj; ++d){
+        double s = aseed[d][k];
+        aseed[d][k] = 0;
+        asens[2*d][kx] += s*pd[0];
+        asens[2*d+1][ky] += s*pd[1];
+      }
+    }
+  }
+
   template<bool ScX, bool ScY>
   void BinaryMX<ScX,ScY>::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
@@ -62,6 +62,22 @@ namespace CasADi {
     fcn_->evaluateD(this,arg,res,fseed,fsens,aseed,asens,itmp,rtmp);
   }
 
+  void CallFX::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    fcn_->evaluateRaw(this,arg,res,iw,w);
+  }
+
+  void CallFX::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    fcn_->evaluateFwdRaw(this,arg,res,fseed,fsens,nfwd);
+  }
+
+  void CallFX::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    fcn_->evaluateAdjRaw(this,arg,aseed,asens,nadj);
+  }
+
+  bool CallFX::isReentrant() const{
+    return fcn_.isReentrant();
+  }
+
   int CallFX::getNumOutputs() const {
     return fcn_.getNumOutputs();
   }
@@ -47,6 +47,19 @@ namespace CasADi{
     }
   }
 
+  void ConstantMX::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    evaluateRaw(arg,res,iw,w);
+    for(int d=0; d<nfwd; ++d){
+      std::fill(fsens[d],fsens[d]+size(),0.);
+    }
+  }
+
+  void ConstantMX::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      std::fill(aseed[d],aseed[d]+size(),0.);
+    }
+  }
+
   void ConstantMX::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
   }
 
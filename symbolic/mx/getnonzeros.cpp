@@ -41,6 +41,31 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void GetNonzerosVector::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    const double* idata = arg[0];
+    double* odata = res[0];
+    for(vector<int>::const_iterator k=nz_.begin(); k!=nz_.end(); ++k){
+      *odata++ = *k>=0 ? idata[*k] : 0;
+    }
+  }
+
+  void GetNonzerosVector::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void GetNonzerosVector::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* aseed_ptr = aseed[d];
+      double* asens_d = asens[d];
+      for(vector<int>::const_iterator k=nz_.begin(); k!=nz_.end(); ++k){
+        if(*k>=0) asens_d[*k] += *aseed_ptr;
+        *aseed_ptr++ = 0;
+      }
+    }
+  }
+
   void GetNonzerosVector::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
@@ -83,6 +108,33 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void GetNonzerosSlice::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    const double* idata_ptr = arg[0] + s_.start_;
+    const double* idata_stop = arg[0] + s_.stop_;
+    double* odata_ptr = res[0];
+    for(; idata_ptr != idata_stop; idata_ptr += s_.step_){
+      *odata_ptr++ = *idata_ptr;
+    }
+  }
+
+  void GetNonzerosSlice::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void GetNonzerosSlice::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* asens_ptr = asens[d] + s_.start_;
+      double* asens_stop = asens[d] + s_.stop_;
+      double* aseed_ptr = aseed[d];
+      for(; asens_ptr != asens_stop; asens_ptr += s_.step_){
+        *asens_ptr += *aseed_ptr;
+        *aseed_ptr++ = 0;
+      }
+    }
+  }
+
   void GetNonzerosSlice::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
@@ -131,6 +183,37 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void GetNonzerosSlice2::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    const double* outer_ptr = arg[0] + outer_.start_;
+    const double* outer_stop = arg[0] + outer_.stop_;
+    double* odata_ptr = res[0];
+    for(; outer_ptr != outer_stop; outer_ptr += outer_.step_){
+      for(const double* inner_ptr = outer_ptr+inner_.start_; inner_ptr != outer_ptr+inner_.stop_; inner_ptr += inner_.step_){
+        *odata_ptr++ = *inner_ptr;
+      }
+    }
+  }
+
+  void GetNonzerosSlice2::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void GetNonzerosSlice2::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* outer_ptr = asens[d] + outer_.start_;
+      double* outer_stop = asens[d] + outer_.stop_;
+      double* aseed_ptr = aseed[d];
+      for(; outer_ptr != outer_stop; outer_ptr += outer_.step_){
+        for(double* inner_ptr = outer_ptr+inner_.start_; inner_ptr != outer_ptr+inner_.stop_; inner_ptr += inner_.step_){
+          *inner_ptr += *aseed_ptr;
+          *aseed_ptr++ = 0;
+        }
+      }
+    }
+  }
+
   void GetNonzerosSlice2::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
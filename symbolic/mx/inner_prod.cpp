@@ -70,6 +70,28 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void InnerProd::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    res[0][0] = casadi_dot(dep(0).size(),arg[0],1,arg[1],1);
+  }
+
+  void InnerProd::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    const int n = dep(0).size();
+    res[0][0] = casadi_dot(n,arg[0],1,arg[1],1);
+    for(int d=0; d<nfwd; ++d){
+      fsens[d][0] = casadi_dot(n,fseed[2*d],1,arg[1],1) + casadi_dot(n,arg[0],1,fseed[2*d+1],1);
+    }
+  }
+
+  void InnerProd::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    const int n = dep(0).size();
+    for(int d=0; d<nadj; ++d){
+      double s = aseed[d][0];
+      aseed[d][0] = 0;
+      casadi_axpy(n,s,arg[1],1,asens[2*d],1);
+      casadi_axpy(n,s,arg[0],1,asens[2*d+1],1);
+    }
+  }
+
   void InnerProd::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
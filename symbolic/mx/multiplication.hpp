@@ -56,6 +56,27 @@ namespace CasADi{
     /// Evaluate the function numerically
     virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
 
+    /** \brief  Evaluate the function on arrays of nonzeros */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Can evaluateRaw be called concurrently? */
+    virtual bool isReentrant() const{ return true;}
+
+    /** \brief  Evaluate the function and forward directional derivatives on arrays of nonzeros */
+    virtual void evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w);
+
+    /** \brief  Propagate adjoint directional derivatives on arrays of nonzeros */
+    virtual void evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w);
+
+    /// Add x*trans(y) to z, nonzeros with the sparsity patterns of dep(1), dep(2) and the result
+    virtual void mul_nt_raw(const double* x, const double* y, double* z) const;
+
+    /// Add z*y to x, nonzeros with the sparsity patterns of the result, dep(2) and dep(1)
+    virtual void mul_nn_raw(const double* z, const double* y, double* x) const;
+
+    /// Add trans(z)*x to y, nonzeros with the sparsity patterns of the result, dep(1) and dep(2)
+    virtual void mul_tn_raw(const double* z, const double* x, double* y) const;
+
     /// Evaluate the function symbolically (SX)
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
 
@@ -97,6 +118,15 @@ namespace CasADi{
     /** \brief  Clone function */
     virtual DenseMultiplication* clone() const{ return new DenseMultiplication(*this);}
 
+    /// Add x*trans(y) to z, dense nonzeros
+    virtual void mul_nt_raw(const double* x, const double* y, double* z) const;
+
+    /// Add z*y to x, dense nonzeros
+    virtual void mul_nn_raw(const double* z, const double* y, double* x) const;
+
+    /// Add trans(z)*x to y, dense nonzeros
+    virtual void mul_tn_raw(const double* z, const double* x, double* y) const;
+
     /** \brief Generate code for the operation */
     virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
   };
@@ -63,6 +63,185 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(arg[0]!=res[0]){
+      copy(arg[0],arg[0]+this->size(),res[0]);
+    }
+    mul_nt_raw(arg[1],arg[2],res[0]);
+  }
+
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    evaluateRaw(arg,res,iw,w);
+
+    // Forward sensitivities: dot(Z) = dot(X)*Y + X*dot(Y)
+    for(int d=0; d<nfwd; ++d){
+      const double** s = fseed + 3*d;
+      if(s[0]!=fsens[d]){
+        copy(s[0],s[0]+this->size(),fsens[d]);
+      }
+      mul_nt_raw(s[1],arg[2],fsens[d]);
+      mul_nt_raw(arg[1],s[2],fsens[d]);
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* s = aseed[d];
+      double** a = asens + 3*d;
+      mul_nn_raw(s,arg[2],a[1]);
+      mul_tn_raw(s,arg[1],a[2]);
+      if(s!=a[0]){
+        for(int k=0; k<this->size(); ++k){
+          a[0][k] += s[k];
+          s[k] = 0;
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::mul_nt_raw(const double* x, const double* y, double* z) const{
+    // Sparsity patterns
+    const vector<int> &x_rowind = this->dep(1).sparsity().rowind();
+    const vector<int> &x_col = this->dep(1).sparsity().col();
+    const vector<int> &y_colind = this->dep(2).sparsity().rowind();
+    const vector<int> &y_row = this->dep(2).sparsity().col();
+    const vector<int> &z_rowind = this->sparsity().rowind();
+    const vector<int> &z_col = this->sparsity().col();
+    
+    // loop over the rows of the resulting matrix
+    for(int i=0; i<z_rowind.size()-1; ++i){
+      for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){ // loop over the non-zeros of the resulting matrix
+        int j = z_col[el];
+        int el1 = x_rowind[i];
+        int el2 = y_colind[j];
+        while(el1 < x_rowind[i+1] && el2 < y_colind[j+1]){ // loop over non-zero elements
+          int j1 = x_col[el1];
+          int i2 = y_row[el2];      
+          if(j1==i2){
+            z[el] += x[el1++] * y[el2++];
+          } else if(j1<i2) {
+            el1++;
+          } else {
+            el2++;
+          }
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::mul_nn_raw(const double* z, const double* y, double* x) const{
+    // Sparsity patterns
+    const vector<int> &z_rowind = this->sparsity().rowind();
+    const vector<int> &z_col = this->sparsity().col();
+    const vector<int> &y_rowind = this->dep(2).sparsity().rowind();
+    const vector<int> &y_col = this->dep(2).sparsity().col();
+    const vector<int> &x_rowind = this->dep(1).sparsity().rowind();
+    const vector<int> &x_col = this->dep(1).sparsity().col();
+
+    // loop over the rows of z
+    for(int i=0; i<z_rowind.size()-1; ++i){
+      for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){ // loop over the non-zeros of z
+        int j = z_col[el];
+        int el1 = x_rowind[i];
+        int el2 = y_rowind[j];
+        while(el1 < x_rowind[i+1] && el2 < y_rowind[j+1]){ // loop over matching non-zero elements
+          int j1 = x_col[el1];
+          int i2 = y_col[el2];      
+          if(j1==i2){
+            x[el1++] += z[el]*y[el2++];
+          } else if(j1<i2) {
+            el1++;
+          } else {
+            el2++;
+          }
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void Multiplication<TrX,TrY>::mul_tn_raw(const double* z, const double* x, double* y) const{
+    // Sparsity patterns
+    const vector<int> &z_rowind = this->sparsity().rowind();
+    const vector<int> &z_col = this->sparsity().col();
+    const vector<int> &x_rowind = this->dep(1).sparsity().rowind();
+    const vector<int> &x_col = this->dep(1).sparsity().col();
+    const vector<int> &y_rowind = this->dep(2).sparsity().rowind();
+    const vector<int> &y_col = this->dep(2).sparsity().col();
+
+    // loop over the rows of z
+    for(int i=0; i<z_rowind.size()-1; ++i){
+      for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){ // loop over the non-zeros of z
+        int j = z_col[el];
+        int el1 = x_rowind[i];
+        int el2 = y_rowind[j];
+        while(el1 < x_rowind[i+1] && el2 < y_rowind[j+1]){ // loop over matching non-zero elements
+          int j1 = x_col[el1];
+          int i2 = y_col[el2];      
+          if(j1==i2){
+            y[el2++] += z[el]*x[el1++];
+          } else if(j1<i2) {
+            el1++;
+          } else {
+            el2++;
+          }
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void DenseMultiplication<TrX,TrY>::mul_nt_raw(const double* x, const double* y, double* z) const{
+    int nrow_x = this->dep(1).size1();
+    int ncol_x = this->dep(1).size2();
+    int nrow_y = this->dep(2).size1();
+    for(int i=0; i<nrow_x; ++i){
+      for(int j=0; j<nrow_y; ++j, ++z){
+        const double *ss = x+i*ncol_x, *tt = y+j*ncol_x;
+        for(int k=0; k<ncol_x; ++k){
+          *z += *ss++ * *tt++;
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void DenseMultiplication<TrX,TrY>::mul_nn_raw(const double* z, const double* y, double* x) const{
+    int nrow_x = this->dep(1).size1();
+    int ncol_x = this->dep(1).size2();
+    int nrow_y = this->dep(2).size1();
+    for(int i=0; i<nrow_x; ++i){
+      for(int j=0; j<nrow_y; ++j, ++z){
+        double *ss = x+i*ncol_x;
+        const double *tt = y+j*ncol_x;
+        for(int k=0; k<ncol_x; ++k){
+          *ss++ += *z * *tt++;
+        }
+      }
+    }
+  }
+
+  template<bool TrX, bool TrY>
+  void DenseMultiplication<TrX,TrY>::mul_tn_raw(const double* z, const double* x, double* y) const{
+    int nrow_x = this->dep(1).size1();
+    int ncol_x = this->dep(1).size2();
+    int nrow_y = this->dep(2).size1();
+    for(int i=0; i<nrow_x; ++i){
+      for(int j=0; j<nrow_y; ++j, ++z){
+        const double *ss = x+i*ncol_x;
+        double *tt = y+j*ncol_x;
+        for(int k=0; k<ncol_x; ++k){
+          *tt++ += *z * *ss++;
+        }
+      }
+    }
+  }
+
   template<bool TrX, bool TrY>
   void Multiplication<TrX,TrY>::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
@@ -816,6 +816,8 @@ namespace CasADi{
   MX MX::__mpower__(const MX& b) const   { return pow(*this,b); throw CasadiException("mpower: Not implemented");}
 
   void MX::append(const MX& y){
+    // Appending an empty matrix must not replace e.g. an empty symbolic primitive with a null expression
+    if(!isNull() && (y.isNull() || y.empty())) return;
     *this = vertcat(*this,y);
   }
 
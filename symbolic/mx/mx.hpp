@@ -389,7 +389,9 @@ namespace CasADi{
     void setNZ(const Slice& k, const MX& m){ setNZ(k.getAll(size()),m);}
     void setNZ(const Matrix<int>& k, const MX& m);
 
-    /** \brief Append a matrix to the end. */
+    /** \brief Append a matrix to the end.
+     * Appending a null or empty matrix leaves a non-null expression unchanged,
+     * appending to a null expression gives y. */
     void append(const MX& y);
   
     // all binary operations
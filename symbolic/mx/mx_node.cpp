@@ -254,6 +254,156 @@ namespace CasADi{
     evaluateD(input,output,fwdSeed, fwdSens, adjSeed, adjSens, itmp, rtmp);
   }
   
+  void MXNode::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    // Wrap the nonzeros in matrices
+    vector<DMatrix> argm(ndep()), resm(getNumOutputs());
+    DMatrixPtrV input(argm.size(),0), output(resm.size(),0);
+    for(int i=0; i<argm.size(); ++i){
+      if(arg[i]!=0){
+        argm[i] = DMatrix(dep(i).sparsity(),0);
+        copy(arg[i],arg[i]+argm[i].size(),argm[i].begin());
+        input[i] = &argm[i];
+      }
+    }
+    for(int i=0; i<resm.size(); ++i){
+      if(res[i]!=0){
+        resm[i] = DMatrix(sparsity(i),0);
+        output[i] = &resm[i];
+      }
+    }
+
+    // Evaluate
+    size_t ni, nr;
+    nTmp(ni,nr);
+    vector<int> itmp(ni);
+    vector<double> rtmp(nr);
+    evaluateD(input,output,itmp,rtmp);
+
+    // Get the results
+    for(int i=0; i<resm.size(); ++i){
+      if(res[i]!=0){
+        copy(resm[i].begin(),resm[i].end(),res[i]);
+      }
+    }
+  }
+  
+  void MXNode::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    int n_in = ndep(), n_out = getNumOutputs();
+
+    // Wrap the nonzeros of the arguments and forward seeds in matrices
+    vector<DMatrix> argm(n_in*(1+nfwd)), resm(n_out*(1+nfwd));
+    DMatrixPtrV input(n_in,0), output(n_out,0);
+    DMatrixPtrVV fwdSeed(nfwd,DMatrixPtrV(n_in,0)), fwdSens(nfwd,DMatrixPtrV(n_out,0)), adjSeed, adjSens;
+    for(int d=-1; d<nfwd; ++d){
+      const double** a = d<0 ? arg : fseed + d*n_in;
+      DMatrixPtrV& am = d<0 ? input : fwdSeed[d];
+      for(int i=0; i<n_in; ++i){
+        if(a[i]!=0){
+          DMatrix& m = argm[(d+1)*n_in+i];
+          m = DMatrix(dep(i).sparsity(),0);
+          copy(a[i],a[i]+m.size(),m.begin());
+          am[i] = &m;
+        }
+      }
+      double** r = d<0 ? res : fsens + d*n_out;
+      DMatrixPtrV& rm = d<0 ? output : fwdSens[d];
+      for(int i=0; i<n_out; ++i){
+        if(r[i]!=0){
+          DMatrix& m = resm[(d+1)*n_out+i];
+          m = DMatrix(sparsity(i),0);
+          rm[i] = &m;
+        }
+      }
+    }
+
+    // Evaluate
+    size_t ni, nr;
+    nTmp(ni,nr);
+    vector<int> itmp(ni);
+    vector<double> rtmp(nr);
+    evaluateD(input,output,fwdSeed,fwdSens,adjSeed,adjSens,itmp,rtmp);
+
+    // Get the results and forward sensitivities
+    for(int d=-1; d<nfwd; ++d){
+      double** r = d<0 ? res : fsens + d*n_out;
+      for(int i=0; i<n_out; ++i){
+        if(r[i]!=0){
+          const DMatrix& m = resm[(d+1)*n_out+i];
+          copy(m.begin(),m.end(),r[i]);
+        }
+      }
+    }
+  }
+
+  void MXNode::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    int n_in = ndep(), n_out = getNumOutputs();
+
+    // Wrap the nonzeros of the arguments in matrices, the outputs are recalculated
+    vector<DMatrix> argm(n_in), resm(n_out);
+    DMatrixPtrV input(n_in,0), output(n_out,0);
+    for(int i=0; i<n_in; ++i){
+      if(arg[i]!=0){
+        argm[i] = DMatrix(dep(i).sparsity(),0);
+        copy(arg[i],arg[i]+argm[i].size(),argm[i].begin());
+        input[i] = &argm[i];
+      }
+    }
+    for(int i=0; i<n_out; ++i){
+      resm[i] = DMatrix(sparsity(i),0);
+      output[i] = &resm[i];
+    }
+
+    // Wrap the adjoint seeds and sensitivities
+    vector<DMatrix> aseedm(n_out*nadj), asensm(n_in*nadj);
+    DMatrixPtrVV fwdSeed, fwdSens, adjSeed(nadj,DMatrixPtrV(n_out,0)), adjSens(nadj,DMatrixPtrV(n_in,0));
+    for(int d=0; d<nadj; ++d){
+      double** s = aseed + d*n_out;
+      for(int i=0; i<n_out; ++i){
+        if(s[i]!=0){
+          DMatrix& m = aseedm[d*n_out+i];
+          m = DMatrix(sparsity(i),0);
+          copy(s[i],s[i]+m.size(),m.begin());
+          adjSeed[d][i] = &m;
+        }
+      }
+      double** a = asens + d*n_in;
+      for(int i=0; i<n_in; ++i){
+        if(a[i]!=0){
+          DMatrix& m = asensm[d*n_in+i];
+          m = DMatrix(dep(i).sparsity(),0);
+          if(find(s,s+n_out,a[i])==s+n_out){
+            copy(a[i],a[i]+m.size(),m.begin());
+          }
+          adjSens[d][i] = &m;
+        }
+      }
+    }
+
+    // Evaluate
+    size_t ni, nr;
+    nTmp(ni,nr);
+    vector<int> itmp(ni);
+    vector<double> rtmp(nr);
+    evaluateD(input,output,fwdSeed,fwdSens,adjSeed,adjSens,itmp,rtmp);
+
+    // Clear the seeds before getting the sensitivities, since they may share memory
+    for(int d=0; d<nadj; ++d){
+      for(int i=0; i<n_out; ++i){
+        double* s = aseed[d*n_out+i];
+        if(s!=0) std::fill(s,s+sparsity(i).size(),0.);
+      }
+    }
+    for(int d=0; d<nadj; ++d){
+      for(int i=0; i<n_in; ++i){
+        double* a = asens[d*n_in+i];
+        if(a!=0){
+          const DMatrix& m = asensm[d*n_in+i];
+          copy(m.begin(),m.end(),a);
+        }
+      }
+    }
+  }
+
   void MXNode::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, 
                          const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, 
                          const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
@@ -135,6 +135,26 @@ namespace CasADi{
     /** \brief  Evaluate the function, no derivatives*/
     void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, std::vector<int>& itmp, std::vector<double>& rtmp);
 
+    /** \brief  Evaluate the function on arrays of nonzeros, no derivatives
+        arg and res hold pointers to the nonzeros of the dependencies and the outputs, null if missing or not needed.
+        They may point to the same memory for the first numInplace() arguments. iw and w are work arrays of at least 
+        the lengths given by nTmp. The default implementation goes through evaluateD and is not reentrant. */
+    virtual void evaluateRaw(const double** arg, double** res, int* iw, double* w);
+
+    /** \brief  Can evaluateRaw be called concurrently? */
+    virtual bool isReentrant() const{ return false;}
+
+    /** \brief  Evaluate the function and nfwd forward directional derivatives on arrays of nonzeros
+        The seeds and sensitivities of direction d are found at fseed[d*ndep()+i] and fsens[d*getNumOutputs()+i]
+        and may share memory in the same way as arg and res. The default implementation goes through evaluateD. */
+    virtual void evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w);
+
+    /** \brief  Propagate nadj adjoint directional derivatives backwards on arrays of nonzeros
+        arg holds the nonzeros of the dependencies. The adjoint seeds aseed[d*getNumOutputs()+i] are cleared and 
+        their contributions added to the sensitivities asens[d*ndep()+i]. A sensitivity sharing memory with a seed 
+        (inplace operation) is implicitly zero on entry. The default implementation goes through evaluateD. */
+    virtual void evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w);
+
     /** \brief  Evaluate symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, 
                             const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, 
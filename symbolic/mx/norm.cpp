@@ -44,6 +44,29 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void NormF::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    res[0][0] = sqrt(casadi_dot(dep().size(),arg[0],1,arg[0],1));
+  }
+
+  void NormF::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    const int n = dep().size();
+    double r = sqrt(casadi_dot(n,arg[0],1,arg[0],1));
+    for(int d=0; d<nfwd; ++d){
+      fsens[d][0] = casadi_dot(n,fseed[d],1,arg[0],1) / r;
+    }
+    res[0][0] = r;
+  }
+
+  void NormF::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    const int n = dep().size();
+    double r = sqrt(casadi_dot(n,arg[0],1,arg[0],1));
+    for(int d=0; d<nadj; ++d){
+      double s = aseed[d][0];
+      aseed[d][0] = 0;
+      casadi_axpy(n,s/r,arg[0],1,asens[d],1);
+    }
+  }
+
   void NormF::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
@@ -46,6 +46,29 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void Reshape::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(arg[0]!=res[0]){
+      copy(arg[0],arg[0]+size(),res[0]);
+    }
+  }
+
+  void Reshape::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void Reshape::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      // Nothing to do if inplace
+      if(aseed[d]==asens[d]) continue;
+      for(int k=0; k<size(); ++k){
+        asens[d][k] += aseed[d][k];
+        aseed[d][k] = 0;
+      }
+    }
+  }
+
   void Reshape::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
@@ -72,6 +72,23 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void SetSparse::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    sparsity().set(res[0],arg[0],dep().sparsity());
+  }
+
+  void SetSparse::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void SetSparse::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      dep().sparsity().add(asens[d],aseed[d],sparsity());
+      std::fill(aseed[d],aseed[d]+size(),0.);
+    }
+  }
+
   void SetSparse::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
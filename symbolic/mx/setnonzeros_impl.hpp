@@ -267,6 +267,50 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  template<bool Add>
+  void SetNonzerosVector<Add>::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    double* odata = res[0];
+    if(arg[0]!=odata){
+      copy(arg[0],arg[0]+this->size(),odata);
+    }
+    const double* idata = arg[1];
+    for(vector<int>::const_iterator k=this->nz_.begin(); k!=this->nz_.end(); ++k, ++idata){
+      if(Add){
+        if(*k>=0) odata[*k] += *idata;
+      } else {
+        if(*k>=0) odata[*k] = *idata;
+      }
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosVector<Add>::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+2*d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosVector<Add>::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* aseed_d = aseed[d];
+      double* asens_ptr = asens[2*d+1];
+      for(vector<int>::const_iterator k=this->nz_.begin(); k!=this->nz_.end(); ++k, ++asens_ptr){
+        if(*k>=0){
+          *asens_ptr += aseed_d[*k];
+          if(!Add) aseed_d[*k] = 0;
+        }
+      }
+      if(aseed[d]!=asens[2*d]){
+        double* asens0 = asens[2*d];
+        for(int k=0; k<this->size(); ++k){
+          asens0[k] += aseed[d][k];
+          aseed[d][k] = 0;
+        }
+      }
+    }
+  }
+
   template<bool Add>
   void SetNonzerosVector<Add>::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
@@ -335,6 +379,50 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  template<bool Add>
+  void SetNonzerosSlice<Add>::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(arg[0]!=res[0]){
+      copy(arg[0],arg[0]+this->size(),res[0]);
+    }
+    const double* idata_ptr = arg[1];
+    double* odata_ptr = res[0] + s_.start_;
+    double* odata_stop = res[0] + s_.stop_;
+    for(; odata_ptr != odata_stop; odata_ptr += s_.step_){
+      if(Add){
+        *odata_ptr += *idata_ptr++;
+      } else {
+        *odata_ptr = *idata_ptr++;
+      }
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosSlice<Add>::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+2*d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosSlice<Add>::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* asens_ptr = asens[2*d+1];
+      double* aseed_ptr = aseed[d] + s_.start_;
+      double* aseed_stop = aseed[d] + s_.stop_;
+      for(; aseed_ptr != aseed_stop; aseed_ptr += s_.step_){
+        *asens_ptr++ += *aseed_ptr;
+        if(!Add) *aseed_ptr = 0;
+      }
+      if(aseed[d]!=asens[2*d]){
+        double* asens0 = asens[2*d];
+        for(int k=0; k<this->size(); ++k){
+          asens0[k] += aseed[d][k];
+          aseed[d][k] = 0;
+        }
+      }
+    }
+  }
+
   template<bool Add>
   void SetNonzerosSlice<Add>::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
@@ -410,6 +498,54 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  template<bool Add>
+  void SetNonzerosSlice2<Add>::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    if(arg[0]!=res[0]){
+      copy(arg[0],arg[0]+this->size(),res[0]);
+    }
+    const double* idata_ptr = arg[1];
+    double* outer_ptr = res[0] + outer_.start_;
+    double* outer_stop = res[0] + outer_.stop_;
+    for(; outer_ptr != outer_stop; outer_ptr += outer_.step_){
+      for(double* inner_ptr = outer_ptr+inner_.start_; inner_ptr != outer_ptr+inner_.stop_; inner_ptr += inner_.step_){
+        if(Add){
+          *inner_ptr += *idata_ptr++;
+        } else {
+          *inner_ptr = *idata_ptr++;
+        }
+      }
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosSlice2<Add>::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+2*d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  template<bool Add>
+  void SetNonzerosSlice2<Add>::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* asens_ptr = asens[2*d+1];
+      double* outer_ptr = aseed[d] + outer_.start_;
+      double* outer_stop = aseed[d] + outer_.stop_;
+      for(; outer_ptr != outer_stop; outer_ptr += outer_.step_){
+        for(double* inner_ptr = outer_ptr+inner_.start_; inner_ptr != outer_ptr+inner_.stop_; inner_ptr += inner_.step_){
+          *asens_ptr++ += *inner_ptr;
+          if(!Add) *inner_ptr = 0;
+        }
+      }
+      if(aseed[d]!=asens[2*d]){
+        double* asens0 = asens[2*d];
+        for(int k=0; k<this->size(); ++k){
+          asens0[k] += aseed[d][k];
+          aseed[d][k] = 0;
+        }
+      }
+    }
+  }
+
   template<bool Add>
   void SetNonzerosSlice2<Add>::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
@@ -42,6 +42,71 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens,itmp,rtmp);
   }
 
+  void Transpose::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    const vector<int>& x_col = dep().sparsity().col();
+    const vector<int>& xT_rowind = sparsity().rowind();
+    const double* x = arg[0];
+    double* xT = res[0];
+    copy(xT_rowind.begin(),xT_rowind.end(),iw);
+    for(int el=0; el<x_col.size(); ++el){
+      xT[iw[x_col[el]]++] = x[el];
+    }
+  }
+
+  void DenseTranspose::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    int x_nrow = dep().size1();
+    int x_ncol = dep().size2();
+    const double* x = arg[0];
+    double* xT = res[0];
+    for(int i=0; i<x_nrow; ++i){
+      for(int j=0; j<x_ncol; ++j){
+        xT[i+j*x_nrow] = x[j+i*x_ncol];
+      }
+    }
+  }
+
+  void Transpose::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void Transpose::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    const vector<int>& x_col = dep().sparsity().col();
+    const vector<int>& xT_rowind = sparsity().rowind();
+    for(int d=0; d<nadj; ++d){
+      double* x = asens[d];
+      double* xT = aseed[d];
+      copy(xT_rowind.begin(),xT_rowind.end(),iw);
+      for(int el=0; el<x_col.size(); ++el){
+        int elT = iw[x_col[el]]++;
+        x[el] += xT[elT];
+        xT[elT] = 0;
+      }
+    }
+  }
+
+  void DenseTranspose::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void DenseTranspose::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    int x_nrow = dep().size1();
+    int x_ncol = dep().size2();
+    for(int d=0; d<nadj; ++d){
+      double* x = asens[d];
+      double* xT = aseed[d];
+      for(int i=0; i<x_nrow; ++i){
+        for(int j=0; j<x_ncol; ++j){
+          x[j+i*x_ncol] += xT[i+j*x_nrow];
+          xT[i+j*x_nrow] = 0;
+        }
+      }
+    }
+  }
+
   void Transpose::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<SX>& rtmp){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens,itmp,rtmp);
   }
@@ -89,6 +89,45 @@ namespace CasADi{
     }
   }
 
+  void UnaryMX::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    double nan = numeric_limits<double>::quiet_NaN();
+    const double* x = arg[0];
+    double* f = res[0];
+    for(int i=0; i<size(); ++i){
+      casadi_math<double>::fun(op_,x[i],nan,f[i]);
+    }
+  }
+
+  void UnaryMX::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    double nan = numeric_limits<double>::quiet_NaN();
+    const double* x = arg[0];
+    double* f = res[0];
+    double fk, pd[2];
+    for(int k=0; k<size(); ++k){
+      casadi_math<double>::fun(op_,x[k],nan,fk);
+      casadi_math<double>::der(op_,x[k],nan,fk,pd);
+      f[k] = fk;
+      for(int d=0; d<nfwd; ++d){
+        fsens[d][k] = pd[0]*fseed[d][k];
+      }
+    }
+  }
+
+  void UnaryMX::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    double nan = numeric_limits<double>::quiet_NaN();
+    const double* x = arg[0];
+    double fk, pd[2];
+    for(int k=0; k<size(); ++k){
+      casadi_math<double>::fun(op_,x[k],nan,fk);
+      casadi_math<double>::der(op_,x[k],nan,fk,pd);
+      for(int d=0; d<nadj; ++d){
+        double s = aseed[d][k];
+        aseed[d][k] = 0;
+        asens[d][k] += s*pd[0];
+      }
+    }
+  }
+
   void UnaryMX::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     // Do the operation on all non-zero elements
     const vector<SX> &xd = input[0]->data();
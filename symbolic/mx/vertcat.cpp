@@ -53,6 +53,35 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void Vertcat::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    double* res_ptr = res[0];
+    for(int i=0; i<ndep(); ++i){
+      int n = dep(i).size();
+      copy(arg[i],arg[i]+n,res_ptr);
+      res_ptr += n;
+    }
+  }
+
+  void Vertcat::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d*ndep(), d<0 ? res : fsens+d, iw, w);
+    }
+  }
+
+  void Vertcat::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    for(int d=0; d<nadj; ++d){
+      double* aseed_ptr = aseed[d];
+      for(int i=0; i<ndep(); ++i){
+        double* asens_i = asens[d*ndep()+i];
+        int n = dep(i).size();
+        for(int k=0; k<n; ++k){
+          asens_i[k] += *aseed_ptr;
+          *aseed_ptr++ = 0;
+        }
+      }
+    }
+  }
+
   void Vertcat::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
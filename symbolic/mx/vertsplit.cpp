@@ -80,6 +80,43 @@ namespace CasADi{
     evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
 
+  void Vertsplit::evaluateRaw(const double** arg, double** res, int* iw, double* w){
+    int nx = offset_.size()-1;
+    const vector<int>& x_rowind = dep().sparsity().rowind();
+    for(int i=0; i<nx; ++i){
+      int nz_first = x_rowind[offset_[i]];
+      int nz_last = x_rowind[offset_[i+1]];
+      if(res[i]!=0){
+        copy(arg[0]+nz_first, arg[0]+nz_last, res[i]);
+      }
+    }
+  }
+
+  void Vertsplit::evaluateFwdRaw(const double** arg, double** res, const double** fseed, double** fsens, int nfwd, int* iw, double* w){
+    int nx = offset_.size()-1;
+    for(int d=-1; d<nfwd; ++d){
+      evaluateRaw(d<0 ? arg : fseed+d, d<0 ? res : fsens+d*nx, iw, w);
+    }
+  }
+
+  void Vertsplit::evaluateAdjRaw(const double** arg, double** aseed, double** asens, int nadj, int* iw, double* w){
+    int nx = offset_.size()-1;
+    const vector<int>& x_rowind = dep().sparsity().rowind();
+    for(int d=0; d<nadj; ++d){
+      for(int i=0; i<nx; ++i){
+        double* aseed_i = aseed[d*nx+i];
+        if(aseed_i!=0){
+          double* asens_ptr = asens[d] + x_rowind[offset_[i]];
+          int n = x_rowind[offset_[i+1]] - x_rowind[offset_[i]];
+          for(int k=0; k<n; ++k){
+            asens_ptr[k] += aseed_i[k];
+            aseed_i[k] = 0;
+          }
+        }
+      }
+    }
+  }
+
   void Vertsplit::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
     evaluateGen<SX,SXMatrixPtrV,SXMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
   }
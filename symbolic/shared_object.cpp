@@ -65,6 +65,27 @@ void SharedObject::assignNodeNoCount(SharedObjectNode* node_){
   node = node_;
 }
 
+bool SharedObject::assignNodeIfAlive(SharedObjectNode* node_){
+  // Increase the counter of the new node, unless it has already reached zero
+#ifdef WITH_THREADS
+  unsigned int c = node_->count;
+  while(true){
+    if(c==0) return false;
+    unsigned int c_prev = __sync_val_compare_and_swap(&node_->count,c,c+1);
+    if(c_prev==c) break;
+    c = c_prev;
+  }
+#else // WITH_THREADS
+  if(node_->count==0) return false;
+  node_->count++;
+#endif // WITH_THREADS
+
+  // Release the old node (after the increase, in case they are the same)
+  count_down();
+  node = node_;
+  return true;
+}
+
 SharedObject& SharedObject::operator=(const SharedObject& ref){
   // quick return if the old and new pointers point to the same object
   if(node == ref.node) return *this;
@@ -91,11 +112,20 @@ bool SharedObject::isNull() const{
 }
 
 void SharedObject::count_up(){
+#ifdef WITH_THREADS
+  // Atomic, so that objects can be shared between the threads of a ThreadPool
+  if(node) __sync_add_and_fetch(&node->count,1);
+#else // WITH_THREADS
   if(node) node->count++;  
+#endif // WITH_THREADS
 }
 
 void SharedObject::count_down(){
+#ifdef WITH_THREADS
+  if(node && __sync_sub_and_fetch(&node->count,1) == 0){
+#else // WITH_THREADS
   if(node && --node->count == 0){
+#endif // WITH_THREADS
     delete node;
     node = 0;
   }  
@@ -94,6 +94,12 @@ namespace CasADi{
     
     /// Assign the node to a node class pointer without reference counting: inproper use will cause memory leaks!
     void assignNodeNoCount(SharedObjectNode* node);
+
+    /** \brief Assign the node only if its reference count has not yet dropped to zero
+     * Used for looking up nodes through non-owning references (e.g. the sparsity cache) that may be in the process of being destroyed by another thread.
+     * Returns false and leaves the object untouched if the node is dying.
+     */
+    bool assignNodeIfAlive(SharedObjectNode* node);
     
     /// Get a const pointer to the node
     const SharedObjectNode* get() const;
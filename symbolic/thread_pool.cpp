@@ -0,0 +1,439 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "thread_pool.hpp"
+#include "casadi_exception.hpp"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#ifdef WITH_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif // WITH_THREADS
+#ifndef _WIN32
+#include <sys/time.h>
+#else // _WIN32
+#include <ctime>
+#endif // _WIN32
+
+using namespace std;
+
+namespace CasADi{
+
+  namespace{
+    /// Wall clock time in seconds
+    double wallTime(){
+#ifndef _WIN32
+      timeval t;
+      gettimeofday(&t,0);
+      return t.tv_sec + 1e-6*t.tv_usec;
+#else // _WIN32
+      return clock()/double(CLOCKS_PER_SEC);
+#endif // _WIN32
+    }
+  } // namespace
+
+  class ThreadPoolInternal{
+  public:
+    ThreadPoolInternal(int num_threads);
+    ~ThreadPoolInternal();
+
+    /// Distribute the tasks over the queues
+    void distribute(int ntask, const vector<double>& cost);
+
+    /// Execute tasks until all queues are empty
+    void work(int thread);
+
+    /// Get the next task for a thread, -1 if none
+    int nextTask(int thread);
+
+    /// Execute a task, recording the first error
+    void execute(ThreadPool::Job& job, int task, int thread);
+
+    /// Mark the pool as running, returns false if it already is
+    bool enter();
+
+    /// Mark the pool as idle
+    void leave();
+
+    /// Number of threads
+    int n_;
+
+    /// Current job
+    ThreadPool::Job* job_;
+
+    /// Task queues, one per thread
+    vector<deque<int> > queue_;
+
+    /// Statistics
+    vector<double> task_time_;
+    vector<int> task_thread_;
+    int num_stolen_;
+
+    /// First error message
+    string error_;
+
+    /// Is a run active?
+    bool running_;
+
+#ifdef WITH_THREADS
+    /// Entry point of the worker threads
+    static void* workerMain(void* arg);
+
+    /// Argument passed to a worker thread
+    struct WorkerArg{
+      ThreadPoolInternal* pool;
+      int thread;
+    };
+
+    /// Worker threads (the calling thread is thread 0)
+    vector<pthread_t> threads_;
+    vector<WorkerArg> worker_arg_;
+
+    /// Mutex protecting the shared state and the queues
+    pthread_mutex_t mutex_;
+    vector<pthread_mutex_t> queue_mutex_;
+
+    /// Signal the start of a new job and the completion of all workers
+    pthread_cond_t start_cond_, done_cond_;
+
+    /// Number of the current job, number of workers still busy, shutting down?
+    int generation_, active_;
+    bool shutdown_;
+
+    /// Process that created the workers, the workers do not exist in a forked child process
+    pid_t pid_;
+#endif // WITH_THREADS
+  };
+
+  ThreadPoolInternal::ThreadPoolInternal(int num_threads) : n_(num_threads), job_(0), num_stolen_(0), running_(false){
+#ifndef WITH_THREADS
+    n_ = 1;
+#endif // WITH_THREADS
+    queue_.resize(n_);
+#ifdef WITH_THREADS
+    generation_ = 0;
+    active_ = 0;
+    shutdown_ = false;
+    pid_ = getpid();
+    pthread_mutex_init(&mutex_,0);
+    queue_mutex_.resize(n_);
+    for(int t=0; t<n_; ++t) pthread_mutex_init(&queue_mutex_[t],0);
+    pthread_cond_init(&start_cond_,0);
+    pthread_cond_init(&done_cond_,0);
+
+    // Start the workers
+    threads_.resize(n_);
+    worker_arg_.resize(n_);
+    for(int t=1; t<n_; ++t){
+      worker_arg_[t].pool = this;
+      worker_arg_[t].thread = t;
+      int flag = pthread_create(&threads_[t],0,workerMain,&worker_arg_[t]);
+      casadi_assert_message(flag==0, "ThreadPool: failed to create thread " << t);
+    }
+#endif // WITH_THREADS
+  }
+
+  ThreadPoolInternal::~ThreadPoolInternal(){
+#ifdef WITH_THREADS
+    // Workers only exist in the creating process
+    if(getpid()!=pid_) return;
+
+    // Stop the workers
+    pthread_mutex_lock(&mutex_);
+    shutdown_ = true;
+    pthread_cond_broadcast(&start_cond_);
+    pthread_mutex_unlock(&mutex_);
+    for(int t=1; t<n_; ++t) pthread_join(threads_[t],0);
+
+    pthread_cond_destroy(&start_cond_);
+    pthread_cond_destroy(&done_cond_);
+    for(int t=0; t<n_; ++t) pthread_mutex_destroy(&queue_mutex_[t]);
+    pthread_mutex_destroy(&mutex_);
+#endif // WITH_THREADS
+  }
+
+#ifdef WITH_THREADS
+  void* ThreadPoolInternal::workerMain(void* arg){
+    WorkerArg* a = static_cast<WorkerArg*>(arg);
+    ThreadPoolInternal* p = a->pool;
+    int seen = 0;
+    while(true){
+      // Wait for a new job
+      pthread_mutex_lock(&p->mutex_);
+      while(p->generation_==seen && !p->shutdown_){
+        pthread_cond_wait(&p->start_cond_,&p->mutex_);
+      }
+      if(p->shutdown_){
+        pthread_mutex_unlock(&p->mutex_);
+        return 0;
+      }
+      seen = p->generation_;
+      pthread_mutex_unlock(&p->mutex_);
+
+      // Work until there is nothing left
+      p->work(a->thread);
+
+      // Report completion
+      pthread_mutex_lock(&p->mutex_);
+      if(--p->active_==0) pthread_cond_signal(&p->done_cond_);
+      pthread_mutex_unlock(&p->mutex_);
+    }
+  }
+#endif // WITH_THREADS
+
+  void ThreadPoolInternal::distribute(int ntask, const vector<double>& cost){
+    // Most expensive tasks first
+    vector<pair<double,int> > order(ntask);
+    for(int k=0; k<ntask; ++k){
+      order[k].first = k<cost.size() ? -cost[k] : 0;
+      order[k].second = k;
+    }
+    stable_sort(order.begin(),order.end());
+
+    // Assign each task to the thread with the least estimated load so far
+    vector<double> load(n_,0);
+    for(int t=0; t<n_; ++t) queue_[t].clear();
+    for(int k=0; k<ntask; ++k){
+      int t = min_element(load.begin(),load.end()) - load.begin();
+      queue_[t].push_back(order[k].second);
+      // Unknown costs count as one, resulting in a round-robin distribution
+      load[t] += order[k].first<0 ? -order[k].first : 1;
+    }
+  }
+
+  int ThreadPoolInternal::nextTask(int thread){
+#ifdef WITH_THREADS
+    // Take from the front of the own queue
+    pthread_mutex_lock(&queue_mutex_[thread]);
+    int task = -1;
+    if(!queue_[thread].empty()){
+      task = queue_[thread].front();
+      queue_[thread].pop_front();
+    }
+    pthread_mutex_unlock(&queue_mutex_[thread]);
+    if(task>=0) return task;
+
+    // Steal from the back of the longest queue
+    while(true){
+      int victim = -1;
+      size_t longest = 0;
+      for(int t=0; t<n_; ++t){
+        if(t==thread) continue;
+        pthread_mutex_lock(&queue_mutex_[t]);
+        size_t len = queue_[t].size();
+        pthread_mutex_unlock(&queue_mutex_[t]);
+        if(len>longest){
+          longest = len;
+          victim = t;
+        }
+      }
+      if(victim<0) return -1;
+      pthread_mutex_lock(&queue_mutex_[victim]);
+      if(!queue_[victim].empty()){
+        task = queue_[victim].back();
+        queue_[victim].pop_back();
+      }
+      pthread_mutex_unlock(&queue_mutex_[victim]);
+      if(task>=0){
+        pthread_mutex_lock(&mutex_);
+        num_stolen_++;
+        pthread_mutex_unlock(&mutex_);
+        return task;
+      }
+    }
+#else // WITH_THREADS
+    if(queue_[thread].empty()) return -1;
+    int task = queue_[thread].front();
+    queue_[thread].pop_front();
+    return task;
+#endif // WITH_THREADS
+  }
+
+  void ThreadPoolInternal::execute(ThreadPool::Job& job, int task, int thread){
+    string error;
+    try{
+      job.execute(task,thread);
+    } catch(exception& e){
+      error = e.what();
+    } catch(...){
+      error = "unknown exception";
+    }
+    if(error.empty()) return;
+#ifdef WITH_THREADS
+    pthread_mutex_lock(&mutex_);
+#endif // WITH_THREADS
+    if(error_.empty()) error_ = error;
+#ifdef WITH_THREADS
+    pthread_mutex_unlock(&mutex_);
+#endif // WITH_THREADS
+  }
+
+  void ThreadPoolInternal::work(int thread){
+    int task;
+    while((task=nextTask(thread))>=0){
+      double t0 = wallTime();
+      execute(*job_,task,thread);
+      task_time_[task] = wallTime()-t0;
+      task_thread_[task] = thread;
+    }
+  }
+
+  bool ThreadPoolInternal::enter(){
+#ifdef WITH_THREADS
+    pthread_mutex_lock(&mutex_);
+#endif // WITH_THREADS
+    bool was_running = running_;
+    running_ = true;
+#ifdef WITH_THREADS
+    pthread_mutex_unlock(&mutex_);
+#endif // WITH_THREADS
+    return !was_running;
+  }
+
+  void ThreadPoolInternal::leave(){
+#ifdef WITH_THREADS
+    pthread_mutex_lock(&mutex_);
+#endif // WITH_THREADS
+    running_ = false;
+#ifdef WITH_THREADS
+    pthread_mutex_unlock(&mutex_);
+#endif // WITH_THREADS
+  }
+
+  ThreadPool::ThreadPool(int num_threads){
+    if(num_threads<=0) num_threads = numProcessors();
+    internal_ = new ThreadPoolInternal(num_threads);
+  }
+
+  ThreadPool::~ThreadPool(){
+    delete internal_;
+  }
+
+  int ThreadPool::size() const{
+    return internal_->n_;
+  }
+
+  void ThreadPool::run(Job& job, int ntask, const std::vector<double>& cost){
+    ThreadPoolInternal* p = internal_;
+
+    // A run started while another one is active, e.g. from one of its tasks, would wait for workers
+    // that are busy with the active run: execute all tasks in the calling thread instead
+    if(!p->enter()){
+      string error;
+      for(int task=0; task<ntask; ++task){
+        try{
+          job.execute(task,0);
+        } catch(exception& e){
+          if(error.empty()) error = e.what();
+        } catch(...){
+          if(error.empty()) error = "unknown exception";
+        }
+      }
+      casadi_assert_message(error.empty(), "ThreadPool::run: a task failed: " << error);
+      return;
+    }
+
+    p->job_ = &job;
+    p->task_time_.assign(ntask,0);
+    p->task_thread_.assign(ntask,-1);
+    p->num_stolen_ = 0;
+    p->error_.clear();
+    p->distribute(ntask,cost);
+
+#ifdef WITH_THREADS
+    // In a forked child process, the calling thread steals all the work
+    bool has_workers = getpid()==p->pid_;
+
+    // Wake up the workers
+    if(has_workers){
+      pthread_mutex_lock(&p->mutex_);
+      p->active_ = p->n_-1;
+      p->generation_++;
+      pthread_cond_broadcast(&p->start_cond_);
+      pthread_mutex_unlock(&p->mutex_);
+    }
+#endif // WITH_THREADS
+
+    // Take part in the work
+    p->work(0);
+
+#ifdef WITH_THREADS
+    // Wait for the workers to finish
+    if(has_workers){
+      pthread_mutex_lock(&p->mutex_);
+      while(p->active_>0){
+        pthread_cond_wait(&p->done_cond_,&p->mutex_);
+      }
+      pthread_mutex_unlock(&p->mutex_);
+    }
+#endif // WITH_THREADS
+    p->job_ = 0;
+    p->leave();
+
+    casadi_assert_message(p->error_.empty(), "ThreadPool::run: a task failed: " << p->error_);
+  }
+
+  const std::vector<double>& ThreadPool::taskTime() const{
+    return internal_->task_time_;
+  }
+
+  const std::vector<int>& ThreadPool::taskThread() const{
+    return internal_->task_thread_;
+  }
+
+  int ThreadPool::numStolen() const{
+    return internal_->num_stolen_;
+  }
+
+  int ThreadPool::numProcessors(){
+#ifdef WITH_THREADS
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n>0 ? n : 1;
+#else // WITH_THREADS
+    return 1;
+#endif // WITH_THREADS
+  }
+
+  namespace{
+    /// Pools returned by ThreadPool::shared, by number of threads
+    map<int,ThreadPool*> shared_pools;
+#ifdef WITH_THREADS
+    pthread_mutex_t shared_pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif // WITH_THREADS
+  } // namespace
+
+  ThreadPool& ThreadPool::shared(int num_threads){
+    if(num_threads<=0) num_threads = numProcessors();
+#ifdef WITH_THREADS
+    pthread_mutex_lock(&shared_pools_mutex);
+#endif // WITH_THREADS
+    ThreadPool*& pool = shared_pools[num_threads];
+    if(pool==0) pool = new ThreadPool(num_threads);
+#ifdef WITH_THREADS
+    pthread_mutex_unlock(&shared_pools_mutex);
+#endif // WITH_THREADS
+    return *pool;
+  }
+
+} // namespace CasADi
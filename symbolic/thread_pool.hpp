@@ -0,0 +1,106 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+
+namespace CasADi{
+
+  // Forward declaration of the internal class
+  class ThreadPoolInternal;
+
+  /** \brief Pool of persistent worker threads executing a set of independent tasks
+  *
+  * The tasks of a run are distributed over the threads according to their estimated cost,
+  * largest first, and idle threads steal work from the busiest queue. The calling thread
+  * takes part in the work. If CasADi was compiled without thread support (option WITH_THREADS),
+  * all tasks are executed by the calling thread. The same holds in a child process created by fork,
+  * where the worker threads do not exist.
+  *
+  * A run that is started while another run of the same pool is active, from one of its tasks or
+  * from another thread, executes all its tasks in the calling thread.
+  */
+  class ThreadPool{
+  public:
+    
+    /** \brief Work to be carried out in parallel */
+    class Job{
+    public:
+      virtual ~Job(){}
+      
+      /** \brief Execute a task, called concurrently for different tasks */
+      virtual void execute(int task) = 0;
+
+      /** \brief Execute a task on a given thread (0 is the calling thread), by default calls execute(task)
+      * Overload to use data that is private to each thread of the pool.
+      */
+      virtual void execute(int task, int thread){ execute(task);}
+    };
+
+    /** \brief Create a pool with a number of threads (including the calling thread), 0 means one per processor */
+    explicit ThreadPool(int num_threads=0);
+
+    /** \brief Destructor, stops the worker threads */
+    ~ThreadPool();
+
+    /** \brief Number of threads (including the calling thread) */
+    int size() const;
+
+    /** \brief Execute all tasks of a job and wait for them to finish
+    * The estimated cost of the tasks (optional) is used for the initial distribution.
+    * An exception thrown by a task, of any type, is rethrown as a CasadiException
+    * with its message after all tasks have finished.
+    */
+    void run(Job& job, int ntask, const std::vector<double>& cost=std::vector<double>());
+
+    /** \brief Wall time in seconds spent for each task in the last run */
+    const std::vector<double>& taskTime() const;
+
+    /** \brief The thread that executed each task in the last run */
+    const std::vector<int>& taskThread() const;
+
+    /** \brief Number of tasks stolen from the queue of another thread in the last run */
+    int numStolen() const;
+
+    /** \brief Number of processors available */
+    static int numProcessors();
+
+    /** \brief A pool shared by all users in the process, one for each number of threads (0 means one per processor)
+    * Created on first use and never destroyed. Runs on it from different threads do not wait for each
+    * other, the later ones execute in the calling thread.
+    */
+    static ThreadPool& shared(int num_threads=0);
+
+  private:
+    /// Not copyable
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+    
+    /// Internal data
+    ThreadPoolInternal* internal_;
+  };
+  
+} // namespace CasADi
+
+#endif // THREAD_POOL_HPP
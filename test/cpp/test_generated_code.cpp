@@ -0,0 +1,293 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ *  Compiles generated C code and checks the reentrant entry points "work_size", "evaluateWork" and
+ *  "evaluateBatch" with work vectors supplied by the caller, as well as ExternalFunction, against
+ *  evaluate. Includes an MXFunction calling SymbolicQR, whose factorization is kept in the work vector
+ *  between calls, with the matrix changing and repeated. Also checks "evaluateVectorized" of an SXFunction
+ *  with the option "codegen_simd_width" against evaluate, and that the compiler vectorizes it.
+ *  Exits with an error on any mismatch.
+ */
+
+#include "symbolic/casadi.hpp"
+#include "symbolic/fx/symbolic_qr.hpp"
+#include "symbolic/fx/external_function.hpp"
+#include <dlfcn.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+using namespace CasADi;
+using namespace std;
+
+typedef int (*workSizePtr)(int *sz_iw, int *sz_w);
+typedef int (*evaluateWorkPtr)(const double** x, double** r, int* iw, double* w);
+typedef int (*evaluateBatchPtr)(int n, const double** x, double** r, int* iw, double* w);
+typedef int (*workSizeVectorizedPtr)(int *sz_w);
+typedef int (*evaluateVectorizedPtr)(int n, const double** x, double** r, double* w);
+
+/// Generated code, compiled and loaded
+struct Compiled{
+  string c_name, so_name;
+  void* handle;
+  workSizePtr work_size;
+  evaluateWorkPtr evaluateWork;
+  evaluateBatchPtr evaluateBatch;
+};
+
+/// Generate code for a function, compile it to a shared library and load it
+Compiled compile(FX& f, const string& name, const string& flags="-O2"){
+  Compiled c;
+  c.c_name = name + ".c";
+  c.so_name = "./" + name + ".so";
+  f.generateCode(c.c_name);
+  string cmd = "gcc -fPIC -shared " + flags + " " + c.c_name + " -o " + c.so_name + " -lm";
+  int flag = system(cmd.c_str());
+  casadi_assert_message(flag==0, "Compilation failed: " << cmd);
+  c.handle = dlopen(c.so_name.c_str(), RTLD_LAZY);
+  casadi_assert_message(c.handle!=0, "Cannot load " << c.so_name << ": " << dlerror());
+  c.work_size = (workSizePtr)dlsym(c.handle,"work_size");
+  c.evaluateWork = (evaluateWorkPtr)dlsym(c.handle,"evaluateWork");
+  c.evaluateBatch = (evaluateBatchPtr)dlsym(c.handle,"evaluateBatch");
+  casadi_assert_message(c.work_size!=0 && c.evaluateWork!=0 && c.evaluateBatch!=0, "Entry points missing in " << c.so_name);
+  return c;
+}
+
+/// Unload a compiled function and remove the generated files
+void cleanup(Compiled& c){
+  dlclose(c.handle);
+  remove(c.c_name.c_str());
+  remove(c.so_name.c_str());
+}
+
+/// Value of nonzero el of input i at point k, the first input only changes every "repeat" points if positive
+double inputValue(int k, int i, int el, int repeat=0){
+  if(repeat>0 && i==0) k -= k % repeat;
+  return sin(0.3*k + 0.7*i + 1.1*el) + 0.1*k + (i==0 && el%4==0 ? 3 : 0);
+}
+
+/// Maximum deviation between the outputs of f (after evaluate) and r
+double deviation(FX& f, const vector<const double*>& r){
+  double err = 0;
+  for(int i=0; i<f.getNumOutputs(); ++i){
+    for(int el=0; el<f.output(i).size(); ++el){
+      err = max(err,fabs(r[i][el]-f.output(i).at(el)));
+    }
+  }
+  return err;
+}
+
+/// Compare evaluateWork, evaluateBatch and ExternalFunction at npoints points with evaluate
+void check(FX& f, const string& name, int npoints, int repeat){
+  Compiled c = compile(f,name);
+
+  // Work vectors, zero before the first call
+  int sz_iw, sz_w;
+  casadi_assert(c.work_size(&sz_iw,&sz_w)==0);
+  vector<int> iw(sz_iw,0);
+  vector<double> w(sz_w,0);
+
+  // Inputs and outputs of all points, point j of argument i starting at x[i]+j*nnz(i)
+  vector<vector<double> > x(f.getNumInputs()), r(f.getNumOutputs());
+  for(int i=0; i<x.size(); ++i){
+    x[i].resize(f.input(i).size()*npoints);
+    for(int k=0; k<npoints; ++k){
+      for(int el=0; el<f.input(i).size(); ++el) x[i][k*f.input(i).size()+el] = inputValue(k,i,el,repeat);
+    }
+  }
+  for(int i=0; i<r.size(); ++i) r[i].resize(f.output(i).size()*npoints);
+
+  // Pointers to point k
+  vector<const double*> arg(x.size());
+  vector<double*> res(r.size());
+  vector<const double*> cres(r.size());
+
+  // Evaluate point by point, sharing the work vectors
+  double err_work = 0;
+  for(int k=0; k<npoints; ++k){
+    for(int i=0; i<x.size(); ++i) arg[i] = getPtr(x[i]) + k*f.input(i).size();
+    for(int i=0; i<r.size(); ++i) res[i] = getPtr(r[i]) + k*f.output(i).size();
+    casadi_assert(c.evaluateWork(getPtr(arg),getPtr(res),getPtr(iw),getPtr(w))==0);
+    for(int i=0; i<x.size(); ++i) f.setInput(arg[i],i);
+    f.evaluate();
+    for(int i=0; i<r.size(); ++i) cres[i] = res[i];
+    err_work = max(err_work,deviation(f,cres));
+  }
+  cout << name << ", evaluateWork: max deviation " << err_work << endl;
+  casadi_assert_message(err_work<1e-10, "evaluateWork and evaluate differ");
+
+  // Evaluate all points at once, with a fresh work vector
+  vector<vector<double> > r_batch(r.size());
+  for(int i=0; i<r.size(); ++i){
+    r_batch[i].resize(r[i].size(),-1234.);
+    res[i] = getPtr(r_batch[i]);
+  }
+  for(int i=0; i<x.size(); ++i) arg[i] = getPtr(x[i]);
+  w.assign(sz_w,0);
+  casadi_assert(c.evaluateBatch(npoints,getPtr(arg),getPtr(res),getPtr(iw),getPtr(w))==0);
+  double err_batch = 0;
+  for(int i=0; i<r.size(); ++i){
+    for(int el=0; el<r[i].size(); ++el) err_batch = max(err_batch,fabs(r_batch[i][el]-r[i][el]));
+  }
+  cout << name << ", evaluateBatch: max deviation " << err_batch << endl;
+  casadi_assert_message(err_batch<1e-10, "evaluateBatch and evaluateWork differ");
+
+  // Load as an ExternalFunction
+  ExternalFunction e(c.so_name);
+  e.init();
+  double err_ext = 0;
+  for(int k=0; k<npoints; ++k){
+    for(int i=0; i<x.size(); ++i) e.setInput(getPtr(x[i]) + k*f.input(i).size(),i);
+    e.evaluate();
+    for(int i=0; i<r.size(); ++i) cres[i] = getPtr(r[i]) + k*f.output(i).size();
+    err_ext = max(err_ext,deviation(e,cres));
+  }
+  cout << name << ", ExternalFunction: max deviation " << err_ext << endl;
+  casadi_assert_message(err_ext<1e-10, "ExternalFunction and evaluate differ");
+
+  cleanup(c);
+}
+
+/// Compare evaluateVectorized at npoints points with evaluate, the function has the option "codegen_simd_width" set
+void checkVectorized(FX& f, const string& name, int npoints){
+  // Compile with optimization reports for vectorized loops
+  string log_name = name + ".log";
+  Compiled c = compile(f,name,"-O3 -fopt-info-vec-optimized 2>" + log_name);
+  workSizeVectorizedPtr work_size_vectorized = (workSizeVectorizedPtr)dlsym(c.handle,"work_size_vectorized");
+  evaluateVectorizedPtr evaluateVectorized = (evaluateVectorizedPtr)dlsym(c.handle,"evaluateVectorized");
+  casadi_assert_message(work_size_vectorized!=0 && evaluateVectorized!=0, "Vectorized entry points missing in " << c.so_name);
+
+  // Count the vectorized loops
+  ifstream log(log_name.c_str());
+  string line;
+  int n_vectorized = 0;
+  while(getline(log,line)){
+    if(line.find("loop vectorized")!=string::npos) n_vectorized++;
+  }
+  log.close();
+  remove(log_name.c_str());
+  cout << name << ": " << n_vectorized << " loops vectorized" << endl;
+  casadi_assert_message(n_vectorized>0, "No loop of evaluateVectorized was vectorized");
+
+  // Work vector, not aligned
+  int sz_w;
+  casadi_assert(work_size_vectorized(&sz_w)==0);
+  vector<double> w(sz_w+1);
+
+  // Inputs and outputs, nonzero k of argument i at point j stored at x[i][k*n+j]
+  vector<vector<double> > x(f.getNumInputs()), r(f.getNumOutputs());
+  vector<const double*> arg(x.size());
+  vector<double*> res(r.size());
+  for(int i=0; i<x.size(); ++i){
+    x[i].resize(f.input(i).size()*npoints);
+    for(int el=0; el<f.input(i).size(); ++el){
+      for(int k=0; k<npoints; ++k) x[i][el*npoints+k] = inputValue(k,i,el);
+    }
+    arg[i] = getPtr(x[i]);
+  }
+  for(int i=0; i<r.size(); ++i){
+    r[i].resize(f.output(i).size()*npoints,-1234.);
+    res[i] = getPtr(r[i]);
+  }
+  casadi_assert(evaluateVectorized(npoints,getPtr(arg),getPtr(res),getPtr(w)+1)==0);
+
+  // Compare with evaluate at each point
+  double err = 0;
+  for(int k=0; k<npoints; ++k){
+    for(int i=0; i<x.size(); ++i){
+      for(int el=0; el<f.input(i).size(); ++el) f.input(i).at(el) = x[i][el*npoints+k];
+    }
+    f.evaluate();
+    for(int i=0; i<r.size(); ++i){
+      for(int el=0; el<f.output(i).size(); ++el) err = max(err,fabs(r[i][el*npoints+k]-f.output(i).at(el)));
+    }
+  }
+  cout << name << ", evaluateVectorized: max deviation " << err << endl;
+  casadi_assert_message(err<1e-10, "evaluateVectorized and evaluate differ");
+
+  cleanup(c);
+}
+
+int main(){
+  // An SXFunction with a dense and a sparse input
+  SXMatrix x = ssym("x",3);
+  SXMatrix p = ssym("p",sp_diag(2));
+  vector<SXMatrix> f_in;
+  f_in.push_back(x);
+  f_in.push_back(p);
+  vector<SXMatrix> f_out;
+  f_out.push_back(sin(x)*x[0] + exp(SXMatrix(x[2]))/(1+x[1]*x[1]));
+  f_out.push_back(mul(p,x(range(2))));
+  SXFunction f(f_in,f_out);
+  f.init();
+  check(f,"test_generated_code_sx",7,0);
+
+  // The same function with vectorized entry points, for lane counts with and without aligned blocks
+  // and a number of points that is not a multiple of either
+  f_out.push_back(SXMatrix(2.5));
+  f_out.push_back(sqrt(1+x*x) - x[1]*x/(2+x[0]*x[0]));
+  const int simd_width[] = {4,8};
+  for(int k=0; k<2; ++k){
+    SXFunction f_vec(f_in,f_out);
+    f_vec.setOption("codegen_simd_width",simd_width[k]);
+    f_vec.init();
+    stringstream ss;
+    ss << "test_generated_code_vectorized_" << simd_width[k];
+    checkVectorized(f_vec,ss.str(),3*8+5);
+  }
+
+  // An MXFunction calling the SXFunction and two SymbolicQR solvers, the second one on a modified matrix
+  SymbolicQR qr(sp_dense(3,3));
+  qr.init();
+  MX A = msym("A",sp_dense(3,3));
+  MX b = msym("b",1,3);
+  vector<MX> qr_in(LINSOL_NUM_IN);
+  qr_in[LINSOL_A] = A;
+  qr_in[LINSOL_B] = b;
+  qr_in[LINSOL_T] = 0;
+  MX x1 = qr.call(qr_in).front();
+  qr_in[LINSOL_A] = A + 2*MX::eye(3);
+  qr_in[LINSOL_B] = x1;
+  MX x2 = qr.call(qr_in).front();
+  vector<MX> f_arg;
+  f_arg.push_back(trans(x2));
+  f_arg.push_back(MX::ones(sp_diag(2)));
+  MX y = f.call(f_arg).front();
+  vector<MX> g_in;
+  g_in.push_back(A);
+  g_in.push_back(b);
+  vector<MX> g_out;
+  g_out.push_back(x1);
+  g_out.push_back(x2);
+  g_out.push_back(y);
+  MXFunction g(g_in,g_out);
+  g.init();
+
+  // The matrix changes at every point, then every third point
+  check(g,"test_generated_code_mx",7,0);
+  check(g,"test_generated_code_mx_repeated",11,3);
+
+  return 0;
+}
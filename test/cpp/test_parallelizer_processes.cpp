@@ -0,0 +1,77 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ *  Checks that a Parallelizer in the "processes" mode (and its deprecated alias "mpi") evaluates the
+ *  current state of the functions: the scale factor of a CFunction, passed as user data, changes
+ *  between evaluations without reinitializing the Parallelizer. Exits with an error on any mismatch.
+ */
+
+#include "symbolic/casadi.hpp"
+#include "symbolic/fx/c_function.hpp"
+#include "symbolic/fx/parallelizer.hpp"
+#include <cmath>
+
+using namespace CasADi;
+using namespace std;
+
+/// Scale the input by the factor pointed to by the user data
+void scaleInput(CFunction& f, int nfdir, int nadir, void* user_data){
+  double scale = *static_cast<double*>(user_data);
+  for(int el=0; el<f.input().size(); ++el){
+    f.output().at(el) = scale*f.input().at(el);
+  }
+}
+
+int main(){
+  // Scale factor, changed between the evaluations
+  double scale = 2;
+
+  vector<CRSSparsity> sp(1,sp_dense(3,1));
+  CFunction f(scaleInput,sp,sp);
+  f.setOption("user_data",static_cast<void*>(&scale));
+  f.init();
+
+  const char* modes[] = {"processes","mpi"};
+  for(int m=0; m<2; ++m){
+    vector<FX> funcs(3,f);
+    Parallelizer p(funcs);
+    p.setOption("parallelization",modes[m]);
+    p.setOption("num_processes",2);
+    p.init();
+
+    for(scale=2; scale<5; scale+=1){
+      for(int i=0; i<p.getNumInputs(); ++i){
+        for(int el=0; el<3; ++el) p.input(i).at(el) = i + 0.5*el;
+      }
+      p.evaluate();
+      double err = 0;
+      for(int i=0; i<p.getNumOutputs(); ++i){
+        for(int el=0; el<3; ++el) err = max(err,fabs(p.output(i).at(el) - scale*(i + 0.5*el)));
+      }
+      cout << modes[m] << ", scale " << scale << ": max deviation " << err << endl;
+      casadi_assert_message(err<1e-12, "The Parallelizer evaluated an outdated copy of the functions");
+    }
+  }
+
+  return 0;
+}
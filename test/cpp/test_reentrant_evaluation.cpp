@@ -0,0 +1,141 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** 
+ *  Checks evaluateRaw with caller-owned work arrays against evaluate, for an SXFunction,
+ *  an MXFunction and an ExternalFunction from generated code, calling each function
+ *  concurrently from the threads of a ThreadPool. Exits with an error on any mismatch.
+ */
+
+#include "symbolic/casadi.hpp"
+#include "symbolic/thread_pool.hpp"
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+using namespace CasADi;
+using namespace std;
+
+/// Number of evaluation points, each evaluated by a separate task
+const int NPOINTS = 64;
+
+/// Value of input i at point k
+double inputValue(int k, int i, int el){
+  return sin(0.3*k + 0.7*i + 1.1*el);
+}
+
+/// Evaluate a function at all points with evaluateRaw, each task with its own arrays
+class RawJob : public ThreadPool::Job{
+public:
+  explicit RawJob(FX& f) : f_(f), res_(NPOINTS){}
+  virtual void execute(int k){
+    int sz_arg, sz_res, sz_iw, sz_w;
+    f_.workSize(sz_arg,sz_res,sz_iw,sz_w);
+    vector<const double*> arg(sz_arg,0);
+    vector<double*> res(sz_res,0);
+    vector<int> iw(sz_iw);
+    vector<double> w(sz_w);
+
+    // Inputs
+    vector<vector<double> > x(f_.getNumInputs());
+    for(int i=0; i<x.size(); ++i){
+      x[i].resize(f_.input(i).size());
+      for(int el=0; el<x[i].size(); ++el) x[i][el] = inputValue(k,i,el);
+      arg[i] = getPtr(x[i]);
+    }
+
+    // Outputs
+    vector<vector<double> >& r = res_[k];
+    r.resize(f_.getNumOutputs());
+    for(int i=0; i<r.size(); ++i){
+      r[i].resize(f_.output(i).size());
+      res[i] = getPtr(r[i]);
+    }
+    
+    f_.evaluateRaw(getPtr(arg),getPtr(res),getPtr(iw),getPtr(w));
+  }
+  
+  /// The function shared by all tasks
+  FX& f_;
+
+  /// Results for each point
+  vector<vector<vector<double> > > res_;
+};
+
+/// Compare concurrent evaluateRaw with serial evaluate
+void check(FX f, const string& name){
+  casadi_assert_message(f.isReentrant(), name << " is not reentrant");
+  
+  // Evaluate concurrently, four threads sharing the function
+  RawJob job(f);
+  ThreadPool pool(4);
+  pool.run(job,NPOINTS);
+  
+  // Compare with evaluate
+  double err = 0;
+  for(int k=0; k<NPOINTS; ++k){
+    for(int i=0; i<f.getNumInputs(); ++i){
+      for(int el=0; el<f.input(i).size(); ++el) f.input(i).at(el) = inputValue(k,i,el);
+    }
+    f.evaluate();
+    for(int i=0; i<f.getNumOutputs(); ++i){
+      for(int el=0; el<f.output(i).size(); ++el){
+        err = max(err,fabs(job.res_[k][i][el]-f.output(i).at(el)));
+      }
+    }
+  }
+  cout << name << ": max deviation " << err << endl;
+  casadi_assert_message(err<1e-12, name << ": evaluateRaw and evaluate differ");
+}
+
+int main(){
+  // SXFunction
+  SXMatrix x = ssym("x",3);
+  SXFunction f(x,sin(x)*x[0] + exp(SXMatrix(x[2])));
+  f.init();
+  check(f,"SXFunction");
+  
+  // MXFunction calling the SXFunction
+  MX X = msym("X",3);
+  MX A = msym("A",3,3);
+  vector<MX> F_in;
+  F_in.push_back(X);
+  F_in.push_back(A);
+  vector<MX> F_out;
+  F_out.push_back(mul(A,X) + f.call(X).at(0));
+  F_out.push_back(trans(X)*X[1]);
+  MXFunction F(F_in,F_out);
+  F.init();
+  check(F,"MXFunction");
+  
+  // ExternalFunction from generated code
+  f.generateCode("reentrant_evaluation_f.c");
+  int flag = system("gcc -fPIC -shared -O1 reentrant_evaluation_f.c -o reentrant_evaluation_f.so");
+  casadi_assert_message(flag==0, "Compilation of the generated code failed");
+  ExternalFunction e("./reentrant_evaluation_f.so");
+  e.init();
+  check(e,"ExternalFunction");
+  remove("reentrant_evaluation_f.c");
+  remove("reentrant_evaluation_f.so");
+  
+  return 0;
+}
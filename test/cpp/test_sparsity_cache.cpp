@@ -0,0 +1,115 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ *  Checks the statistics of the sparsity pattern cache (cacheSize, cacheHits, cacheMisses), that
+ *  modifying a pattern never changes other references to a cached pattern, and the same from the
+ *  threads of a ThreadPool creating, copying and modifying patterns concurrently.
+ *  Exits with an error on any mismatch.
+ */
+
+#include "symbolic/matrix/crs_sparsity.hpp"
+#include "symbolic/thread_pool.hpp"
+#include <iostream>
+
+using namespace CasADi;
+using namespace std;
+
+/// Number of distinct patterns used by the threads, few so that they are shared heavily
+const int NPATTERN = 4;
+
+/// A 7-by-(5+k) pattern with a nonzero at (i,(i*k)%5) in each row i
+CRSSparsity pattern(int k){
+  vector<int> col(7), rowind(8);
+  for(int i=0; i<7; ++i){
+    col[i] = (i*k)%5;
+    rowind[i+1] = i+1;
+  }
+  return CRSSparsity(7,5+k,col,rowind);
+}
+
+/// Is sp equal to pattern(k)?
+bool isPattern(const CRSSparsity& sp, int k){
+  CRSSparsity ref = pattern(k);
+  return sp.isEqual(ref.size1(),ref.size2(),ref.col(),ref.rowind());
+}
+
+/// Each task creates, copies and modifies patterns, checking that no other reference is changed
+class StressJob : public ThreadPool::Job{
+public:
+  StressJob() : failed_(false){}
+  virtual void execute(int task){
+    for(int rep=0; rep<2000; ++rep){
+      int k = (task+rep)%NPATTERN;
+      CRSSparsity a = pattern(k);
+      CRSSparsity b = a;
+      CRSSparsity c = pattern(k);
+
+      // Add a nonzero outside the original pattern to one of the copies
+      b.getNZ(6,4+k);
+      if(!isPattern(a,k) || !isPattern(c,k) || b.size()!=8) failed_ = true;
+
+      // Modify the last reference to a pattern that other tasks may hold as well
+      c.getNZ(0,4+k);
+      if(!isPattern(a,k) || c.size()!=8) failed_ = true;
+    }
+  }
+  bool failed_;
+};
+
+int main(){
+  // Statistics
+  CRSSparsity::clearCache();
+  casadi_assert_message(CRSSparsity::cacheSize()==0 && CRSSparsity::cacheHits()==0 && CRSSparsity::cacheMisses()==0, "clearCache did not reset the cache");
+  CRSSparsity a = pattern(1);
+  casadi_assert_message(CRSSparsity::cacheSize()==1 && CRSSparsity::cacheMisses()==1 && CRSSparsity::cacheHits()==0, "A new pattern was not added to the cache");
+  CRSSparsity b = pattern(1);
+  casadi_assert_message(CRSSparsity::cacheSize()==1 && CRSSparsity::cacheMisses()==1 && CRSSparsity::cacheHits()==1, "An existing pattern was not found in the cache");
+  casadi_assert_message(a.get()==b.get(), "Equal patterns are not shared");
+  cout << "cache statistics: ok" << endl;
+
+  // Modifying a shared cached pattern makes an uncached copy
+  b.getNZ(6,4);
+  casadi_assert_message(isPattern(a,1) && b.size()==8, "Modifying a pattern changed another reference");
+  casadi_assert_message(CRSSparsity::cacheSize()==1, "The cached pattern was evicted while still shared");
+
+  // Modifying the only reference evicts it from the cache
+  a.getNZ(6,4);
+  casadi_assert_message(CRSSparsity::cacheSize()==0, "A modified pattern was left in the cache");
+  CRSSparsity c = pattern(1);
+  casadi_assert_message(isPattern(c,1) && CRSSparsity::cacheMisses()==2, "A modified pattern was found in the cache");
+
+  // Released patterns leave the cache
+  c = CRSSparsity();
+  casadi_assert_message(CRSSparsity::cacheSize()==0, "A released pattern was left in the cache");
+  cout << "modification and release: ok" << endl;
+
+  // Concurrent use
+  ThreadPool pool(8);
+  StressJob job;
+  pool.run(job,64);
+  casadi_assert_message(!job.failed_, "A cached pattern was changed by the modification of another reference");
+  casadi_assert_message(CRSSparsity::cacheSize()==0, "Released patterns were left in the cache");
+  cout << "concurrent creation, copying and modification: ok, " << CRSSparsity::cacheHits() << " hits, " << CRSSparsity::cacheMisses() << " misses" << endl;
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/**
+ *  Checks the Jacobian sparsity detected with wide bitsets ("sparsity_bitset_width") on one or more
+ *  threads ("sparsity_num_threads") against the default propagation, for general Jacobians and for
+ *  symmetric ones (Hessians), where the seeds are compressed by a star coloring.
+ *  Exits with an error on any mismatch.
+ */
+
+#include "symbolic/casadi.hpp"
+#include <cstdlib>
+
+using namespace CasADi;
+using namespace std;
+
+/// A scalar function of n variables coupling random pairs (random) or neighbours at distance 3 (banded)
+SXMatrix objective(const SXMatrix& x, bool random){
+  int n = x.size();
+  vector<SX> xv = x.data();
+  SXMatrix f = 0;
+  srand(n);
+  for(int k=0; k+3<n; ++k){
+    int i = random ? rand()%n : k;
+    int j = random ? rand()%n : k+3;
+    f += sin(xv[i]*xv[j]);
+  }
+  return f;
+}
+
+/// Compare the wide propagation of the Jacobian of g with respect to x with the default propagation
+void check(const SXMatrix& x, const SXMatrix& g, bool symmetric, const string& name){
+  SXFunction f_ref(x,g);
+  f_ref.init();
+  CRSSparsity sp_ref = f_ref.jacSparsity();
+  
+  for(int width=128; width<=512; width*=4){
+    for(int num_threads=1; num_threads<=4; num_threads*=4){
+      SXFunction f(x,g);
+      f.setOption("sparsity_bitset_width",width);
+      f.setOption("sparsity_num_threads",num_threads);
+      f.init();
+      CRSSparsity sp = f.jacSparsity(0,0,false,symmetric);
+      cout << name << (symmetric ? ", symmetric" : "") << ", width " << width << ", " << num_threads << " threads: " << sp.size() << " nonzeros" << endl;
+      casadi_assert_message(sp==sp_ref, "The wide sparsity propagation gave a different pattern");
+    }
+  }
+}
+
+int main(){
+  for(int random=0; random<2; ++random){
+    string name = random ? "random" : "banded";
+    SXMatrix x = ssym("x",2000);
+    SXMatrix f = objective(x,random);
+    SXMatrix g = gradient(f,x);
+    
+    // A general Jacobian
+    check(x,g*g[0],false,name);
+    
+    // A Hessian, both with and without exploiting the symmetry
+    check(x,g,false,name);
+    check(x,g,true,name);
+  }
+  return 0;
+}
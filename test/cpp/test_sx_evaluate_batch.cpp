@@ -0,0 +1,116 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** 
+ *  Checks SXFunction::evaluateBatch against evaluate at each point, with distinct inputs per
+ *  point, a number of points that is not a multiple of the block size, null (zero) inputs
+ *  and skipped outputs. Exits with an error on any mismatch.
+ */
+
+#include "symbolic/casadi.hpp"
+#include <cmath>
+
+using namespace CasADi;
+using namespace std;
+
+/// Number of points, two full blocks of 64 and a partial one
+const int NPOINTS = 2*64 + 37;
+
+/// Value of nonzero el of input i at point k
+double inputValue(int k, int i, int el){
+  return sin(0.3*k + 0.7*i + 1.1*el) + 0.1*k;
+}
+
+/// Evaluate in batch with a subset of the inputs and outputs and compare with evaluate
+double check(SXFunction& f, const vector<bool>& use_input, const vector<bool>& use_output){
+  // Inputs, structure-of-arrays
+  vector<vector<double> > x(f.getNumInputs());
+  vector<const double*> arg(f.getNumInputs(),0);
+  for(int i=0; i<x.size(); ++i){
+    if(!use_input[i]) continue;
+    x[i].resize(f.input(i).size()*NPOINTS);
+    for(int el=0; el<f.input(i).size(); ++el){
+      for(int k=0; k<NPOINTS; ++k) x[i][el*NPOINTS+k] = inputValue(k,i,el);
+    }
+    arg[i] = getPtr(x[i]);
+  }
+  
+  // Outputs, filled with a marker so that entries that are not written show up as deviations
+  vector<vector<double> > r(f.getNumOutputs());
+  vector<double*> res(f.getNumOutputs(),0);
+  for(int i=0; i<r.size(); ++i){
+    if(!use_output[i]) continue;
+    r[i].resize(f.output(i).size()*NPOINTS,-1234.);
+    res[i] = getPtr(r[i]);
+  }
+  f.evaluateBatch(NPOINTS,arg,res);
+  
+  // Compare with evaluate at each point
+  double err = 0;
+  for(int k=0; k<NPOINTS; ++k){
+    for(int i=0; i<f.getNumInputs(); ++i){
+      for(int el=0; el<f.input(i).size(); ++el) f.input(i).at(el) = use_input[i] ? inputValue(k,i,el) : 0;
+    }
+    f.evaluate();
+    for(int i=0; i<f.getNumOutputs(); ++i){
+      if(!use_output[i]) continue;
+      for(int el=0; el<f.output(i).size(); ++el){
+        err = max(err,fabs(r[i][el*NPOINTS+k]-f.output(i).at(el)));
+      }
+    }
+  }
+  return err;
+}
+
+int main(){
+  // Inputs: a dense vector and a sparse (diagonal) matrix
+  SXMatrix x = ssym("x",3);
+  SXMatrix p = ssym("p",sp_diag(2));
+  
+  // Outputs: a mix of operations, a constant and an output only depending on p
+  vector<SXMatrix> f_out;
+  f_out.push_back(sin(x)*x[0] + exp(SXMatrix(x[2]))/(1+x[1]*x[1]));
+  f_out.push_back(mul(p,x(range(2))) + sqrt(1+x(range(1,3))*x(range(1,3))));
+  f_out.push_back(SXMatrix(2.5));
+  f_out.push_back(cos(p)*p);
+  vector<SXMatrix> f_in;
+  f_in.push_back(x);
+  f_in.push_back(p);
+  SXFunction f(f_in,f_out);
+  f.init();
+  
+  // All inputs and outputs
+  vector<bool> all_in(f.getNumInputs(),true), all_out(f.getNumOutputs(),true);
+  double err = check(f,all_in,all_out);
+  cout << "all inputs and outputs: max deviation " << err << endl;
+  casadi_assert_message(err<1e-12, "evaluateBatch and evaluate differ");
+  
+  // Null input pointer (treated as zero) and skipped outputs
+  vector<bool> some_in = all_in, some_out = all_out;
+  some_in[1] = false;
+  some_out[0] = some_out[2] = false;
+  err = check(f,some_in,some_out);
+  cout << "null input and skipped outputs: max deviation " << err << endl;
+  casadi_assert_message(err<1e-12, "evaluateBatch and evaluate differ");
+  
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ *  Checks ThreadPool::run: all tasks executed exactly once, runs started from within a task of the
+ *  same pool, and exceptions of any type thrown by tasks. Exits with an error on any mismatch.
+ */
+
+#include "symbolic/thread_pool.hpp"
+#include "symbolic/casadi_exception.hpp"
+#include <iostream>
+#include <vector>
+
+using namespace CasADi;
+using namespace std;
+
+/// Counts the executions of each task
+class CountJob : public ThreadPool::Job{
+public:
+  CountJob(vector<int>& count) : count_(count){}
+  virtual void execute(int task){ count_[task]++;}
+  vector<int>& count_;
+};
+
+/// Each task runs a CountJob on the same pool
+class NestedJob : public ThreadPool::Job{
+public:
+  NestedJob(ThreadPool& pool, int nouter, int ninner) : pool_(pool), count_(nouter,vector<int>(ninner,0)){}
+  virtual void execute(int task){
+    CountJob inner(count_[task]);
+    pool_.run(inner,count_[task].size());
+  }
+  ThreadPool& pool_;
+  vector<vector<int> > count_;
+};
+
+/// Throws from some of the tasks, a std::exception or an int
+class ThrowJob : public ThreadPool::Job{
+public:
+  ThrowJob(int ntask, bool std_exception) : count_(ntask,0), std_exception_(std_exception){}
+  virtual void execute(int task){
+    count_[task]++;
+    if(task%5==2){
+      if(std_exception_) throw CasadiException("task failed");
+      throw task;
+    }
+  }
+  vector<int> count_;
+  bool std_exception_;
+};
+
+/// Do all entries equal one?
+bool allOnce(const vector<int>& count){
+  for(int k=0; k<count.size(); ++k){
+    if(count[k]!=1) return false;
+  }
+  return true;
+}
+
+/// Run a job that throws, check that run throws and that all tasks were executed
+void checkThrow(ThreadPool& pool, bool std_exception){
+  ThrowJob job(23,std_exception);
+  bool thrown = false;
+  try{
+    pool.run(job,job.count_.size());
+  } catch(CasadiException& e){
+    thrown = true;
+  }
+  cout << (std_exception ? "std::exception" : "int") << " thrown by a task: " << (thrown ? "rethrown" : "not rethrown") << endl;
+  casadi_assert_message(thrown, "ThreadPool::run did not rethrow an exception thrown by a task");
+  casadi_assert_message(allOnce(job.count_), "ThreadPool::run did not execute all tasks exactly once");
+}
+
+int main(){
+  ThreadPool pool(4);
+
+  // A plain run
+  vector<int> count(100,0);
+  CountJob job(count);
+  pool.run(job,count.size());
+  casadi_assert_message(allOnce(count), "ThreadPool::run did not execute all tasks exactly once");
+
+  // Runs on the same pool from within the tasks, repeated to catch a deadlock with high probability
+  for(int rep=0; rep<20; ++rep){
+    NestedJob nested(pool,13,17);
+    pool.run(nested,nested.count_.size());
+    for(int k=0; k<nested.count_.size(); ++k){
+      casadi_assert_message(allOnce(nested.count_[k]), "A nested ThreadPool::run did not execute all tasks exactly once");
+    }
+  }
+  cout << "nested runs: ok" << endl;
+
+  // Exceptions, the pool must remain usable afterwards
+  checkThrow(pool,true);
+  checkThrow(pool,false);
+  count.assign(count.size(),0);
+  pool.run(job,count.size());
+  casadi_assert_message(allOnce(count), "ThreadPool::run did not execute all tasks exactly once after a failed run");
+
+  return 0;
+}
@@ -436,6 +436,63 @@ class ADtests(casadiTestCase):
             f.init()
             J = self.jacobians[inputtype][outputtype](*n)
             self.checkarray(DMatrix(f.jacSparsity(),1),array(J!=0,int),"jacsparsity")
+
+  def test_jacsparsity_wide(self):
+    self.message("jacsparsity on SX with wide bitsets")
+    x = ssym("x",300)
+    y = ssym("y",7)
+    v = list(x)
+    f = SXMatrix.zeros(500,1)
+    for i in range(500):
+      e = v[(37*i) % len(v)]*v[(11*i+5) % len(v)]+y[i%7]
+      v.append(e)
+      if i%3: f[i] = e
+    for iind in range(2):
+      r=SXFunction([x,y],[f])
+      r.init()
+      ref = r.jacSparsity(iind,0)
+      for mode in ["forward","reverse"]:
+        for width in [256,512,192]:
+          for num_threads in [1,3]:
+            g=SXFunction([x,y],[f])
+            g.setOption("ad_mode",mode)
+            g.setOption("sparsity_bitset_width",width)
+            g.setOption("sparsity_num_threads",num_threads)
+            g.init()
+            self.checkarray(DMatrix(g.jacSparsity(iind,0),1),DMatrix(ref,1),"jacsparsity wide %s %d %d" % (mode,width,num_threads))
+              
+  def test_jacsparsity_cache(self):
+    self.message("on-disk sparsity cache")
+    import tempfile, shutil, os
+    cache_dir = tempfile.mkdtemp()
+    try:
+      x = ssym("x",50)
+      f = vertcat([sin(x[i])*x[(7*i)%50] for i in range(50)])
+      Jref = None
+      for run in range(3):
+        if run==2:
+          # Seed matrices that do not fit the Jacobian must be ignored
+          for fname in os.listdir(cache_dir):
+            if fname.startswith("partition_"):
+              f_stale = open(os.path.join(cache_dir,fname),"w")
+              f_stale.write("casadi_sparsity 2\n1 3 1\n0 1\n0\n-1 -1 -1\n")
+              f_stale.close()
+        CasadiOptions.setSparsityCacheDir(cache_dir)
+        F=SXFunction([x],[f])
+        F.init()
+        J=F.jacobian()
+        J.init()
+        J.setInput(range(50))
+        J.evaluate()
+        CasadiOptions.setSparsityCacheDir("")
+        if run==0:
+          self.assertTrue(len(os.listdir(cache_dir))>0)
+          Jref = J.getOutput()
+        else:
+          self.checkarray(J.getOutput(),Jref,"cached sparsity")
+    finally:
+      CasadiOptions.setSparsityCacheDir("")
+      shutil.rmtree(cache_dir)
               
   def test_JacobianMX(self):
     n=array([1.2,2.3,7,4.6])
@@ -74,7 +74,7 @@ class FXtests(casadiTestCase):
     #! Evaluate this function ten times in parallel
     p = Parallelizer([f]*2)
     
-    for mode in ["openmp","serial"]:
+    for mode in ["openmp","serial","threads","processes"]:
       p.setOption("parallelization",mode)
       p.init()
       
@@ -157,7 +157,7 @@ class FXtests(casadiTestCase):
     
     #! Evaluate this function ten times in parallel
     pp = Parallelizer([f]*2)
-    for mode in ["serial","openmp"]:
+    for mode in ["serial","openmp","threads","processes"]:
       pp.setOption("parallelization",mode)
       pp.init()
       
@@ -523,6 +523,27 @@ class FXtests(casadiTestCase):
     self.checkarray(ar,DMatrix([3,4]))
     self.checkarray(br,DMatrix([3,4]))
     self.checkarray(cr,DMatrix([3,4]))
+
+  def test_isReentrant(self):
+    self.message("isReentrant")
+    # evaluateRaw itself is not wrapped, see test/cpp/test_reentrant_evaluation.cpp for the numerical check
+    x = ssym("x",3,1)
+    f = SXFunction([x],[sin(x)*x[0]])
+    f.init()
+    self.assertTrue(f.isReentrant())
+    
+    X = msym("X",3,1)
+    A = msym("A",3,3)
+    F = MXFunction([X,A],[mul(A,X)+f.call([X])[0],X.T])
+    F.init()
+    self.assertTrue(F.isReentrant())
+    
+    # The linear solver of the solve node has state
+    S = CSparse(A.sparsity())
+    S.init()
+    G = MXFunction([X,A],[S.solve(A,X,False)])
+    G.init()
+    self.assertFalse(G.isReentrant())
     
 if __name__ == '__main__':
     unittest.main()
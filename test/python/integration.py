@@ -48,6 +48,7 @@ except:
   pass
 
 integrators.append((CollocationIntegrator,["dae","ode"],{"implicit_solver":KinsolSolver,"number_of_finite_elements": 18,"startup_integrator":CVodesIntegrator}))
+integrators.append((CollocationIntegrator,["dae","ode"],{"implicit_solver":KinsolSolver,"number_of_finite_elements": 18,"startup_integrator":CVodesIntegrator,"element_wise": True}))
 #integrators.append((CollocationIntegrator,["dae","ode"],{"implicit_solver":NLPImplicitSolver,"number_of_finite_elements": 100,"startup_integrator":CVodesIntegrator,"implicit_solver_options": {"nlp_solver": IpoptSolver,"linear_solver_creator": CSparse}}))
 #integrators.append((RKIntegrator,["ode"],{"number_of_finite_elements": 1000}))
 
@@ -1313,6 +1314,97 @@ class Integrationtests(casadiTestCase):
     integrator.setFwdSeed([1],0)
     integrator.evaluate(1,0) # fail
     
+  def test_mx_dae_adjoint(self):
+    self.message("adjoint derivative of an integrator with an MX DAE and no backward problem")
+    t=msym("t")
+    x=msym("x",2)
+    p=msym("p")
+    x0 = x[0]
+    x1 = x[1]
+    f=MXFunction(daeIn(t=t,x=x,p=p),daeOut(ode=vertcat([x1,-p*sin(x0)]),quad=x0*x0))
+    f.init()
+    fsx=SXFunction(f)
+    fsx.init()
+    ders = []
+    for dae in [f,fsx]:
+      integrator = CVodesIntegrator(dae)
+      integrator.setOption({"tf": 2.3,"abstol": 1e-12,"reltol": 1e-12})
+      integrator.init()
+      d = integrator.derivative(0,1)
+      d.setInput([1.1,0.3],INTEGRATOR_X0)
+      d.setInput(0.7,INTEGRATOR_P)
+      d.setInput([1.2,0.7],INTEGRATOR_NUM_IN+INTEGRATOR_XF)
+      d.setInput(0.4,INTEGRATOR_NUM_IN+INTEGRATOR_QF)
+      d.evaluate()
+      ders.append(d)
+    for i in [INTEGRATOR_X0,INTEGRATOR_P]:
+      self.checkarray(ders[0].output(INTEGRATOR_NUM_OUT+i),ders[1].output(INTEGRATOR_NUM_OUT+i),"adj %d" % i,digits=7)
+
+  def test_explicitRK(self):
+    self.message("explicit Runge-Kutta integrator: states, quadratures and sensitivities")
+    t=ssym("t")
+    x=ssym("x",2)
+    p=ssym("p")
+    f=SXFunction(daeIn(t=t,x=x,p=p),daeOut(ode=vertcat([x[1],-p*sin(x[0])]),quad=x[0]**2))
+    f.init()
+    
+    ref = CVodesIntegrator(f)
+    ref.setOption({"abstol": 1e-12,"reltol": 1e-12,"tf": 2.3})
+    ref.init()
+    
+    for method, opts in [("dopri5",{"abstol": 1e-10,"reltol": 1e-10}),("rk4",{"number_of_finite_elements": 1000})]:
+      for nchk in [0,3,1000]:
+        integrator = ExplicitRKIntegrator(f)
+        integrator.setOption("method",method)
+        integrator.setOption("tf",2.3)
+        integrator.setOption("number_of_checkpoints",nchk)
+        integrator.setOption(opts)
+        integrator.init()
+        for intg in [integrator,ref]:
+          intg.setInput([1.1,0.3],"x0")
+          intg.setInput(0.7,"p")
+          intg.setFwdSeed([0.3,-0.2],"x0")
+          intg.setFwdSeed(1.5,"p")
+          intg.setAdjSeed([1.2,0.7],"xf")
+          intg.setAdjSeed(0.4,"qf")
+          intg.evaluate(1,1)
+        for i in ["xf","qf"]:
+          self.checkarray(integrator.output(i),ref.output(i),"%s %s" % (method,i),digits=7)
+          self.checkarray(integrator.fwdSens(i),ref.fwdSens(i),"%s fwd %s" % (method,i),digits=7)
+        for i in ["x0","p"]:
+          self.checkarray(integrator.adjSens(i),ref.adjSens(i),"%s adj %s" % (method,i),digits=7)
+          
+    self.message("explicit Runge-Kutta integrator: dense output")
+    integrator = ExplicitRKIntegrator(f)
+    integrator.setOption({"tf": 2.3,"abstol": 1e-10,"reltol": 1e-10})
+    integrator.init()
+    for intg in [integrator,ref]:
+      intg.setInput([1.1,0.3],"x0")
+      intg.setInput(0.7,"p")
+      intg.reset()
+    for tout in [0.5,1.1,2.3]:
+      integrator.integrate(tout)
+      ref.integrate(tout)
+      self.checkarray(integrator.output("xf"),ref.output("xf"),"dense output at %g" % tout,digits=7)
+
+    self.message("explicit Runge-Kutta integrator: derivative in adjoint mode")
+    integrator = ExplicitRKIntegrator(f)
+    integrator.setOption({"tf": 2.3,"abstol": 1e-10,"reltol": 1e-10})
+    integrator.init()
+    ders = []
+    for intg in [integrator,ref]:
+      d = intg.derivative(0,1)
+      d.setInput([1.1,0.3],INTEGRATOR_X0)
+      d.setInput(0.7,INTEGRATOR_P)
+      d.setInput([1.2,0.7],INTEGRATOR_NUM_IN+INTEGRATOR_XF)
+      d.setInput(0.4,INTEGRATOR_NUM_IN+INTEGRATOR_QF)
+      d.evaluate()
+      ders.append(d)
+    for i in [INTEGRATOR_XF,INTEGRATOR_QF]:
+      self.checkarray(ders[0].output(i),ders[1].output(i),"derivative output %d" % i,digits=7)
+    for i in [INTEGRATOR_X0,INTEGRATOR_P]:
+      self.checkarray(ders[0].output(INTEGRATOR_NUM_OUT+i),ders[1].output(INTEGRATOR_NUM_OUT+i),"derivative adj %d" % i,digits=7)
+
   def test_collocationPoints(self):
     self.message("collocation points")
     with self.assertRaises(Exception):
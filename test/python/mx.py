@@ -2036,6 +2036,111 @@ class MXtests(casadiTestCase):
     
   def test_iter(self):
     self.assertEqual(len(list(msym("x",2))),2)
-    
+
+  def test_evaluate_directions(self):
+    self.message("MXFunction evaluation with multiple directions, repeated")
+    A = msym("A",sp_tril(3))
+    x = msym("x",3)
+    s = msym("s")
+    y = mul(A,x) + mul(A.T,x)*s
+    y[1] += x[2]
+    z = vertcat([sin(y[0:2])*sqrt(inner_prod(x,x)),inner_prod(x,y)/(s+3)])
+    r = reshape(mul(A,A.T),1,9)
+
+    f = MXFunction([A,x,s],[z,r])
+    f.setOption("number_of_fwd_dir",2)
+    f.setOption("number_of_adj_dir",2)
+    f.init()
+    fsx = f.expand()
+    fsx.setOption("number_of_fwd_dir",2)
+    fsx.setOption("number_of_adj_dir",2)
+    fsx.init()
+
+    for k in range(3):
+      for ff in [f,fsx]:
+        ff.setInput(DMatrix(sp_tril(3),range(k,k+6)),0)
+        ff.setInput([1,k,3],1)
+        ff.setInput(0.3*k,2)
+        for d in range(2):
+          ff.setFwdSeed(DMatrix(sp_tril(3),range(d,d+6)),0,d)
+          ff.setFwdSeed([d,1,-1],1,d)
+          ff.setFwdSeed(d+k,2,d)
+          ff.setAdjSeed([1,d,k],0,d)
+          ff.setAdjSeed(range(d,d+9),1,d)
+        ff.evaluate(2,2)
+      for i in range(2):
+        self.checkarray(f.getOutput(i),fsx.getOutput(i),"output %d" % i)
+      for d in range(2):
+        for i in range(2):
+          self.checkarray(f.getFwdSens(i,d),fsx.getFwdSens(i,d),"fwd %d %d" % (i,d))
+        for i in range(3):
+          self.checkarray(f.getAdjSens(i,d),fsx.getAdjSens(i,d),"adj %d %d" % (i,d))
+
+  def test_live_variables_shapes(self):
+    self.message("MXFunction with live variables of different shapes sharing memory")
+    x = msym("x",3)
+    p = msym("p")
+    y = x
+    acc = 0
+    dims = [3,5,2,4,1,3]
+    for k in range(1,len(dims)):
+      A = DMatrix([[0.1*((i*7+j+k)%5)-0.2 for j in range(dims[k-1])] for i in range(dims[k])])
+      z = mul(A,y)
+      y = sin(z)*p + z
+      acc = acc + inner_prod(y,y)
+    y = cos(y)*x + x*p
+
+    for live in [True,False]:
+      f = MXFunction([x,p],[y,acc])
+      f.setOption("live_variables",live)
+      f.setOption("number_of_fwd_dir",1)
+      f.setOption("number_of_adj_dir",1)
+      f.init()
+      fsx = f.expand()
+      fsx.setOption("number_of_fwd_dir",1)
+      fsx.setOption("number_of_adj_dir",1)
+      fsx.init()
+      for ff in [f,fsx]:
+        ff.setInput([0.3,-0.2,1.1],0)
+        ff.setInput(0.7,1)
+        ff.setFwdSeed([1,2,3],0)
+        ff.setFwdSeed(-0.5,1)
+        ff.setAdjSeed([0.5,-1,2],0)
+        ff.setAdjSeed(1.5,1)
+        ff.evaluate(1,1)
+      for i in range(2):
+        self.checkarray(f.getOutput(i),fsx.getOutput(i),"output %d" % i)
+        self.checkarray(f.getFwdSens(i),fsx.getFwdSens(i),"fwd %d" % i)
+        self.checkarray(f.getAdjSens(i),fsx.getAdjSens(i),"adj %d" % i)
+
+  def test_append_empty(self):
+    self.message("append with null and empty matrices")
+    x = msym("x",0,1)
+    x.append(MX())
+    self.assertFalse(x.isNull())
+    self.assertTrue(x.isSymbolic())
+    x.append(msym("y",0,1))
+    self.assertTrue(x.isSymbolic())
+    
+    z = MX()
+    z.append(msym("z",2,1))
+    self.assertEqual(z.shape,(2,1))
+    self.assertTrue(z.isSymbolic())
+    
+    a = msym("a",2)
+    a.append(msym("b",3))
+    self.assertEqual(a.shape,(5,1))
+    a.append(MX())
+    a.append(msym("c",0,1))
+    self.assertEqual(a.shape,(5,1))
+    
+    # An empty symbolic primitive can still be used as a function input
+    b = msym("b",5)
+    f = MXFunction([x,b],[b*2])
+    f.init()
+    f.setInput(range(5),1)
+    f.evaluate()
+    self.checkarray(f.getOutput(),DMatrix(range(0,10,2)),"append")
+
 if __name__ == '__main__':
     unittest.main()
@@ -102,7 +102,90 @@ class NLPtests(casadiTestCase):
       self.assertAlmostEqual(solver.getOutput("x")[0],1,9,str(Solver))
       self.assertAlmostEqual(solver.getOutput("lam_x")[0],0,9,str(Solver))
       self.assertAlmostEqual(solver.getOutput("lam_g")[0],0,9,str(Solver))
-      
+
+  def testfused_oracle(self):
+    x=ssym("x",2)
+    nlp=SXFunction(nlpIn(x=x),nlpOut(f=(1-x[0])**2+100*(x[1]-x[0]**2)**2,g=vertcat([x[0]+x[1],x[0]*x[1]])))
+
+    for Solver, solver_options in solvers:
+      self.message("fused oracle " + str(Solver))
+      sol = {}
+      for fused in [False, True]:
+        solver = Solver(nlp)
+        solver.setOption(solver_options)
+        for k,v in ({"tol":1e-10,"hessian_approximation":"limited-memory","max_iter":100, "MaxIter": 100,"print_level":0}).iteritems():
+          if solver.hasOption(k):
+            solver.setOption(k,v)
+        if not solver.hasOption("fused_oracle"): break
+        solver.setOption("fused_oracle",fused)
+        solver.init()
+        solver.setInput([0.5,0.5],"x0")
+        solver.setInput([-10,-10],"lbx")
+        solver.setInput([10,10],"ubx")
+        solver.setInput([-10,-10],"lbg")
+        solver.setInput([1.5,10],"ubg")
+        solver.solve()
+        sol[fused] = (solver.getOutput("x"),solver.getOutput("f"))
+        if fused:
+          self.assertTrue(solver.getStats()["fused_oracle_evaluations"]>0)
+      if len(sol)==2:
+        self.checkarray(sol[True][0],sol[False][0],digits=7)
+        self.checkarray(sol[True][1],sol[False][1],digits=7)
+
+  def testlbfgs_compact(self):
+    x=ssym("x",3)
+    nlp=SXFunction(nlpIn(x=x),nlpOut(f=(1-x[0])**2+10*(x[1]-x[0]**2)**2+10*(x[2]-x[1]**2)**2,g=x[0]+x[1]))
+
+    for Solver, solver_options in solvers:
+      solver = Solver(nlp)
+      if not solver.hasOption("lbfgs_compact"): continue
+      self.message("compact L-BFGS " + str(Solver))
+      solver.setOption(solver_options)
+      solver.setOption("hessian_approximation","limited-memory")
+      solver.setOption("lbfgs_compact",True)
+      solver.setOption("lbfgs_memory",4)
+      solver.setOption("max_iter",200)
+      solver.init()
+      solver.setInput([0.5]*3,"x0")
+      solver.setInput([-10]*3,"lbx")
+      solver.setInput([10]*3,"ubx")
+      solver.setInput([-10],"lbg")
+      solver.setInput([1.5],"ubg")
+      solver.solve()
+      self.checkarray(solver.getOutput("x"),DMatrix([0.8208468,0.6791532,0.4612491]),digits=5)
+
+  def testpartitioned_bfgs(self):
+    N = 4
+    w = ssym("w",2*N+1)
+    f = 0
+    g = []
+    for k in range(N):
+      x, u = w[2*k], w[2*k+1]
+      f += x**2 + u**2 + 0.1*x**4 + 0.2*x*u
+      g.append(w[2*k+2] - (x + 0.2*(u - sin(x))))
+    nlp=SXFunction(nlpIn(x=w),nlpOut(f=f,g=vertcat(g)))
+
+    for Solver, solver_options in solvers:
+      if 'SQP' not in str(Solver): continue
+      self.message("partitioned BFGS " + str(Solver))
+      sol = {}
+      for hess in ["exact","partitioned"]:
+        solver = Solver(nlp)
+        solver.setOption(solver_options)
+        solver.setOption("hessian_approximation",hess)
+        solver.setOption("max_iter",100)
+        solver.init()
+        lbx = [-10]*(2*N+1)
+        ubx = [10]*(2*N+1)
+        lbx[0] = ubx[0] = 1
+        solver.setInput(lbx,"lbx")
+        solver.setInput(ubx,"ubx")
+        solver.setInput(0,"lbg")
+        solver.setInput(0,"ubg")
+        solver.solve()
+        sol[hess] = solver.getOutput("x")
+      self.checkarray(sol["partitioned"],sol["exact"],digits=5)
+
   def testIPOPTinf(self):
     self.message("trivial IPOPT, infinity bounds")
     x=SX("x")
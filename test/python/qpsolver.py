@@ -229,6 +229,55 @@ class QPSolverTests(casadiTestCase):
 
       self.assertAlmostEqual(solver.getOutput("cost")[0],-6.264669320767,6,str(qpsolver))
 
+  def test_sequence(self):
+    self.message("Sequence of QPs with the same matrices")
+    H = c.diag([2,1,0.2,0.7,1.3])
+
+    H[1,2]=0.1
+    H[2,1]=0.1
+    
+    A =  DMatrix([[1, 0,0.1,0.7,-1],[0.1, 2,-0.3,4,0.1]])
+    makeSparse(A)
+
+    Gs = [DMatrix([-2,-6,1,0,0]), DMatrix([-1,-6,1,0.5,0]), DMatrix([-2,-6,1,0,0])]
+    
+    options = { "mutol": 1e-12, "artol": 1e-12, "tol":1e-12}
+
+    for qpsolver, qp_options in qpsolvers:
+      self.message("sequence: " + str(qpsolver))
+      
+      def makesolver():
+        solver = qpsolver(qpStruct(h=H.sparsity(),a=A.sparsity()))
+        for key, val in options.iteritems():
+          if solver.hasOption(key):
+             solver.setOption(key,val)
+        solver.setOption(qp_options)
+        solver.init()
+        solver.setInput(H,"h")
+        solver.setInput(A,"a")
+        solver.setInput(0,"lbx")
+        solver.setInput(inf,"ubx")
+        solver.setInput(-inf,"lba")
+        solver.setInput(2,"uba")
+        return solver
+
+      solver = makesolver()
+      for G in Gs:
+        solver.setInput(G,"g")
+        solver.solve()
+
+        ref = makesolver()
+        ref.setInput(G,"g")
+        ref.solve()
+        
+        self.checkarray(solver.getOutput(),ref.getOutput(),str(qpsolver),digits=6)
+        self.checkarray(solver.getOutput("lam_a"),ref.getOutput("lam_a"),str(qpsolver),digits=6)
+
+      if solver.hasOption("hotstart"):
+        self.assertEqual(solver.getStats()["num_cold_starts"],1)
+        self.assertEqual(solver.getStats()["num_hot_starts"],2)
+        self.assertEqual(solver.getStats()["num_matrix_updates"],0)
+
   def test_general_nonconvex_dense(self):
     self.message("Non convex dense QP with solvers: " + str([qpsolver for qpsolver,options in qpsolvers]))
     H = DMatrix([[1,-1],[-1,-2]])
@@ -406,6 +406,42 @@ class Simulatortests(casadiTestCase):
 
     self.checkarray(sim.getOutput(),num['q0']*exp(tf**3/(3*num['p'])),"Evaluation output mismatch",digits=9)
 
+  def test_controlsim_batch(self):
+    self.message("ControlSimulator: batch of scenarios")
+    tc = 0.01*DMatrix([0,8,16,24,32])
+    t=ssym("t")
+    q=ssym("q")
+    p=ssym("p")
+    u=ssym("u")
+    f=SXFunction(controldaeIn(t=t, x=q, p=p, u=u),[-p*q+u])
+    f.init()
+    out=SXFunction(controldaeIn(t=t, x=q, p=p, u=u),[q,u*t])
+    out.init()
+    sim = ControlSimulator(f,out,tc)
+    sim.setOption('nf',2)
+    sim.setOption('integrator',CVodesIntegrator)
+    sim.setOption('integrator_options', {"reltol":1e-12,"abstol":1e-12})
+    sim.setOption('batch_num_threads',3)
+    sim.setOption('gather_stats',True)
+    sim.init()
+
+    ns = 7
+    x0 = DMatrix([[1+0.1*k] for k in range(ns)])
+    p_ = DMatrix([[0.5]])
+    u_ = DMatrix([[sin(k+j) for j in range(4)] for k in range(ns)])
+    sim.evaluateBatch(x0,p_,u_)
+
+    self.assertEqual(len(sim.getStats()["batch_scenario_time"]),ns)
+
+    # Scenario k, grid point j, output element i
+    block = n.array(sim.getBatchOutput()).reshape((ns,9,2))
+    for k in range(ns):
+      sim.setInput(x0[k],"x0")
+      sim.setInput(p_,"p")
+      sim.setInput(u_[k,:].T,"u")
+      sim.evaluate()
+      self.checkarray(DMatrix(block[k,:,0]),sim.getOutput(0),"batch output")
+      self.checkarray(DMatrix(block[k,:,1]),sim.getOutput(1),"batch output")
 
   def test_simulator_time_offset(self):
     self.message("CVodes integration: simulator time offset")
@@ -424,6 +460,46 @@ class Simulatortests(casadiTestCase):
     self.assertAlmostEqual(sim.getOutput()[-1],q0*exp((tend**3-0.7**3)/(3*p)),9,"Evaluation output mismatch")
     
     
+  def test_simulator_stride_stream(self):
+    self.message("Simulator output stride and streaming to a file")
+    import tempfile, os
+    num=self.num
+    t = n.linspace(0,num['tend'],100)
+    fd, stream_file = tempfile.mkstemp(suffix=".bin")
+    os.close(fd)
+    try:
+      sims = []
+      for opts in [{},{"output_stride": 7},{"output_stride": 7,"output_file": stream_file,"output_buffer_size": 3}]:
+        sim = Simulator(self.integrator,t)
+        sim.setOption(opts)
+        sim.setOption("number_of_fwd_dir",1)
+        sim.init()
+        sim.setInput([num['q0']],0)
+        sim.setInput([num['p']],1)
+        sim.setFwdSeed([1],0)
+        sim.evaluate(1,0)
+        sims.append(sim)
+      
+      self.assertEqual(sims[1].output().shape,(15,1))
+      self.checkarray(sims[1].output(),sims[0].output()[range(0,100,7)],"output stride")
+      self.checkarray(sims[1].fwdSens(),sims[0].fwdSens()[range(0,100,7)],"output stride fwd")
+      
+      # Time, output and forward sensitivity at each stored grid point
+      data = n.fromfile(stream_file,dtype=n.float64).reshape((-1,3))
+      self.assertEqual(data.shape[0],15)
+      self.checkarray(DMatrix(data[:,0]),DMatrix(t[range(0,100,7)]),"stream time")
+      self.checkarray(DMatrix(data[:,1]),sims[1].output(),"stream output")
+      self.checkarray(DMatrix(data[:,2]),sims[1].fwdSens(),"stream fwd")
+      self.checkarray(sims[2].output(),sims[1].output()[-1],"stream last output")
+      
+      # A second evaluation truncates the file rather than appending to it
+      sims[2].evaluate(1,0)
+      data = n.fromfile(stream_file,dtype=n.float64).reshape((-1,3))
+      self.assertEqual(data.shape[0],15)
+      self.checkarray(DMatrix(data[:,1]),sims[1].output(),"stream output after truncation")
+    finally:
+      os.remove(stream_file)
+    
   def test_simulator_sensitivities(self):
     self.message("Forward sensitivities")
     t = SX("t")
@@ -553,9 +629,6 @@ class Simulatortests(casadiTestCase):
       self.assertAlmostEqual(fwdSens_csim[1],fwdSens_exact[1], digits,"Forward sensitivity")
 
   def test_simulator_sensitivities_adj(self):
-    # This test is currently disabled, awaiting support for the feature
-    return
-    
     self.message("Adjoint sensitivities")
     t = SX("t")
 
@@ -636,8 +709,8 @@ class Simulatortests(casadiTestCase):
     csim.setInput(p_,"p")
     csim.setAdjSeed([0,0]*(N-1) + [1,0],0)
     csim.evaluate(0,1)
-    adjSens_X0_csim = DMatrix(sim.getAdjSens("x0"))
-    adjSens_P_csim = DMatrix(sim.getAdjSens("p"))
+    adjSens_X0_csim = DMatrix(csim.getAdjSens("x0"))
+    adjSens_P_csim = DMatrix(csim.getAdjSens("p"))
     
     sol.setAdjSeed([1,0])
     sol.evaluate(0,1)
@@ -660,6 +733,42 @@ class Simulatortests(casadiTestCase):
     self.assertAlmostEqual(adjSens_P_csim[0],adjSens_P_exact[0],digits,"Adjoint sensitivity")
     self.assertAlmostEqual(adjSens_P_csim[1],adjSens_P_exact[1],digits,"Adjoint sensitivity")
     
+  def test_simulator_adj_all_points(self):
+    self.message("Adjoint sensitivities with seeds at all output points and an output stride")
+    t=ssym("t")
+    x=ssym("x",2)
+    p=ssym("p",2)
+    f=SXFunction(daeIn(t=t,x=x,p=p),daeOut(ode=vertcat([x[1],-p[0]*x[1]-p[1]*x[0]+sin(t)])))
+    f.init()
+    h=SXFunction(daeIn(t=t,x=x,p=p),[x[0]*p[1]+t])
+    h.init()
+    integrator = CVodesIntegrator(f)
+    integrator.setOption({"abstol": 1e-12,"reltol": 1e-12,"abstolB": 1e-12,"reltolB": 1e-12,"fsens_err_con": True,"steps_per_checkpoint": 1000})
+    integrator.init()
+    grid = [0.3+0.1*k for k in range(50)]
+    for stride in [1,3]:
+      sim = Simulator(integrator,h,grid)
+      sim.setOption("output_stride",stride)
+      sim.setOption("number_of_fwd_dir",4)
+      sim.setOption("number_of_adj_dir",1)
+      sim.init()
+      sim.setInput([1.1,0.3],"x0")
+      sim.setInput([0.1,1.0],"p")
+      
+      # Forward sensitivities in the directions of the unit vectors of x0 and p
+      for d in range(4):
+        sim.setFwdSeed([1 if i==d else 0 for i in range(2)],"x0",d)
+        sim.setFwdSeed([1 if i==d-2 else 0 for i in range(2)],"p",d)
+      sim.evaluate(4,0)
+      w = DMatrix([cos(0.7*r) for r in range(sim.output().size())])
+      fwd = [sum([w[r]*sim.fwdSens(0,d)[r] for r in range(w.size())]) for d in range(4)]
+
+      # Adjoint sensitivities with nonzero seeds at all output points
+      sim.setAdjSeed(w)
+      sim.evaluate(0,1)
+      self.checkarray(sim.adjSens("x0"),DMatrix(fwd[:2]),"adj x0, stride %d" % stride,digits=7)
+      self.checkarray(sim.adjSens("p"),DMatrix(fwd[2:]),"adj p, stride %d" % stride,digits=7)
+
 if __name__ == '__main__':
     unittest.main()
 
@@ -1034,6 +1034,55 @@ class SXtests(casadiTestCase):
       self.assertTrue(isEqual(w[0],a))
       self.assertTrue(isEqual(w[1],b))
       self.assertTrue(isEqual(w[2],c))
+
+  def test_evaluation_engine(self):
+    self.message("threaded evaluation engine")
+    x = ssym("x",3)
+    e = vertcat([sin(x[0])*x[1]+sqrt(x[2]),fmax(x[0],x[2])**2,3.0,x[1]])
+    f = SXFunction([x],[e])
+    f.init()
+    g = SXFunction([x],[e])
+    g.setOption("evaluation_engine","threaded")
+    g.init()
+    for x0 in [[0.1,0.2,0.3],[-1.5,2.0,4.0]]:
+      f.setInput(x0)
+      f.evaluate()
+      g.setInput(x0)
+      g.evaluate()
+      self.checkarray(f.output(),g.output(),"threaded evaluation")
+
+  def test_just_in_time(self):
+    self.message("just-in-time compilation")
+    x = ssym("x",3)
+    e = vertcat([sin(x[0])*x[1]+sqrt(x[2]),fmax(x[0],x[2])**2,3.0,-x[1],fabs(x[0])/x[2],1/x[2]])
+    f = SXFunction([x],[e])
+    f.init()
+    g = SXFunction([x],[e])
+    g.setOption("just_in_time",True)
+    g.init()
+    for x0 in [[0.1,0.2,0.3],[-1.5,2.0,4.0]]:
+      f.setInput(x0)
+      f.evaluate()
+      g.setInput(x0)
+      g.evaluate()
+      self.checkarray(f.output(),g.output(),"just-in-time compiled evaluation")
+      
+    # Forward and adjoint sensitivities, several directions
+    for h in [f,g]:
+      h.setOption("number_of_fwd_dir",2)
+      h.setOption("number_of_adj_dir",3)
+      h.init()
+      h.setInput([-1.5,2.0,4.0])
+      for d in range(2):
+        h.setFwdSeed([0.3+d,-0.7,1.1*d],0,d)
+      for d in range(3):
+        h.setAdjSeed([1.0,-d,0.5,2.0,0.1*d,-1.0],0,d)
+      h.evaluate(2,3)
+    self.checkarray(f.output(),g.output(),"just-in-time compiled evaluation with derivatives")
+    for d in range(2):
+      self.checkarray(f.fwdSens(0,d),g.fwdSens(0,d),"just-in-time compiled forward sensitivities")
+    for d in range(3):
+      self.checkarray(f.adjSens(0,d),g.adjSens(0,d),"just-in-time compiled adjoint sensitivities")
     
 if __name__ == '__main__':
     unittest.main()